@@ -1 +1,15 @@
-gcc -g -Wall -Wextra -Wpedantic -std=gnu99 test_PUBLIC.c -o test_PUBLIC  -lfre -lpthread
+# The tests calling functions local to libfre.so (test_PUBLIC's print_ptable_hook()) are built from its sources.
+gcc -g -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -Wno-unused-variable -std=gnu99 -I. test_PUBLIC.c fre_internal_*.c fre_bind.c -o test_PUBLIC -lpthread
+gcc -g -O2 -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -Wno-unused-variable -std=gnu99 -DFRE_FILE_WINDOW=64 -I. test_DIFF.c fre_internal_*.c fre_bind.c -o test_DIFF -lpthread
+gcc -g -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -Wno-unused-variable -std=gnu99 -I. test_CACHE.c fre_internal_*.c fre_bind.c -o test_CACHE -lpthread
+gcc -g -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -Wno-unused-variable -std=gnu99 -I. test_ENGINE.c fre_internal_*.c fre_bind.c -o test_ENGINE -lpthread
+./fre-gen -o test_GEN_matchers.c g_literal 'm/abc/' g_alt 'm/ab|abc|b/' g_star 'm/a(b|c)*d/' g_anchors 'm/^ab|c$/' \
+  g_word 'm/\bab\b/' g_icase 'm/aBc/i' g_dot 'm/a.c/s' g_multi 'm/^a|b$/m' g_repeat 'm/(ab){2,3}/' g_empty 'm/x*/'
+gcc -g -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -Wno-unused-variable -std=gnu99 -I. test_GEN.c fre_internal_*.c fre_bind.c -o test_GEN -lpthread
+gcc -g -O2 -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -Wno-unused-variable -std=gnu99 -I. test_LARGE.c fre_internal_*.c fre_bind.c -o test_LARGE -lpthread
+gcc -g -O2 -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -Wno-unused-variable -std=gnu99 -DFRE_COMPACT_OFFSETS -I. test_LARGE.c fre_internal_*.c fre_bind.c -o test_LARGE_COMPACT -lpthread
+# The others link against libfre.so, as its users would, "make" builds it first.
+gcc -g -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -std=gnu99 -I. test_SUBST.c -o test_SUBST -L. -l:libfre.so.0.0.1 -Wl,-rpath,'$ORIGIN' -lpthread
+gcc -g -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -std=gnu99 -I. test_TR.c -o test_TR -L. -l:libfre.so.0.0.1 -Wl,-rpath,'$ORIGIN' -lpthread
+gcc -g -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -std=gnu99 -I. test_SET.c -o test_SET -L. -l:libfre.so.0.0.1 -Wl,-rpath,'$ORIGIN' -lpthread
+gcc -g -Wno-format -Wall -Wextra -pedantic -Wpointer-arith -Wstrict-prototypes -std=gnu99 -I. test_BIND_N.c -o test_BIND_N -L. -l:libfre.so.0.0.1 -Wl,-rpath,'$ORIGIN' -lpthread
@@ -11,11 +11,128 @@
 #ifndef FRE_PUBLIC_HEADER
 # define FRE_PUBLIC_HEADER
 
+# include <stddef.h>
+# include <stdint.h>
+
+/*
+ * Offset of a match in the caller's string. Libfre built, and its callers
+ * compiled, with FRE_COMPACT_OFFSETS keep them on 32 bits, for denser
+ * match tables, and take strings shorter than 2GiB only.
+ */
+# ifdef FRE_COMPACT_OFFSETS
+typedef int32_t fre_off;
+#  define FRE_OFF_MAX INT32_MAX
+# else
+typedef int64_t fre_off;
+#  define FRE_OFF_MAX INT64_MAX
+# endif
+
+/* Opaque handle to a parsed and compiled pattern, see fre_compile(). */
+typedef struct fpattern fre_regex;
+/* Opaque handle to a set of matching patterns, see fre_set_compile(). */
+typedef struct fre_set_tab fre_set;
+/* Opaque handle to a text fed to a matching pattern a chunk at a time, see fre_stream_new(). */
+typedef struct fre_stream_tab fre_stream;
+/* Called by fre_match_file() and streams with where each match begins and ends, a non-zero return stops the scan. */
+typedef int (*fre_match_callback)(fre_off bo, fre_off eo, void *arg);
+
+/* A line selected by fre_grep_lines(). */
+typedef struct fre_line_tab {
+  fre_off offset;                      /* Where it begins in the buffer. */
+  fre_off length;                      /* Its lenght, without the newline. */
+  size_t number;                       /* Its number, the first line is 1. */
+} fre_line;
+/* Called by fre_grep_lines_cb() with each line selected, a non-zero return stops the scan. */
+typedef int (*fre_line_callback)(const fre_line *line, void *arg);
+# define FRE_GREP_INVERT 1             /* fre_grep_lines() flag: select the lines that don't match. */
+
 /** Function prototype **/
 
+/*
+ * A pattern, m//, s/// or tr/// with its delimiters and modifiers, is at
+ * most 255 bytes, longer ones are refused with errno set to FRE_PATRNTOOLONG
+ * (212). That holds for alternations of literals too, a long list of words
+ * to look for goes to fre_set_compile(), a word per pattern, found together
+ * in one scan.
+ */
+
 int fre_bind(char *pattern,            /* The regex pattern. */
 	     char *string,             /* The string to bind the pattern against. */
 	     size_t string_size);      /* The string's size (not its lenght). */
 
+fre_regex* fre_compile(char *pattern); /* Parse and compile a pattern once, to be used with fre_exec(). */
+int fre_exec(fre_regex *handle,        /* A pattern returned by fre_compile(). */
+	     char *string,             /* The string to bind the pattern against. */
+	     size_t string_size);      /* The string's size (not its lenght). */
+void fre_free(fre_regex *handle);      /* Release a pattern returned by fre_compile(). */
+
+int fre_bind_n(char *pattern,          /* Like fre_bind(), for string_len bytes that may hold NULs. */
+	       char *string,
+	       size_t string_len,
+	       size_t string_size);    /* Room in string, for s/// and tr///. */
+int fre_exec_n(fre_regex *handle,      /* Like fre_exec(), for string_len bytes that may hold NULs. */
+	       char *string,
+	       size_t string_len,
+	       size_t string_size);    /* Room in string, for s/// and tr///. */
+
+fre_set* fre_set_compile(char **patterns,       /* Compile matching patterns to be bound together. */
+			 size_t numof_patterns);
+int fre_set_exec(fre_set *set,                  /* Which of the set's patterns match string. */
+		 char *string,
+		 size_t string_size,
+		 size_t *ids,                   /* At least as many as the set has patterns. */
+		 fre_off *offsets);             /* NULL, or twice as many, for where each match begins and ends. */
+int fre_set_exec_n(fre_set *set,                /* Like fre_set_exec(), for string_len bytes that may hold NULs. */
+		   char *string,
+		   size_t string_len,
+		   size_t *ids,
+		   fre_off *offsets);
+void fre_set_free(fre_set *set);                /* Release a set returned by fre_set_compile(). */
+
+int fre_match_file(fre_regex *handle,           /* Bind a matching pattern against a file, mapped read-only. */
+		   const char *path,
+		   fre_match_callback callback, /* Handed each match. */
+		   void *arg);                  /* Passed on to callback. */
+
+fre_stream* fre_stream_new(fre_regex *handle,           /* Bind a matching pattern against a text read a chunk at a time. */
+			   size_t window,               /* Most bytes kept for unbounded patterns, 0 for the default. */
+			   fre_match_callback callback, /* Handed each match, offsets from the stream's start. */
+			   void *arg);                  /* Passed on to callback. */
+int fre_stream_feed(fre_stream *stream,                 /* Search the next chunk of the text. */
+		    const char *buf,
+		    size_t len);
+int fre_stream_finish(fre_stream *stream);              /* The text has ended, report the matches left. */
+void fre_stream_free(fre_stream *stream);               /* Release a stream returned by fre_stream_new(). */
+
+int fre_grep_lines(fre_regex *handle,                   /* Select the lines of buf a matching pattern matches. */
+		   const char *buf,
+		   size_t len,
+		   int flags,                           /* 0 or FRE_GREP_INVERT. */
+		   fre_line *lines,                     /* Receives the first numof_lines of them, or NULL. */
+		   size_t numof_lines,
+		   size_t *numof_selected);             /* How many were selected, all of them. */
+int fre_grep_lines_cb(fre_regex *handle,                /* Like fre_grep_lines(), handing each line to callback. */
+		      const char *buf,
+		      size_t len,
+		      int flags,
+		      fre_line_callback callback,
+		      void *arg);                       /* Passed on to callback. */
+int fre_grep_count(fre_regex *handle,                   /* How many lines of buf a matching pattern matches. */
+		   const char *buf,
+		   size_t len,
+		   int flags,
+		   size_t *count);
+
+int fre_cache_set_capacity(size_t capacity);          /* Number of patterns fre_bind() keeps compiled, per thread. */
+void fre_cache_stats(size_t *hits, size_t *misses);   /* The calling thread's pattern cache counters. */
+int fre_shared_cache_set_capacity(size_t capacity);   /* Number of parsed patterns shared by all threads. */
+int fre_dfa_set_budget(size_t bytes);                 /* Bytes a pattern's DFA may use before it's flushed. */
+int fre_jit_set_enabled(int enabled);                 /* Whether patterns compiled from now on run as native code. */
+int fre_jit(fre_regex *handle, int enabled);          /* Run, or stop running, a compiled pattern as native code. */
+
+size_t fre_tr_count(void);             /* Bytes found in the search list by the calling thread's last tr///. */
+char* fre_tr_result(void);             /* The string built by the calling thread's last tr///r, or NULL. */
+size_t fre_result_len(void);           /* Lenght of the string left by the calling thread's last s/// or tr///. */
+
 void FRE_PERROR(char *funcname);       /* Library's error messages. */
 #endif /* FRE_PUBLIC_HEADER */
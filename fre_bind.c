@@ -24,92 +24,108 @@ void FRE_PERROR(char *funcname)  {
 }
 
 
-int fre_bind(char *pattern,       /* The regex pattern. */
-	     char *string,        /* The string to bind the pattern against. */
-	     size_t string_size)  /* The size of string. (NOT THE LENGHT !) */
+/*
+ * Parse the caller's pattern and compile it once.
+ * The returned fre_regex can then be bound against any number of strings
+ * with fre_exec() and must be released with fre_free().
+ * A fre_regex must not be used by more than one thread at a time, threads
+ * compiling the same pattern share its parsing through the shared pattern table.
+ */
+fre_regex* fre_compile(char *pattern)  /* The regex pattern. */
 {
-  /*
-   * Parse the pattern using the _plp_parser.
-   * Call the operation in the fre_pattern object returned by the parser.
-   */
-  size_t pattern_len = 0, string_len = 0;
-  size_t offset_to_start = 0;              /* To keep _match_op's positions in line with the original string. */
+  size_t pattern_len = 0;
   fre_pattern *freg_object = NULL;
-  int retval = 0;
 
-  if (!pattern || !string){
+  if (!pattern){
     errno = EINVAL;
-    return FRE_ERROR;
+    return NULL;
   }
   /* 
-   * Make sure both pattern and string fits the library's lenght limits.
+   * Make sure the pattern fits the library's lenght limits.
    * If no NUL byte has been found until we reached lib-limit - 1 , fail hard.
    */
   pattern_len = strnlen(pattern, FRE_MAX_PATTERN_LENGHT);
   if (pattern[pattern_len] != '\0') {
     errno = FRE_PATRNTOOLONG;
+    return NULL;
+  }
+  /* Get our own copy of the parsed pattern. */
+  if ((freg_object = intern__fre__shared_lookup(pattern)) == NULL){
+    intern__fre__errmesg("_shared_lookup");
+    return NULL;
+  }
+
+  return freg_object;
+}
+
+
+/* Execute the operation of a compiled pattern against the caller's string. */
+int fre_exec(fre_regex *handle,    /* A pattern returned by fre_compile(). */
+	     char *string,         /* The string to bind the pattern against. */
+	     size_t string_size)   /* The size of string. (NOT THE LENGHT !) */
+{
+  size_t string_len = 0;
+
+  if (!handle || !string){
+    errno = EINVAL;
     return FRE_ERROR;
   }
   string_len = strnlen(string, FRE_ARG_STRING_MAX_LENGHT);
   if (string[string_len] != '\0'){
-    pthread_mutex_lock(&fre_stderr_mutex);
-    fprintf(stderr, "Libfre takes input no longer than %d bytes (including the terminating NULL byte).\n\
-Fragment or reduce the size of your input.\n\n",
-	    FRE_ARG_STRING_MAX_LENGHT);
-    pthread_mutex_unlock(&fre_stderr_mutex);
     errno = EOVERFLOW;
     return FRE_ERROR;
   }
-  /* 
-   * If there's a pattern saved in the pmatch-table and its the
-   * same as the one our caller just passed in, use the fre_pattern
-   * object sitting in the pmatch-table and skip parsing completely.
-   */
-  if (fre_pmatch_table->ls_pattern != NULL
-      && fre_pmatch_table->ls_pattern[0] != '\0') {
-    if (strcmp(fre_pmatch_table->ls_pattern, pattern) == 0){
-      if (fre_pmatch_table->fre_saved_object == true){
-	freg_object = fre_pmatch_table->ls_object;
-	goto skip_plp_parser;
-      }
-    }
+
+  return fre_exec_n(handle, string, string_len, string_size);
+}
+
+
+/*
+ * Execute the operation of a compiled pattern against the first string_len
+ * bytes of string, which is never scanned for a terminating NUL byte and may
+ * hold some. As with regcomp(), '.' doesn't match them, even with /s, a
+ * bracket expression like [^\n] does. Substitutions need room for the new
+ * string and a NUL byte after it in string_size bytes, transliterations leave
+ * the string's lenght alone unless they delete or squeeze bytes. See
+ * fre_result_len() for the new lenght.
+ */
+int fre_exec_n(fre_regex *handle,    /* A pattern returned by fre_compile(). */
+	       char *string,         /* The string to bind the pattern against. */
+	       size_t string_len,    /* The lenght of string. */
+	       size_t string_size)   /* The size of string, for s/// and tr///. */
+{
+  fre_pattern *freg_object = handle;
+  int retval = 0;
+
+  if (!freg_object || !string){
+    errno = EINVAL;
+    return FRE_ERROR;
   }
-  /* Parse the caller's pattern. */
-  if ((freg_object = intern__fre__plp_parser(pattern)) == NULL){
-    intern__fre__errmesg("_plp_parser: Failed to parse the given pattern");
+  if (string_len >= FRE_ARG_STRING_MAX_LENGHT){
+    errno = EOVERFLOW;
     return FRE_ERROR;
   }
-  /* 
-   * Save a copy of the caller's pattern and a pointer to the fre_pattern object
-   * given by the _plp_parser in the pmatch-table, in cases where our caller is binding
-   * multiple strings against the same pattern.
-   */
-  if (SU_strcpy(fre_pmatch_table->ls_pattern, pattern, FRE_MAX_PATTERN_LENGHT) == NULL){
-    intern__fre__errmesg("SU_strcpy");
+  if (freg_object->fre_op_flag != MATCH && string_size < string_len){
+    errno = EINVAL;
     return FRE_ERROR;
   }
-  fre_pmatch_table->ls_object = freg_object;
+  /* Forget about the previous operation. */
+  intern__fre__reset_pmatch_table();
 
- skip_plp_parser:
-  /* Execute the operation. will make it more fancy later. testing for now. */
-  
   switch (freg_object->fre_op_flag){
   case MATCH :
-    retval = intern__fre__match_op(string, freg_object, &offset_to_start);
+    retval = intern__fre__match_op(string, string_len, freg_object, 0);
     break;
   case SUBSTITUTE:
-    retval = intern__fre__substitute_op(string, string_size, freg_object, &offset_to_start);
+    retval = intern__fre__substitute_op(string, string_len, string_size, freg_object, 0);
     break;
   case TRANSLITERATE:
-    retval = intern__fre__transliterate_op(string, string_size, freg_object);
+    retval = intern__fre__transliterate_op(string, string_len, freg_object);
     break;
   default:
     /* If really we made it all the way here with an invalid operation just abort everything. */
     abort();
   }
-  print_pattern_hook(freg_object); /* DEBUG ONLY */
-  intern__fre__free_pattern(freg_object);
-  freg_object = NULL;
   /* Check how the operation went. */
   if (retval == FRE_ERROR){
     errno = FRE_OPERROR;
@@ -117,3 +133,432 @@ Fragment or reduce the size of your input.\n\n",
 
   return retval;
 }
+
+
+/* Release a pattern returned by fre_compile(). */
+void fre_free(fre_regex *handle)
+{
+  intern__fre__free_pattern(handle);
+}
+
+
+/*
+ * Parse and compile matching patterns (m//) to be bound together against strings
+ * with fre_set_exec(), the returned set must be released with fre_set_free().
+ * Substitutions, transliterations and patterns with back-references are refused.
+ * A fre_set must not be used by more than one thread at a time.
+ */
+fre_set* fre_set_compile(char **patterns,       /* The regex patterns. */
+			 size_t numof_patterns) /* How many of them. */
+{
+  fre_patset *set = NULL;
+
+  if ((set = intern__fre__set_compile(patterns, numof_patterns)) == NULL)
+    intern__fre__errmesg("_set_compile");
+
+  return set;
+}
+
+
+/*
+ * Find which patterns of a set match string, in one pass over it for most patterns.
+ * ids receives their indexes in increasing order and, unless it's NULL, offsets
+ * receives where the leftmost-longest match of the Kth of them begins and ends at
+ * offsets[2*K] and offsets[2*K+1]. Returns how many patterns match.
+ * The thread's pmatch-table is left untouched.
+ */
+int fre_set_exec(fre_set *set,         /* A set returned by fre_set_compile(). */
+		 char *string,         /* The string to bind the patterns against. */
+		 size_t string_size,   /* The size of string. (NOT THE LENGHT !) */
+		 size_t *ids,          /* Room for as many indexes as the set has patterns. */
+		 fre_off *offsets)     /* NULL or room for twice as many offsets. */
+{
+  size_t string_len = 0;
+
+  if (!set || !string || !ids || string_size == 0){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  string_len = strnlen(string, ((string_size < FRE_ARG_STRING_MAX_LENGHT) ? string_size : FRE_ARG_STRING_MAX_LENGHT));
+  if (string_len == string_size || string[string_len] != '\0'){
+    errno = ((string_len == FRE_ARG_STRING_MAX_LENGHT) ? EOVERFLOW : EINVAL);
+    return FRE_ERROR;
+  }
+
+  return intern__fre__set_exec(set, string, string_len, ids, offsets);
+}
+
+
+/* Like fre_set_exec(), for the first string_len bytes of string, NUL bytes included. */
+int fre_set_exec_n(fre_set *set,         /* A set returned by fre_set_compile(). */
+		   char *string,         /* The string to bind the patterns against. */
+		   size_t string_len,    /* The lenght of string. */
+		   size_t *ids,          /* Room for as many indexes as the set has patterns. */
+		   fre_off *offsets)     /* NULL or room for twice as many offsets. */
+{
+  if (!set || !string || !ids){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  if (string_len >= FRE_ARG_STRING_MAX_LENGHT){
+    errno = EOVERFLOW;
+    return FRE_ERROR;
+  }
+
+  return intern__fre__set_exec(set, string, string_len, ids, offsets);
+}
+
+
+/* Release a set returned by fre_set_compile(). */
+void fre_set_free(fre_set *set)
+{
+  intern__fre__free_set(set);
+}
+
+
+/*
+ * Bind a matching pattern (m//) against the file at path, without reading it
+ * into memory: it's mapped read-only and searched in place, a window at a time
+ * when the pattern's matches are bounded, so that only the window stays resident.
+ * callback gets where each match begins and ends, all of them with /g, and
+ * stops the scan by returning non-zero. The thread's pmatch-table is left untouched.
+ * On FRE_ERROR errno is that of the open(), fstat() or mmap() that failed.
+ */
+int fre_match_file(fre_regex *handle,           /* A pattern returned by fre_compile(). */
+		   const char *path,            /* The file to bind the pattern against. */
+		   fre_match_callback callback, /* Handed each match. */
+		   void *arg)                   /* Passed on to callback. */
+{
+  int retval = 0, saved_errno = 0;
+
+  if (!handle || !path || !callback){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  if ((retval = intern__fre__match_file(handle, path, callback, arg)) == FRE_ERROR){
+    saved_errno = errno;
+    intern__fre__errmesg("_match_file");
+    errno = saved_errno;
+  }
+
+  return retval;
+}
+
+
+/*
+ * Bind a matching pattern (m//) against a text fed to the stream a chunk at a
+ * time, with fre_stream_feed(), ended by fre_stream_finish(). Matches running
+ * across chunks are found: the stream keeps the bytes one could still begin at,
+ * no more than the pattern's longest match, or than window (0 for 64KiB) when
+ * its matches have no bound and may hold a newline. Longer ones are missed then.
+ * callback gets where each match begins and ends, counted from the stream's
+ * start, once it's known to be final, all of them with /g.
+ */
+fre_stream* fre_stream_new(fre_regex *handle,           /* A pattern returned by fre_compile(). */
+			   size_t window,               /* Most bytes kept for unbounded patterns. */
+			   fre_match_callback callback, /* Handed each match. */
+			   void *arg)                   /* Passed on to callback. */
+{
+  fre_stream *stream = NULL;
+
+  if (!handle || !callback){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((stream = intern__fre__stream_new(handle, window, callback, arg)) == NULL)
+    intern__fre__errmesg("_stream_new");
+
+  return stream;
+}
+
+
+/* Search the next len bytes of a stream's text. FRE_OP_SUCCESSFUL when matches were reported. */
+int fre_stream_feed(fre_stream *stream,
+		    const char *buf,
+		    size_t len)
+{
+  int retval = 0;
+
+  if ((retval = intern__fre__stream_feed(stream, buf, len)) == FRE_ERROR)
+    intern__fre__errmesg("_stream_feed");
+
+  return retval;
+}
+
+
+/* End a stream's text, reporting the matches it kept. */
+int fre_stream_finish(fre_stream *stream)
+{
+  int retval = 0;
+
+  if ((retval = intern__fre__stream_finish(stream)) == FRE_ERROR)
+    intern__fre__errmesg("_stream_finish");
+
+  return retval;
+}
+
+
+/* Release a stream returned by fre_stream_new(), not its pattern. */
+void fre_stream_free(fre_stream *stream)
+{
+  intern__fre__free_stream(stream);
+}
+
+
+/*
+ * Select the lines of the first len bytes of buf that a matching pattern (m//)
+ * matches, as it would each of them bound alone, or with FRE_GREP_INVERT those
+ * it doesn't. buf is searched once, not line by line, for patterns the DFA can
+ * take whole, else their literal finds the lines worth trying.
+ * lines receives the first numof_lines of them, where each begins, its lenght and
+ * number, *numof_selected how many there are. /g is of no matter.
+ * The thread's pmatch-table is left untouched.
+ */
+int fre_grep_lines(fre_regex *handle,          /* A pattern returned by fre_compile(). */
+		   const char *buf,            /* The lines, separated by newlines. */
+		   size_t len,                 /* The lenght of buf. */
+		   int flags,                  /* 0 or FRE_GREP_INVERT. */
+		   fre_line *lines,            /* Room for numof_lines lines, or NULL. */
+		   size_t numof_lines,
+		   size_t *numof_selected)     /* How many lines were selected. */
+{
+  int retval = 0;
+
+  if (!handle || (!buf && len > 0) || !numof_selected){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  if (len >= FRE_ARG_STRING_MAX_LENGHT){
+    errno = EOVERFLOW;
+    return FRE_ERROR;
+  }
+  if ((retval = intern__fre__grep_lines(handle, buf, len, ((flags & FRE_GREP_INVERT) != 0),
+					lines, numof_lines, NULL, NULL, numof_selected)) == FRE_ERROR)
+    intern__fre__errmesg("_grep_lines");
+
+  return retval;
+}
+
+
+/* Like fre_grep_lines(), handing each line selected to callback, until it returns non-zero. */
+int fre_grep_lines_cb(fre_regex *handle,          /* A pattern returned by fre_compile(). */
+		      const char *buf,            /* The lines, separated by newlines. */
+		      size_t len,                 /* The lenght of buf. */
+		      int flags,                  /* 0 or FRE_GREP_INVERT. */
+		      fre_line_callback callback, /* Handed each line. */
+		      void *arg)                  /* Passed on to callback. */
+{
+  int retval = 0;
+  size_t numof_selected = 0;
+
+  if (!handle || (!buf && len > 0) || !callback){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  if (len >= FRE_ARG_STRING_MAX_LENGHT){
+    errno = EOVERFLOW;
+    return FRE_ERROR;
+  }
+  if ((retval = intern__fre__grep_lines(handle, buf, len, ((flags & FRE_GREP_INVERT) != 0),
+					NULL, 0, callback, arg, &numof_selected)) == FRE_ERROR)
+    intern__fre__errmesg("_grep_lines");
+
+  return retval;
+}
+
+
+/* How many lines fre_grep_lines() would select, in *count. */
+int fre_grep_count(fre_regex *handle,          /* A pattern returned by fre_compile(). */
+		   const char *buf,            /* The lines, separated by newlines. */
+		   size_t len,                 /* The lenght of buf. */
+		   int flags,                  /* 0 or FRE_GREP_INVERT. */
+		   size_t *count)              /* How many lines were selected. */
+{
+  return fre_grep_lines(handle, buf, len, flags, NULL, 0, count);
+}
+
+
+/* 
+ * Bind pattern against string.
+ * Patterns are kept compiled in a per-thread cache, recurring patterns
+ * skip the _plp_parser and regcomp entirely.
+ */
+int fre_bind(char *pattern,       /* The regex pattern. */
+	     char *string,        /* The string to bind the pattern against. */
+	     size_t string_size)  /* The size of string. (NOT THE LENGHT !) */
+{
+  size_t pattern_len = 0;
+  fre_pattern *freg_object = NULL;
+  int retval = 0;
+
+  if (!pattern || !string){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  pattern_len = strnlen(pattern, FRE_MAX_PATTERN_LENGHT);
+  if (pattern[pattern_len] != '\0') {
+    errno = FRE_PATRNTOOLONG;
+    return FRE_ERROR;
+  }
+  if ((freg_object = intern__fre__pcache_lookup(pattern)) == NULL){
+    intern__fre__errmesg("_pcache_lookup");
+    return FRE_ERROR;
+  }
+  retval = fre_exec(freg_object, string, string_size);
+  /* When the cache is disabled, the object is ours to free. */
+  if (fre_pmatch_table->pattern_cache->capacity == 0)
+    intern__fre__free_pattern(freg_object);
+
+  return retval;
+}
+
+
+/* Bind pattern against the first string_len bytes of string, see fre_exec_n(). */
+int fre_bind_n(char *pattern,       /* The regex pattern. */
+	       char *string,        /* The string to bind the pattern against. */
+	       size_t string_len,   /* The lenght of string. */
+	       size_t string_size)  /* The size of string, for s/// and tr///. */
+{
+  size_t pattern_len = 0;
+  fre_pattern *freg_object = NULL;
+  int retval = 0;
+
+  if (!pattern || !string){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  pattern_len = strnlen(pattern, FRE_MAX_PATTERN_LENGHT);
+  if (pattern[pattern_len] != '\0') {
+    errno = FRE_PATRNTOOLONG;
+    return FRE_ERROR;
+  }
+  if ((freg_object = intern__fre__pcache_lookup(pattern)) == NULL){
+    intern__fre__errmesg("_pcache_lookup");
+    return FRE_ERROR;
+  }
+  retval = fre_exec_n(freg_object, string, string_len, string_size);
+  if (fre_pmatch_table->pattern_cache->capacity == 0)
+    intern__fre__free_pattern(freg_object);
+
+  return retval;
+}
+
+
+/* 
+ * Set the number of patterns kept compiled by the calling thread's cache.
+ * Least recently used patterns are released when the cache shrinks, 0 disables it.
+ */
+int fre_cache_set_capacity(size_t capacity)
+{
+  return intern__fre__pcache_resize(fre_pmatch_table->pattern_cache, capacity);
+}
+
+
+/* Fetch the calling thread's pattern cache hit and miss counters. */
+void fre_cache_stats(size_t *hits,     /* Lookups that skipped the parser. */
+		     size_t *misses)   /* Lookups that had to parse the pattern. */
+{
+  if (hits)
+    *hits = fre_pmatch_table->pattern_cache->hits;
+  if (misses)
+    *misses = fre_pmatch_table->pattern_cache->misses;
+}
+
+
+/*
+ * Set the number of parsed patterns kept by the table shared by all threads.
+ * Patterns still in use by a thread are released once they're done with them, 0 disables the table.
+ */
+int fre_shared_cache_set_capacity(size_t capacity)
+{
+  return intern__fre__shared_resize(capacity);
+}
+
+
+/*
+ * Set how many bytes the DFA of a pattern may use for its states, they're
+ * all dropped and built again as needed once it goes past that.
+ * Applies to the patterns compiled (or copied by a thread's cache) from now on.
+ */
+int fre_dfa_set_budget(size_t bytes)
+{
+  if (bytes == 0){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  __atomic_store_n(&fre_dfa_budget, bytes, __ATOMIC_RELAXED);
+  return FRE_OP_SUCCESSFUL;
+}
+
+
+/*
+ * Set whether the DFA of the patterns compiled (or parsed by a thread's cache)
+ * from now on runs as native code, see fre_jit(). Off by default.
+ */
+int fre_jit_set_enabled(int enabled)
+{
+  __atomic_store_n(&fre_jit_enabled, (enabled != 0), __ATOMIC_RELAXED);
+  return FRE_OP_SUCCESSFUL;
+}
+
+
+/*
+ * Compile the DFA of a pattern returned by fre_compile() to native x86-64 code,
+ * or release that code when enabled is 0. Returns 0 when the pattern doesn't
+ * run natively: it isn't DFA-backed, its DFA has too many states, none of
+ * them would run faster, or the machine isn't x86-64. The interpreter keeps
+ * running it then.
+ */
+int fre_jit(fre_regex *handle,    /* A pattern returned by fre_compile(). */
+	    int enabled)          /* 0 to go back to the interpreter. */
+{
+  fre_pattern *freg_object = handle;
+
+  if (!freg_object){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  if (enabled == 0){
+    intern__fre__free_jit(freg_object->jit);
+    freg_object->jit = NULL;
+    return FRE_OP_SUCCESSFUL;
+  }
+  if (freg_object->jit != NULL)
+    return FRE_OP_SUCCESSFUL;
+  errno = 0;
+  if ((freg_object->jit = intern__fre__jit_build(freg_object)) == NULL){
+    if (errno != 0){
+      intern__fre__errmesg("_jit_build");
+      return FRE_ERROR;
+    }
+    return FRE_OP_UNSUCCESSFUL;
+  }
+  return FRE_OP_SUCCESSFUL;
+}
+
+
+/* Number of bytes the calling thread's last transliteration found in its search list. */
+size_t fre_tr_count(void)
+{
+  return fre_pmatch_table->tr_count;
+}
+
+
+/*
+ * Lenght of the string left by the calling thread's last s/// or tr///, in the
+ * caller's string or fre_tr_result(), for strings holding NUL bytes.
+ */
+size_t fre_result_len(void)
+{
+  return fre_pmatch_table->result_len;
+}
+
+
+/*
+ * The string built by the calling thread's last tr///r operation, NULL if its last
+ * operation wasn't one. It stays valid until the thread's next operation.
+ */
+char* fre_tr_result(void)
+{
+  return ((fre_pmatch_table->tr_has_result == true) ? fre_pmatch_table->tr_result : NULL);
+}
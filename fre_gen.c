@@ -0,0 +1,343 @@
+/*
+ *
+ *  fre-gen  -  Build-time matcher generator.
+ *  Version:   0.600
+ *
+ *  Usage:  fre-gen [-o file.c] name pattern [name pattern ...]
+ *
+ *  Writes standalone C source with, for each matching pattern (m//),
+ *  the complete forward and backward DFAs the library would build for it,
+ *  as const tables, and a function name() finding its leftmost-longest
+ *  match with them. The generated file needs neither libfre nor any
+ *  compilation of the pattern at run time.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+#define FRE_GEN_MAX_STATES    65535  /* States of a DFA, so that they fit an uint16_t. */
+
+
+/* Body of the matching function, '@' is replaced by its name. */
+static const char *gen_match_template =
+  "/*\n"
+  " * Leftmost-longest match of @_pattern in string[start..string_len], the bytes\n"
+  " * around it giving anchors and boundaries their context. Returns 1 and sets\n"
+  " * *bo and *eo to where it begins and ends, 0 when there's none, -1 if start\n"
+  " * is past string_len, or if the backward DFA finds no begining for the end\n"
+  " * the forward one found, which the tables generated together never do.\n"
+  " */\n"
+  "int @(const char *string, size_t string_len, size_t start, size_t *bo, size_t *eo)\n"
+  "{\n"
+  "  const unsigned char *s = (const unsigned char*)string;\n"
+  "  size_t i = 0;\n"
+  "  ptrdiff_t end = -1, begin = -1;\n"
+  "  unsigned int state = 0;\n"
+  "\n"
+  "  if (start > string_len)\n"
+  "    return -1;\n"
+  "  /* Forward, to the end of the match. */\n"
+  "  state = @_fwd_init[(start == 0) ? FRE_GEN_CTX_EDGE : @_fwd_ctx[s[start - 1]]];\n"
+  "  for (i = start; i < string_len; i++){\n"
+  "    state = @_fwd_trans[state][@_fwd_classes[s[i]]];\n"
+  "    if (@_fwd_flags[state] & FRE_GEN_MATCH)\n"
+  "      end = (ptrdiff_t)i;\n"
+  "    if (@_fwd_flags[state] & FRE_GEN_DEAD)\n"
+  "      break;\n"
+  "  }\n"
+  "  if (i == string_len && (@_fwd_flags[state] & FRE_GEN_EOT_MATCH))\n"
+  "    end = (ptrdiff_t)string_len;\n"
+  "  if (end < 0)\n"
+  "    return 0;\n"
+  "  /* Backward from there, to its begining. */\n"
+  "  state = @_rev_init[((size_t)end == string_len) ? FRE_GEN_CTX_EDGE : @_rev_ctx[s[end]]];\n"
+  "  for (i = (size_t)end; i > start; i--){\n"
+  "    state = @_rev_trans[state][@_rev_classes[s[i - 1]]];\n"
+  "    if (@_rev_flags[state] & FRE_GEN_MATCH)\n"
+  "      begin = (ptrdiff_t)i;\n"
+  "    if (@_rev_flags[state] & FRE_GEN_DEAD)\n"
+  "      break;\n"
+  "  }\n"
+  "  if (i == start){\n"
+  "    if (start == 0){\n"
+  "      if (@_rev_flags[state] & FRE_GEN_EOT_MATCH)\n"
+  "        begin = 0;\n"
+  "    }\n"
+  "    else if (@_rev_flags[@_rev_trans[state][@_rev_classes[s[start - 1]]]] & FRE_GEN_MATCH)\n"
+  "      begin = (ptrdiff_t)start;\n"
+  "  }\n"
+  "  if (begin < 0)\n"
+  "    return -1;\n"
+  "  *bo = (size_t)begin;\n"
+  "  *eo = (size_t)end;\n"
+  "  return 1;\n"
+  "}\n";
+
+
+static void usage(char *name)
+{
+  fprintf(stderr, "\nUsage:  %s [-o file.c] name pattern [name pattern ...]\n\n", name);
+}
+
+
+/* Copy template to out, with name in place of each '@'. */
+static void gen_template(FILE *out,
+			 const char *template,
+			 const char *name)
+{
+  for (; *template != '\0'; template++){
+    if (*template == '@')
+      fputs(name, out);
+    else
+      fputc(*template, out);
+  }
+}
+
+
+/* The names of what is generated for a pattern, its name followed by one of these. */
+static const char *gen_suffixes[] = { "", "_pattern",
+				      "_fwd_classes", "_fwd_ctx", "_fwd_init", "_fwd_trans", "_fwd_flags",
+				      "_rev_classes", "_rev_ctx", "_rev_init", "_rev_trans", "_rev_flags" };
+
+
+/* Whether name can be a C identifier. */
+static bool gen_valid_name(const char *name)
+{
+  size_t i = 0;
+
+  if (name[0] == '\0' || (name[0] >= '0' && name[0] <= '9'))
+    return false;
+  for (i = 0; name[i] != '\0'; i++)
+    if (!((name[i] >= 'a' && name[i] <= 'z') || (name[i] >= 'A' && name[i] <= 'Z')
+	  || (name[i] >= '0' && name[i] <= '9') || name[i] == '_'))
+      return false;
+  return true;
+}
+
+
+/* Whether other is name followed by one of gen_suffixes. */
+static bool gen_clash(const char *name,
+		      const char *other)
+{
+  size_t i = 0, len = strlen(name);
+
+  if (strncmp(name, other, len) != 0)
+    return false;
+  for (i = 0; i < sizeof(gen_suffixes) / sizeof(gen_suffixes[0]); i++)
+    if (strcmp(other + len, gen_suffixes[i]) == 0)
+      return true;
+  return false;
+}
+
+
+/* Print 256 bytes as the initializer of a const table. */
+static void gen_bytes(FILE *out,
+		      const char *name,
+		      const char *table,
+		      const uint8_t *bytes)
+{
+  size_t i = 0;
+
+  fprintf(out, "static const uint8_t %s_%s[256] = {", name, table);
+  for (i = 0; i < 256; i++)
+    fprintf(out, "%s%u%s", ((i % 16 == 0) ? "\n  " : ""), (unsigned int)bytes[i], ((i < 255) ? "," : ""));
+  fprintf(out, "\n};\n");
+}
+
+
+/*
+ * Print the tables of a complete DFA, prefixed by name and dir ("fwd" or "rev"):
+ * the class of each byte, the context it gives, the initial state for each
+ * context, the next state of each state for each class and the flags of each state.
+ */
+static void gen_dfa(FILE *out,
+		    const char *name,
+		    const char *dir,
+		    fre_dfa *dfa)
+{
+  size_t i = 0, cls = 0, numof_classes = dfa->prog->numof_classes;
+  uint8_t ctx[256];
+  char table[16];
+  const char *type = ((dfa->numof_states <= 256) ? "uint8_t" : "uint16_t");
+
+  for (i = 0; i < 256; i++)
+    ctx[i] = dfa->prog->class_ctx[dfa->prog->byte_class[i]];
+  snprintf(table, sizeof(table), "%s_classes", dir);
+  gen_bytes(out, name, table, dfa->prog->byte_class);
+  snprintf(table, sizeof(table), "%s_ctx", dir);
+  gen_bytes(out, name, table, ctx);
+
+  fprintf(out, "static const %s %s_%s_init[4] = {", type, name, dir);
+  for (i = 0; i < 4; i++)
+    fprintf(out, " %zu%s", (size_t)dfa->init[i] / numof_classes, ((i < 3) ? "," : " };\n"));
+  fprintf(out, "static const %s %s_%s_trans[%zu][%zu] = {\n", type, name, dir, dfa->numof_states, numof_classes);
+  for (i = 0; i < dfa->numof_states; i++){
+    fprintf(out, "  {");
+    for (cls = 0; cls < numof_classes; cls++)
+      fprintf(out, " %zu%s", (size_t)FRE_DFA_ROW(dfa->trans[i * numof_classes + cls]) / numof_classes,
+	      ((cls + 1 < numof_classes) ? "," : ""));
+    fprintf(out, " }%s\n", ((i + 1 < dfa->numof_states) ? "," : ""));
+  }
+  fprintf(out, "};\n");
+  fprintf(out, "static const uint8_t %s_%s_flags[%zu] = {", name, dir, dfa->numof_states);
+  for (i = 0; i < dfa->numof_states; i++)
+    fprintf(out, "%s%u%s", ((i % 16 == 0) ? "\n  " : ""), (unsigned int)dfa->state_flags[i],
+	    ((i + 1 < dfa->numof_states) ? "," : ""));
+  fprintf(out, "\n};\n");
+}
+
+
+/* Print a pattern as a C string literal. */
+static void gen_string(FILE *out,
+		       const char *string)
+{
+  fputc('"', out);
+  for (; *string != '\0'; string++){
+    if (*string == '"' || *string == '\\')
+      fprintf(out, "\\%c", *string);
+    else if ((unsigned char)*string < 0x20 || (unsigned char)*string >= 0x7f)
+      fprintf(out, "\\%03o", (unsigned int)(unsigned char)*string);
+    else
+      fputc(*string, out);
+  }
+  fputc('"', out);
+}
+
+
+/*
+ * Parse pattern like fre_compile() does, build both of its DFAs
+ * completely and print them and the function matching with them,
+ * or only check that it can be done when out is NULL.
+ */
+static int gen_pattern(FILE *out,
+		       const char *name,
+		       char *pattern)
+{
+  int retval = -1, ret = 0;
+  fre_pattern *freg_object = NULL;
+  fre_ast_tree *tree = NULL;
+  fre_prog *prog = NULL, *rev_prog = NULL;
+  fre_dfa *dfa = NULL, *rev_dfa = NULL;
+
+  if ((freg_object = intern__fre__plp_parser(pattern)) == NULL){
+    fprintf(stderr, "fre-gen: %s: can't parse %s\n", name, pattern);
+    return -1;
+  }
+  if (freg_object->fre_op_flag != MATCH){
+    fprintf(stderr, "fre-gen: %s: only matching patterns (m//) can be generated.\n", name);
+    goto cleanup;
+  }
+  if ((ret = intern__fre__parse_ere(freg_object->striped_pattern[0], freg_object->fre_mod_icase,
+				    !freg_object->fre_mod_newline, &tree)) != FRE_OP_SUCCESSFUL
+      || tree->backrefs){
+    fprintf(stderr, "fre-gen: %s: %s can't be matched by a DFA.\n", name, pattern);
+    goto cleanup;
+  }
+  if ((prog = intern__fre__compile_prog(tree, false)) == NULL
+      || (rev_prog = intern__fre__compile_prog(tree, true)) == NULL
+      || (dfa = intern__fre__dfa_build(prog, false)) == NULL
+      || (rev_dfa = intern__fre__dfa_build(rev_prog, true)) == NULL){
+    fprintf(stderr, "fre-gen: %s: %s can't be matched by a DFA.\n", name, pattern);
+    goto cleanup;
+  }
+  /* Every state, none of them is ever flushed. */
+  dfa->budget = rev_dfa->budget = SIZE_MAX;
+  if (intern__fre__dfa_complete(dfa, FRE_GEN_MAX_STATES) != FRE_OP_SUCCESSFUL
+      || intern__fre__dfa_complete(rev_dfa, FRE_GEN_MAX_STATES) != FRE_OP_SUCCESSFUL){
+    fprintf(stderr, "fre-gen: %s: %s has more than %d DFA states.\n", name, pattern, FRE_GEN_MAX_STATES);
+    goto cleanup;
+  }
+  if (out == NULL){
+    retval = 0;
+    goto cleanup;
+  }
+
+  fprintf(out, "\n/* %s(), %zu + %zu states. */\n", name, dfa->numof_states, rev_dfa->numof_states);
+  fprintf(out, "const char %s_pattern[] = ", name);
+  gen_string(out, pattern);
+  fprintf(out, ";\n");
+  gen_dfa(out, name, "fwd", dfa);
+  gen_dfa(out, name, "rev", rev_dfa);
+  fputc('\n', out);
+  gen_template(out, gen_match_template, name);
+  retval = 0;
+
+ cleanup:
+  intern__fre__free_dfa(dfa);
+  intern__fre__free_dfa(rev_dfa);
+  intern__fre__free_prog(prog);
+  intern__fre__free_prog(rev_prog);
+  intern__fre__free_ast(tree);
+  intern__fre__free_pattern(freg_object);
+  return retval;
+}
+
+
+int main(int argc, char **argv)
+{
+  int i = 1, k = 0, j = 0, retval = 0;
+  char *path = NULL;
+  FILE *out = stdout;
+
+  if (argc > 2 && strcmp(argv[1], "-o") == 0){
+    path = argv[2];
+    i = 3;
+  }
+  if (argc - i < 2 || (argc - i) % 2 != 0){
+    usage(argv[0]);
+    return -1;
+  }
+  /* Every name and pattern is checked before anything is written. */
+  for (k = i; k < argc; k += 2){
+    if (!gen_valid_name(argv[k])){
+      fprintf(stderr, "fre-gen: %s isn't a valid C identifier.\n", argv[k]);
+      return -1;
+    }
+    for (j = i; j < k; j += 2)
+      if (gen_clash(argv[j], argv[k]) || gen_clash(argv[k], argv[j])){
+	fprintf(stderr, "fre-gen: %s and %s would define the same names.\n", argv[j], argv[k]);
+	return -1;
+      }
+    if (gen_pattern(NULL, argv[k], argv[k + 1]) != 0)
+      return -1;
+  }
+  if (path != NULL && (out = fopen(path, "w")) == NULL){
+    perror(path);
+    return -1;
+  }
+
+  fprintf(out, "/*\n * Generated by fre-gen, do not edit.\n *\n"
+	  " * int name(const char *string, size_t string_len, size_t start, size_t *bo, size_t *eo);\n"
+	  " * finds the leftmost-longest match of each pattern below, see name_pattern.\n */\n\n"
+	  "#include <stddef.h>\n#include <stdint.h>\n\n"
+	  "#ifndef FRE_GEN_MATCH\n"
+	  "# define FRE_GEN_MATCH      0x%x  /* A match ended right before the last byte. */\n"
+	  "# define FRE_GEN_DEAD       0x%x  /* No match can begin nor go on from here. */\n"
+	  "# define FRE_GEN_EOT_MATCH  0x%x  /* A match ends if the text ends here. */\n"
+	  "# define FRE_GEN_CTX_EDGE   %d    /* Context outside of the text. */\n"
+	  "#endif\n",
+	  FRE_DFA_MATCH, FRE_DFA_DEAD, FRE_DFA_EOT_MATCH, FRE_CTX_EDGE);
+  for (; i < argc; i += 2){
+    if (gen_pattern(out, argv[i], argv[i + 1]) != 0){
+      retval = -1;
+      break;
+    }
+  }
+  if (out != stdout && fclose(out) != 0){
+    perror(path);
+    retval = -1;
+  }
+  if (retval != 0 && path != NULL)
+    remove(path);
+
+  return retval;
+}
@@ -12,10 +12,14 @@
 # include <stdio.h>
 # include <stdlib.h>
 # include <stdbool.h>
+# include <stdint.h>
 # include <limits.h>
 # include <errno.h>
 # include <regex.h>
 # include <pthread.h>
+# include <sys/types.h>
+
+# include "fre.h"
 
 /* To serialize messages containing multiple function calls. */
 extern pthread_mutex_t fre_stderr_mutex; /* Defined and initialized in "fre_internal_init.c" */
@@ -25,12 +29,52 @@ extern pthread_mutex_t fre_stderr_mutex; /* Defined and initialized in "fre_inte
 
 /* Sub-match(es) begining/ending of match offsets structure. */
 typedef struct fre_sm{
-  int                   bo;               /* Offset of the begining of sub-match. */
-  int                   eo;               /* Offset of the ending of sub-match. */
+  fre_off               bo;               /* Offset of the begining of sub-match. */
+  fre_off               eo;               /* Offset of the ending of sub-match. */
 
 } fre_smatch;
 
 
+/* 
+ * One piece of a compiled substitute pattern, either a run of 
+ * literal characters or a reference to a sub-match ($N, ${N}, \N).
+ */
+typedef struct fre_repl_seg {
+  long                  sm_number;        /* -1 for a literal run, else the sub-match number (0 is the whole match). */
+  size_t                lit_off;          /* Offset of the literal run inside fre_replacement->literals. */
+  size_t                lit_len;          /* Lenght of the literal run. */
+
+} fre_repl_seg;
+
+
+/* A substitute pattern compiled once by the _plp_parser. */
+typedef struct fre_repl {
+  fre_repl_seg          *segs;            /* Segments, in output order. */
+  size_t                segs_c;           /* Number of segments in use. */
+  char                  *literals;        /* Literal characters of every literal run, back to back. */
+  size_t                literals_len;     /* Number of characters in literals. */
+
+} fre_replacement;
+
+
+/* 
+ * A transliteration pattern compiled once by the _plp_parser.
+ * map is laid out as 16 rows of 16 bytes, row N holding the replacements
+ * of bytes 0xN0 to 0xNF, which is what the SIMD kernels shuffle through.
+ */
+typedef struct fre_tr {
+  unsigned char         map[256];         /* Replacement of every byte, identity for bytes not in the search list. */
+  uint8_t               in_set[32];       /* Bitmap of the bytes found in the search list. */
+  uint8_t               del_set[32];      /* Bitmap of the bytes to delete (/d). */
+  uint8_t               class_lo[16];     /* in_set, indexed by low nibble, bit N for high nibble N (0-7). */
+  uint8_t               class_hi[16];     /* in_set, indexed by low nibble, bit N for high nibble N+8 (8-15). */
+  uint16_t              active_rows;      /* Bit N is set when row N of map isn't the identity. */
+  bool                  squeeze;          /* True with /s, runs of a same transliterated byte become one. */
+  bool                  has_deletions;    /* True when del_set isn't empty. */
+
+} fre_translit;
+
+
 /* To keep track of where in each patterns are the back-references. */
 typedef struct fre_brefs {
   int                   *in_pattern;    /* 
@@ -64,6 +108,308 @@ typedef enum foperation {
 } fre_op_f;
 
 
+/* Flag to indicate which engine executes a fre_pattern's matching pattern. */
+typedef enum fengine {
+  FRE_ENGINE_REGEX = 0,                   /* regcomp()/regexec(), for everything the others can't handle. */
+  FRE_ENGINE_DFA,                         /* Libfre's own DFA, fre_internal_dfa.c */
+  FRE_ENGINE_LITERAL,                     /* A substring search, for patterns that are a plain literal. */
+  FRE_ENGINE_AC,                          /* Aho-Corasick, for alternations of plain literals, fre_internal_ac.c */
+  FRE_ENGINE_BACKTRACK                    /* A backtracking VM, for patterns with back-references, fre_internal_backtrack.c */
+
+} fre_engine_f;
+
+
+/* How a text read a window at a time is searched, see intern__fre__scan(). */
+typedef enum fscanmode {
+  FRE_SCAN_WHOLE = 0,                     /* The whole text at once. */
+  FRE_SCAN_BOUNDED,                       /* No match is longer than max_len bytes. */
+  FRE_SCAN_BY_LINE,                       /* No match holds a newline. */
+  FRE_SCAN_WINDOW                         /* Matches are taken to be no longer than max_len bytes, the window. */
+
+} fre_scan_f;
+
+
+/* Zero-width assertions of a compiled program. */
+typedef enum fassert {
+  FRE_ASSERT_BOT = 0,                     /* Begining of text. */
+  FRE_ASSERT_EOT,                         /* End of text. */
+  FRE_ASSERT_BOL,                         /* Begining of line (or of text). */
+  FRE_ASSERT_EOL,                         /* End of line (or of text). */
+  FRE_ASSERT_WORDB,                       /* Word boundary. */
+  FRE_ASSERT_NWORDB,                      /* Not a word boundary. */
+  FRE_ASSERT_BOW,                         /* Begining of word. */
+  FRE_ASSERT_EOW                          /* End of word. */
+
+} fre_assert_f;
+
+
+/* Kinds of nodes of a parsed POSIX ERE. */
+typedef enum fastkind {
+  FRE_AST_EMPTY = 0,                      /* Matches the empty string. */
+  FRE_AST_BYTES,                          /* One byte out of the set ->arg. */
+  FRE_AST_ASSERT,                         /* The zero-width assertion ->arg. */
+  FRE_AST_CAT,                            /* ->left followed by ->right. */
+  FRE_AST_ALT,                            /* ->left or ->right. */
+  FRE_AST_REPEAT,                         /* ->left, ->min to ->max times (-1: no maximum). */
+  FRE_AST_GROUP,                          /* Parenthesized ->left, capture number ->arg. */
+  FRE_AST_BREF                            /* The text captured by group ->arg, again. */
+
+} fre_ast_f;
+
+
+/* A node of a parsed POSIX ERE, children are indexes in fre_ast_tree->nodes. */
+typedef struct fre_astnode {
+  fre_ast_f             kind;
+  int                   left;
+  int                   right;
+  int                   arg;
+  int                   min;
+  int                   max;
+
+} fre_ast_node;
+
+
+/* A parsed POSIX ERE, see intern__fre__parse_ere(). */
+typedef struct fre_asttree {
+  fre_ast_node          *nodes;           /* Every node of the tree. */
+  size_t                numof_nodes;      /* Nodes in use. */
+  size_t                nodes_size;       /* Size of nodes. */
+  uint8_t               (*sets)[32];      /* Byte sets (bitmaps) of the FRE_AST_BYTES nodes. */
+  size_t                numof_sets;       /* Sets in use. */
+  size_t                sets_size;        /* Size of sets. */
+  int                   root;             /* Index of the root node. */
+  size_t                numof_groups;     /* Number of parenthesized sub-expressions. */
+  unsigned int          assertions;       /* Bit N is set when fre_assert_f N is used. */
+  bool                  backrefs;         /* True when FRE_AST_BREF nodes are used. */
+
+} fre_ast_tree;
+
+
+/* Instructions of a compiled program. */
+typedef enum fopcode {
+  FRE_I_BYTES = 0,                        /* Consume one byte of the set ->arg, continue at ->out. */
+  FRE_I_SPLIT,                            /* Continue at both ->out and ->out1, ->out first. */
+  FRE_I_ASSERT,                           /* Continue at ->out when the assertion ->arg holds. */
+  FRE_I_SAVE,                             /* Record the position in capture slot ->arg, continue at ->out. */
+  FRE_I_BREF,                             /* Consume the text group ->arg captured, continue at ->out. Backtracker only. */
+  FRE_I_MATCH                             /* The pattern matched. */
+
+} fre_opcode;
+
+
+typedef struct fre_instruction {
+  fre_opcode            op;
+  int                   out;
+  int                   out1;
+  int                   arg;
+
+} fre_inst;
+
+
+/* 
+ * A POSIX ERE compiled into a Thompson NFA, for the engines of fre_internal_dfa.c .
+ * Bytes are partitioned in classes, bytes of a same class can't be told apart by the program.
+ */
+typedef struct fre_program {
+  fre_inst              *insts;           /* The instructions. */
+  size_t                numof_insts;      /* Number of instructions. */
+  int                   start;            /* Index of the first instruction. */
+  uint8_t               (*sets)[32];      /* Byte sets of the FRE_I_BYTES instructions. */
+  size_t                numof_sets;       /* Number of sets. */
+  size_t                numof_groups;     /* Number of parenthesized sub-expressions. */
+  unsigned int          assertions;       /* Bit N is set when fre_assert_f N is used. */
+  uint8_t               byte_class[256];  /* Class of each byte. */
+  size_t                numof_classes;    /* Number of classes. */
+  uint8_t               class_ctx[256];   /* FRE_CTX_* of each class. */
+  uint8_t               class_repr[256];  /* A byte of each class. */
+  bool                  reverse;          /* True when compiled to run from the end of the match to its begining. */
+
+} fre_prog;
+
+
+/* 
+ * A DFA built from a fre_prog, states are sets of program instructions
+ * ordered by the position they started matching from, to find leftmost-longest matches.
+ * States are only built when a scan first needs them, and dropped all at once
+ * when they use more than budget bytes.
+ */
+typedef struct fre_dfa_tab {
+  fre_prog              *prog;            /* The program, owned by the fre_pattern. */
+  bool                  anchored;         /* True when matches may only begin where the scan begins. */
+  bool                  multi;            /* True for a fre_set's DFA, see intern__fre__set_dfa_build(). */
+  int32_t               *trans;           /* numof_states rows of prog->numof_classes next states, see FRE_DFA_ROW(). */
+  uint8_t               *state_flags;     /* FRE_DFA_* flags of each state. */
+  int32_t               init[4];          /* Row of the initial state, for each FRE_CTX_* of the byte before the scan. */
+  size_t                numof_states;     /* Number of states. */
+  size_t                states_size;      /* Size of trans, state_flags and keys, in states. */
+  int                   **keys;           /* Sets of instructions of each state. */
+  int32_t               *key_table;       /* Hash table of keys. */
+  size_t                key_table_size;   /* Size of key_table, a power of 2. */
+  size_t                mem_used;         /* Bytes used by the states. */
+  size_t                budget;           /* The states are flushed once mem_used gets past it. */
+  size_t                numof_flushes;    /* Number of times the states were flushed. */
+
+  /* Scratch space of the state builder. */
+  int                   *stack;           /* Instructions left to visit, then the kernel of a group. */
+  unsigned int          *visited;         /* Generation each instruction was last reached at. */
+  unsigned int          *targeted;        /* Generation each instruction was last added to a group at. */
+  unsigned int          generation;
+  int                   *key;             /* The key of the state being built. */
+  size_t                key_size;         /* Size of key. */
+  int                   *ids;             /* Patterns whose FRE_I_MATCH the closures reached, multi DFAs only. */
+  size_t                numof_ids;        /* Number of ids. */
+
+} fre_dfa;
+
+
+/* A choice left to try, or a capture slot to restore when ->pc is -1. */
+typedef struct fre_bt_job {
+  int                   pc;
+  int                   pos;              /* Where in the string, or the slot's value to restore. */
+  int                   slot;
+
+} fre_bt_job;
+
+
+/*
+ * The backtracker of a program with back-references.
+ * An instruction tried at a position, with the same values in the back-referenced
+ * capture slots it may still read, goes the same way: it's only tried once.
+ * Those from which no back-reference can read a slot before it's saved again
+ * have a bit in memo. The others are kept when more than one instruction leads
+ * to them, a path can only come back to one through such an instruction:
+ * keyed by the instruction, the values of the live slots and pos / 64, blocks
+ * hold a word with the bit of each position pos % 64.
+ */
+typedef struct fre_bt_tab {
+  fre_prog              *prog;            /* The program, owned by the fre_pattern. */
+  bool                  icase;            /* Back-references compare bytes once tolower()'d. */
+  bool                  *referenced;      /* Capture slots a back-reference reads. */
+  bool                  *live;            /* Slot S may be read from instruction PC on, at PC * numof_slots + S. */
+  unsigned char         *kept;            /* How tries of each instruction are kept, a FRE_BT_KEPT_*. */
+  int                   *ref_slots;       /* The referenced slots, in increasing order. */
+  size_t                numof_ref_slots;  /* Number of them. */
+  int                   *caps;            /* Capture slots of the path being tried. */
+  int                   *best;            /* Those of the best match found yet. */
+  size_t                numof_slots;      /* Size of referenced, caps and best. */
+  uint64_t              *memo;            /* Tried instructions, at bit pos * numof_insts + pc. */
+  size_t                memo_words;       /* Size of memo. */
+  size_t                *dirty;           /* Words of memo set since it was last cleared. */
+  size_t                numof_dirty;      /* Number of them. */
+  int                   *blocks;          /* Open-addressed keys pc, the ref_slots' values (-2 when dead), pos / 64, pc -1 for none. */
+  uint64_t              *block_bits;      /* The word of each key. */
+  size_t                blocks_size;      /* Number of keys blocks has room for, a power of 2. */
+  size_t                numof_blocks;     /* Keys in blocks. */
+  int                   *last_block;      /* Key each instruction was last tried at, -1 for none. */
+  fre_bt_job            *jobs;            /* Stack of choices left to try. */
+  size_t                numof_jobs;       /* Jobs in use. */
+  size_t                jobs_size;        /* Size of jobs. */
+
+} fre_bt;
+
+
+/* Threads of a Pike VM step, a sparse set of program instructions. */
+typedef struct fre_pike_list {
+  int                   *sparse;          /* Index in dense of each instruction, when it's in the list. */
+  int                   *dense;           /* Instructions in the list, highest priority first. */
+  fre_off               *caps;            /* numof_slots capture slots for each of them. */
+  size_t                numof_threads;    /* Instructions in the list. */
+
+} fre_pike_list;
+
+
+/* A thread to follow, or a capture slot to restore when ->pc is -1. */
+typedef struct fre_pike_job {
+  int                   pc;
+  int                   slot;
+  fre_off               value;            /* The slot's value to restore. */
+
+} fre_pike_job;
+
+
+/*
+ * The Pike VM of a program, finds sub-matches in time linear in the length
+ * of the string, for patterns a DFA runs. Threads are kept in the order
+ * a backtracking matcher would try them, the first one at an instruction
+ * takes it for the step.
+ */
+typedef struct fre_pike_tab {
+  fre_prog              *prog;            /* The program, owned by the fre_pattern. */
+  size_t                numof_slots;      /* Capture slots of a thread. */
+  fre_pike_list         lists[2];         /* Threads of the current step and of the next one. */
+  fre_off               *caps;            /* Capture slots of the thread being followed. */
+  fre_off               *best;            /* Those of the best match found yet. */
+  fre_pike_job          *jobs;            /* Stack of the thread being followed, numof_insts jobs. */
+
+} fre_pike;
+
+
+/* 
+ * A literal found in every match of a pattern, looked for before running its engine.
+ * Each position accepts bytes[i] or alt[i], which is bytes[i] unless the pattern
+ * lets two bytes in there, like under REG_ICASE.
+ */
+# define FRE_LITERAL_MAX_LENGHT 64        /* Longest literal kept. */
+
+typedef struct fre_lit {
+  unsigned char         bytes[FRE_LITERAL_MAX_LENGHT];
+  unsigned char         alt[FRE_LITERAL_MAX_LENGHT];
+  size_t                len;              /* Lenght of the literal, never 0. */
+  bool                  prefix;           /* True when every match begins with the literal. */
+
+} fre_literal;
+
+
+/* 
+ * An Aho-Corasick automaton finding any of a set of literals, its failure links
+ * resolved into a dense transition table. Bytes are mapped to classes first,
+ * class 0 standing for every byte none of the literals has.
+ */
+typedef struct fre_ac_tab {
+  int32_t               *trans;           /* numof_states rows of numof_classes next states, see FRE_DFA_ROW(). */
+  uint16_t              *out_len;         /* Lenght of the longest literal ending in each state, 0 for none. */
+  size_t                numof_states;     /* Number of states, the root's row is the first one. */
+  size_t                numof_classes;    /* Number of byte classes. */
+  size_t                max_len;          /* Lenght of the longest literal. */
+  uint8_t               byte_class[256];  /* Class of each byte. */
+  bool                  grouped;          /* True when the alternation is parenthesized, sub-match 1 is the whole match. */
+
+} fre_ac;
+
+
+/*
+ * The Glushkov automaton of a short pattern made of a sequence of byte sets,
+ * each one repeated or not, one bit per position of the pattern, bit 0 for
+ * the initial state: position P is only followed by P + 1 and itself,
+ * so the whole automaton is stepped with a shift and a mask.
+ */
+typedef struct fre_bitpar_tab {
+  uint64_t              byte_mask[256];   /* Positions each byte may be matched at. */
+  uint64_t              first;            /* Positions following the initial state. */
+  uint64_t              last;             /* Positions a match may end at. */
+  uint64_t              loops;            /* Positions following themselves. */
+
+} fre_bitpar;
+
+
+/*
+ * Native x86-64 code running the forward scan of a complete DFA, see
+ * fre_internal_jit.c. code holds a copy of the byte classes and of the
+ * transitions, then the code: nothing in it depends on where it's mapped
+ * nor on the DFA once built.
+ */
+typedef struct fre_jit_code_tab {
+  unsigned char         *code;            /* size bytes, mapped readable and executable. */
+  size_t                size;
+  size_t                entry;            /* Offset of scan in code. */
+  ssize_t               (*scan)(const unsigned char *string, /* End of the leftmost-longest match, or -1. */
+				size_t start,
+				size_t string_len,
+				int ctx);                /* FRE_CTX_* of the byte before start. */
+
+} fre_jit_code;
+
+
 /* Structure of a fre_pattern. */
 typedef struct fpattern {
   /* Pattern modifiers */
@@ -73,17 +419,14 @@ typedef struct fpattern {
   bool                  fre_mod_ext;            /* True when the '/x' modifier is activated. */
   bool                  fre_mod_global;         /* True when the '/g' modifier is activated. */
   bool                  fre_mod_sub_is_regex;   /* True when treating substitute pattern like a regex pattern. */
+  bool                  fre_mod_tr_complement;  /* True when the '/c' modifier of a transliteration is activated. */
+  bool                  fre_mod_tr_delete;      /* True when the '/d' modifier of a transliteration is activated. */
+  bool                  fre_mod_tr_squeeze;     /* True when the '/s' modifier of a transliteration is activated. */
+  bool                  fre_mod_tr_return;      /* True when the '/r' modifier of a transliteration is activated. */
 
   /* Indicate whether or not to regfree() the pattern. */
   bool                  fre_p1_compiled;        /* True when stripped_pattern[0] has been regcomp()'d. */
 
-  /* Word boundaries. */
-  bool                  fre_not_boundary;       /* True when the sequence is 'not a word boundary \B'. */
-  bool                  fre_match_op_bow;       /* True when a begining of word sequence is found in a matching pattern. */
-  bool                  fre_match_op_eow;       /* True when an ending of word sequence is found in a matching pattern. */
-  bool                  fre_subs_op_bow;        /* True when a begining of word sequence is found in a substitute pattern. */
-  bool                  fre_subs_op_eow;        /* True when an ending of word sequence is found in a substitute pattern. */
-  
   /* Pattern's delimiter(s) */
   bool                  fre_paired_delimiters;  /* True when delimiter is one of  { ( [ <  */
   char                  delimiter;              /* The delimiter used in the pattern. */
@@ -95,30 +438,123 @@ typedef struct fpattern {
   /* Back-reference related */
   bool                  fre_match_op_bref;      /* True when back-reference(s) are found in a matching pattern. */
   bool                  fre_subs_op_bref;       /* True when back-reference(s) are found in the substitute pattern. */
-  int                   bref_to_insert;         /* The index of the backreference to be inserted in pattern. */
   fre_backref           *backref_pos;           /* Contains positions of back-references, when fre_op_bref is true. */
   
   /* Patterns */
   regex_t               *comp_pattern;         /* The compiled regex pattern. */
   char                  **striped_pattern;     /* Exactly 2 strings, holds patterns striped from Perl syntax elements. */
-  char                  **saved_pattern;       /* Exactly 2 strings, copies of strip_pattern[0|1] before _match_op modifies them. */
+  char                  **saved_pattern;       /* Exactly 2 strings, copies of strip_pattern[0|1] as _perl_to_posix() left them. */
+  fre_replacement       *replacement;          /* The compiled substitute pattern, NULL unless fre_op_flag is SUBSTITUTE. */
+  fre_translit          *translit;             /* The compiled transliteration, NULL unless fre_op_flag is TRANSLITERATE. */
+
+  /* Native engines. */
+  fre_engine_f          engine;                /* Which engine executes the matching pattern. */
+  size_t                numof_groups;          /* Number of parenthesized sub-expressions of the compiled pattern. */
+  fre_prog              *prog;                 /* The matching pattern compiled for the DFA, or NULL. */
+  fre_prog              *rev_prog;             /* prog, compiled to run backward. */
+  fre_dfa               *dfa;                  /* Finds where the leftmost-longest match ends. */
+  fre_dfa               *rev_dfa;              /* Finds where it begins, from its end. */
+  fre_ac                *ac;                   /* The automaton of FRE_ENGINE_AC, or NULL. */
+  fre_bt                *bt;                   /* The backtracker of FRE_ENGINE_BACKTRACK (running prog), or NULL. */
+  fre_pike              *pike;                 /* Sub-matches of FRE_ENGINE_DFA (running prog), or NULL without groups. */
+  fre_bitpar            *bitpar;               /* Scans ahead of the DFA for short patterns, or NULL. */
+  fre_jit_code          *jit;                  /* Runs the forward scan of dfa natively, or NULL. */
+  fre_literal           *literal;              /* Literal every match contains, or NULL. The pattern itself with FRE_ENGINE_LITERAL. */
+
+  /* Process-wide pattern table. */
+  struct fre_shared_ent *shared_entry;         /* Entry of the shared pattern table this object was cloned from, or NULL. */
 
 } fre_pattern;
 
 
+/*
+ * Matching patterns bound all at once to a string by fre_set_exec().
+ * Those the native parser takes are combined into a single multi DFA,
+ * the others are run one after the other by their own engine.
+ */
+typedef struct fre_set_tab {
+  fre_pattern           **patterns;            /* The parsed patterns, in the caller's order. */
+  size_t                numof_patterns;        /* Number of patterns. */
+  bool                  *combined;             /* True for the patterns the DFA runs. */
+  size_t                numof_combined;        /* Number of them. */
+  fre_prog              *prog;                 /* Their programs side by side, or NULL. */
+  fre_dfa               *dfa;                  /* Finds which of them match. */
+  fre_smatch            *found;                /* Scratch, where the first match of each pattern ends, -1 for none. */
+
+} fre_patset;
+
+
+/* A matching pattern searching a text a window at a time, see fre_internal_stream.c */
+typedef struct fre_scan_tab {
+  fre_pattern           *pattern;              /* The pattern, the caller's. */
+  fre_scan_f            mode;                  /* What tells a match found in a window is final. */
+  size_t                max_len;               /* Longest match, FRE_SCAN_BOUNDED and FRE_SCAN_WINDOW. */
+  fre_match_callback    callback;              /* Handed each match. */
+  void                  *arg;                  /* Passed on to callback. */
+  fre_off               base;                  /* Offset in the whole text of the string searched. */
+  size_t                numof_matches;         /* Matches handed to callback. */
+  bool                  stopped;               /* True once callback asked to, or after the first match without /g. */
+
+} fre_scan;
+
+
+/* A matching pattern bound to a text fed a chunk at a time, see fre_stream_feed(). */
+typedef struct fre_stream_tab {
+  fre_scan              scan;
+  char                  *buffer;               /* The text kept, from the byte before start, its context. */
+  size_t                len;                   /* Bytes in buffer. */
+  size_t                size;                  /* Size of buffer. */
+  size_t                start;                 /* Where in buffer the next search begins. */
+  size_t                window;                /* Most bytes kept, without FRE_SCAN_BOUNDED. */
+  bool                  finished;              /* True once fre_stream_finish() was called. */
+
+} fre_patstream;
+
+
+/* One compiled pattern kept in a thread's pattern cache. */
+typedef struct fre_pcache_ent {
+  uint64_t              hash;                  /* Hash of ->pattern, see intern__fre__hash_pattern(). */
+  char                  *pattern;              /* The pattern, as given by the caller of fre_bind(). */
+  fre_pattern           *object;               /* The fre_pattern object returned by the _plp_parser(). */
+  struct fre_pcache_ent *hash_next;            /* Next entry in the same hash bucket. */
+  struct fre_pcache_ent *lru_prev;             /* More recently used entry, NULL for the most recent. */
+  struct fre_pcache_ent *lru_next;             /* Less recently used entry, NULL for the least recent. */
+
+} fre_pcache_entry;
+
+
+/* Per-thread, bounded, least-recently-used cache of compiled patterns. */
+typedef struct fre_pcache_tab {
+  fre_pcache_entry      **buckets;             /* Hash buckets, FRE_PCACHE_BUCKETS of them. */
+  fre_pcache_entry      *lru_head;             /* Most recently used entry. */
+  fre_pcache_entry      *lru_tail;             /* Least recently used entry, the next one to be evicted. */
+  size_t                capacity;              /* Maximum number of entries, 0 disables the cache. */
+  size_t                numof_entries;         /* Current number of entries. */
+  size_t                hits;                  /* Number of lookups that skipped the _plp_parser. */
+  size_t                misses;                /* Number of lookups that had to parse the pattern. */
+
+} fre_pcache;
+
+
 /* Per-thread global sub-match table kept between invocations of fre_bind(). */
 typedef struct fre_pmatch_tab {
-  bool                  fre_saved_object;      /* True when an fre_pattern* has been saved in ->ls_object. */
   int                   lastop_retval;         /* To keep return value of a successful match_op in global operations. */
-  char                  *ls_pattern;           /* Last seen pattern, as given by the caller of fre_bind(). */
-  fre_pattern           *ls_object;            /* Last seen freg_object, as returned by the _plp_parser(). */
-  fre_smatch            **whole_match;         /* Begining/ending positions of every successful matches. */
-  fre_smatch            **sub_match;           /* Begining/ending positions of every parenthesed expressions. */
+  fre_pcache            *pattern_cache;        /* Recently used patterns, to skip parsing recurring ones. */
+  unsigned long         shared_epoch;          /* Non-zero while this thread walks the shared pattern table. */
+  fre_smatch            *whole_match;          /* Begining/ending positions of every successful matches. */
+  fre_smatch            *sub_match;            /* Begining/ending positions of every parenthesed expressions, subm_per_match per match. */
   int                   subm_per_match;        /* Number of submatches per matches. */
   size_t                wm_ind;                /* First free position of whole-match array. */
   size_t                sm_ind;                /* First free position of sub-matches array. */
   size_t                wm_size;               /* Size of whole-match array. */
   size_t                sm_size;               /* Size of sub-match array. */
+  char                  *subs_buffer;          /* Where _substitute_op() builds its new string. */
+  size_t                subs_buffer_size;      /* Size of subs_buffer. */
+  size_t                tr_count;              /* Number of bytes the last transliteration found in its search list. */
+  char                  *tr_result;            /* The string built by the last tr///r. */
+  bool                  tr_has_result;         /* True when the last operation was a tr///r. */
+  size_t                tr_result_size;        /* Size of tr_result. */
+  size_t                result_len;            /* Length of the string left by the last s/// or tr///. */
   
 } fre_pmatch;
 
@@ -138,6 +574,37 @@ typedef struct fre_head_tab {
 } fre_headnodes;
 
 
+/* A parsed pattern of the process-wide pattern table. */
+typedef struct fre_shared_ent {
+  uint64_t              hash;                  /* Hash of ->pattern, see intern__fre__hash_pattern(). */
+  char                  *pattern;              /* The pattern, as given by the library's caller. */
+  fre_pattern           *object;               /* Parsed pattern, only ever cloned, never executed. */
+  unsigned long         refcount;              /* One for the table while linked, one per clone. Atomic. */
+  unsigned long         retire_epoch;          /* Epoch at which the entry was unlinked from the table. */
+  struct fre_shared_ent *hash_next;            /* Next entry of the same bucket. Atomic, readers take no lock. */
+  struct fre_shared_ent *fifo_next;            /* Next entry in insertion order, or on the retired list. */
+
+} fre_shared_entry;
+
+
+/*
+ * Global table of parsed patterns shared by all threads.
+ * Lookups take no lock, insertions and evictions are serialized by ->table_lock.
+ * Unlinked entries sit on ->retired until no reader can still be walking them.
+ */
+typedef struct fre_shared_tab {
+  fre_shared_entry      **buckets;             /* Hash buckets, FRE_SHARED_BUCKETS of them. */
+  fre_shared_entry      *fifo_head;            /* Oldest entry, the next one to be evicted. */
+  fre_shared_entry      *fifo_tail;            /* Newest entry. */
+  fre_shared_entry      *retired;              /* Unlinked entries waiting for readers to move on. */
+  size_t                capacity;              /* Maximum number of linked entries, 0 disables the table. */
+  size_t                numof_entries;         /* Current number of linked entries. */
+  unsigned long         epoch;                 /* Bumped every time an entry is unlinked. Atomic. */
+  pthread_mutex_t       *table_lock;           /* Serializes writers. */
+
+} fre_shared_patterns;
+
+
 
 
 /** Constants **/
@@ -150,9 +617,48 @@ typedef struct fre_head_tab {
 # define FRE_MAX_MATCHES               128     /* Default maximum number of matches. */
 # define FRE_MAX_SUB_MATCHES           32      /* Default maximum number of submatches. */
 # define FRE_HEADNODE_TABLE_SIZE       4       /* Arbitrary. Default number of pmatch_tables in the headnode_table. */
+# define FRE_PCACHE_CAPACITY           16      /* Default number of patterns kept in a thread's pattern cache. */
+# define FRE_PCACHE_BUCKETS            64      /* Number of hash buckets of a pattern cache, a power of 2. */
+# define FRE_SHARED_CAPACITY           1024    /* Default number of patterns kept in the shared pattern table. */
+# define FRE_SHARED_BUCKETS            1024    /* Number of hash buckets of the shared pattern table, a power of 2. */
+# define FRE_PROG_MAX_INSTS            4096    /* Patterns compiling to more instructions are left to regexec(). */
+# define FRE_DFA_DEFAULT_BUDGET        (1 << 21) /* Default bytes a DFA's states may use before they're flushed. */
+# define FRE_BITPAR_MAX_POSITIONS      63      /* Positions of the patterns the bit-parallel scanner takes, bit 0 is the initial state. */
+# define FRE_JIT_MAX_STATES            512     /* DFAs with more states are left to the interpreter. */
+# define FRE_JIT_MAX_BRANCHES          4       /* Classes a state tells apart with branches, a jump table past that. */
+# define FRE_JIT_SKIP_BYTES            4       /* Bytes a state may leave itself on to be compiled to branches. */
+# define FRE_BT_MAX_MEMO_BITS          (1 << 25) /* Longer strings, times instructions, are left to regexec() by the backtracker. */
+# define FRE_BT_STEPS_PER_BIT          16      /* Instructions the backtracker may run per memo bit before it gives up. */
+# define FRE_BT_BLOCKS_BUDGET          (8 << 20) /* Bytes the backtracker's blocks may use before they're forgotten. */
+# define FRE_BT_OVER_BUDGET            2       /* Returned by intern__fre__bt_exec() when it gives up. */
+# define FRE_BT_KEPT_BIT               0       /* An instruction tried at a position has a bit in the backtracker's memo. */
+# define FRE_BT_KEPT_BLOCK             1       /* It has a bit in one of the blocks, with the live slots' values. */
+# define FRE_BT_KEPT_NONE              2       /* It isn't kept, a single instruction leads to it. */
+#ifndef FRE_FILE_WINDOW
+# define FRE_FILE_WINDOW               (16 << 20) /* Bytes of a file searched at once by intern__fre__match_file(), test_DIFF shrinks it. */
+#endif
+# define FRE_STREAM_WINDOW             (1 << 16) /* Most bytes a stream keeps by default, see fre_stream_new(). */
+# define FRE_CTX_EDGE                  0       /* Context of a position: begining or end of the text. */
+# define FRE_CTX_NEWLINE               1       /* Context of a position: next to a newline. */
+# define FRE_CTX_WORD                  2       /* Context of a position: next to a word character. */
+# define FRE_CTX_OTHER                 3       /* Context of a position: next to any other character. */
+# define FRE_DFA_MATCH                 0x1     /* DFA state flag: a match ended right before the last byte. */
+# define FRE_DFA_DEAD                  0x2     /* DFA state flag: no match can begin nor go on from here. */
+# define FRE_DFA_EOT_MATCH             0x4     /* DFA state flag: a match ends if the text ends here. */
+/*
+ * Transitions hold the offset of the next state's row in trans,
+ * stored as -(offset + 1) when that state has FRE_DFA_MATCH or FRE_DFA_DEAD set,
+ * so that the scan only looks at flags when one of these is reached.
+ */
+# define FRE_DFA_ROW(trans)            (((trans) < 0) ? -(trans) - 1 : (trans))
+# define FRE_DFA_UNKNOWN               INT32_MIN /* Transition to a state not built yet. */
+# define FRE_SIMD_SSE2                 0x1     /* fre_simd_features: SSE2 kernels may be used. */
+# define FRE_SIMD_SSSE3                0x2     /* fre_simd_features: SSSE3 kernels may be used. */
 
-/* Must be INT_MAX to safely fetch sub-match(es) position(s). */
-# define FRE_ARG_STRING_MAX_LENGHT     INT_MAX /* Maximum lenght of fre_bind()'s string argument, '\0' included. */
+/* Must fit a fre_off to safely fetch sub-match(es) position(s). */
+# define FRE_ARG_STRING_MAX_LENGHT     ((size_t)FRE_OFF_MAX < SIZE_MAX ? (size_t)FRE_OFF_MAX : SIZE_MAX) /* Maximum lenght of fre_bind()'s string argument, '\0' included. */
+/* Past this offset regexec() can't be asked for sub-matches, nor for the match of a pattern no native engine runs. */
+# define FRE_REGOFF_MAX                ((sizeof(regoff_t) < sizeof(fre_off)) ? (size_t)INT_MAX : FRE_ARG_STRING_MAX_LENGHT)
 
 /* 
  * Successful is set to 1, it makes for prettier 'if' statements. 
@@ -171,12 +677,16 @@ static const char FRE_PAIRED_O_DELIMITERS[]   = "<({[";          /* Opening pair
 static const char FRE_PAIRED_C_DELIMITERS[]   = ">)}]";          /* Closing paired-type delimiters. */
 static const char FRE_POSIX_DIGIT_RANGE[]     = "[[:digit:]]";   /* Used to replace '\d' escape sequence. */
 static const char FRE_POSIX_NON_DIGIT_RANGE[] = "[^[:digit:]]";  /* Used to replace '\D' escape sequence. */
-static const char FRE_POSIX_WORD_CHAR[]       = "[_[:alpha:]]";  /* Used to replace '\w' escape sequence. */
-static const char FRE_POSIX_NON_WORD_CHAR[]   = "[^_[:alpha:]]"; /* Used to replace '\W' escape sequence. */
+static const char FRE_POSIX_WORD_CHAR[]       = "[_[:alnum:]]";  /* Used to replace '\w' escape sequence, the word characters of '\b'. */
+static const char FRE_POSIX_NON_WORD_CHAR[]   = "[^_[:alnum:]]"; /* Used to replace '\W' escape sequence. */
 static const char FRE_POSIX_SPACE_CHAR[]      = "[[:space:]]";   /* Used to replace '\s' escape sequence. */
 static const char FRE_POSIX_NON_SPACE_CHAR[]  = "[^[:space:]]";  /* Used to replace '\S' escape sequence. */
 static const char FRE_POSIX_ALL_BUT_NEWLINE[] = "[^\\n]";         /* Used to replace '\N' escape sequence. */
 extern fre_headnodes *fre_headnode_table;                 /* Global table of linked-lists headnodes, use with care. */
+extern fre_shared_patterns *fre_shared_pattern_table;     /* Global table of parsed patterns shared by all threads. */
+extern int fre_simd_features;                             /* FRE_SIMD_* flags of the running CPU, see fre_internal_simd.c */
+extern size_t fre_dfa_budget;                             /* Budget of the DFAs built from now on, see fre_internal_dfa.c */
+extern bool fre_jit_enabled;                              /* Whether patterns compiled from now on get native code, see fre_internal_jit.c */
 
 /*** Internal function prototypes ***/
 
@@ -191,30 +701,47 @@ void           intern__fre__lib_finit(void);                         /* Free the
 
 fre_backref*   intern__fre__init_bref_arr(void);                     /* Allocate memory to a fre_backref* object. */
 void           intern__fre__free_bref_arr(fre_backref *to_free);     /* Free resources of a fre_backref *. */
-/* There's no _free_smatch(), _free_pmatch_node handles this. */
-fre_smatch*    intern__fre__init_smatch(void);                       /* Allocate memory to a fre_smatch object. */
+void           intern__fre__init_smatch(fre_smatch *list,            /* Mark elements of a [sub]match list as unused. */
+					size_t numof_elements);
 fre_pmatch*    intern__fre__init_pmatch_table(void);
 void           intern__fre__free_pmatch_table(fre_pmatch *node);
 int            intern__fre__extend_ptable_list(int listnum);         /* Extend a pmatch-table's whole/sub_match field. */
+void           intern__fre__reset_pmatch_table(void);                /* Forget the positions of the previous operation. */
 fre_pattern*   intern__fre__init_pattern(void);                      /* Initialize a fre_pattern object. */
+fre_pattern*   intern__fre__clone_pattern(fre_pattern *freg_object); /* Copy a fre_pattern for a thread to execute. */
 void           intern__fre__free_pattern(fre_pattern *freg_object);  /* Release resources of a fre_pattern object */
+fre_replacement* intern__fre__init_replacement(size_t numof_tokens); /* Allocate room for a compiled substitute pattern. */
+fre_replacement* intern__fre__clone_replacement(fre_replacement *repl); /* Copy a compiled substitute pattern. */
+void           intern__fre__free_replacement(fre_replacement *repl); /* Release a compiled substitute pattern. */
 fre_headnodes* intern__fre__init_head_table(void);                   /* Init the global table of headnode pointers. */
 void           intern__fre__free_head_table(void);                   /* Release resources of the global headnode_table. */
 int            intern__fre__push_head(fre_pmatch* head);             /* Add the given headnode to the global headnode_table. */
-void           intern__fre__key_delete(void *key);                   /* To feed pthread_key_create() . */
+void           intern__fre__key_delete(void *key);                   /* Give an exiting thread's pmatch-table back. */
 fre_pmatch*    intern__fre__pmatch_location(void);                   /* To access a thread's pmatch-table. */
 void           intern__fre__clean_head_table(void);                  /* Free memory used by all pmatch-tables created. */
+fre_pcache*    intern__fre__init_pcache(void);                       /* Allocate memory to a pattern cache. */
+void           intern__fre__free_pcache(fre_pcache *cache);          /* Release a pattern cache and all its patterns. */
+fre_shared_patterns* intern__fre__init_shared_table(void);           /* Init the global shared pattern table. */
+void           intern__fre__free_shared_table(void);                 /* Release the global shared pattern table. */
+
+/** Pattern caches. **/
+
+uint64_t       intern__fre__hash_pattern(char *pattern);             /* Hash a pattern string. */
+fre_pattern*   intern__fre__pcache_lookup(char *pattern);            /* Find or parse a pattern, via the thread's cache. */
+int            intern__fre__pcache_resize(fre_pcache *cache,         /* Change a cache's capacity, evicting as needed. */
+					  size_t capacity);
+fre_pattern*   intern__fre__shared_lookup(char *pattern);            /* Clone a pattern from the shared table. */
+void           intern__fre__shared_release(fre_shared_entry *entry); /* Drop a reference to a shared entry. */
+int            intern__fre__shared_resize(size_t capacity);          /* Change the shared table's capacity. */
+void           intern__fre__free_shared_entry(fre_shared_entry *entry); /* Release a shared entry and its pattern. */
 
 int            intern__fre__compile_pattern(fre_pattern *freg_object);/* Compile the modified pattern. */
-int            intern__fre__insert_sm(fre_pattern *freg_object,       /* Insert all sub-matches in the given pattern. */
-				      char *string,
-				      int numof_tokens,
-				      size_t is_sub);
-char*          intern__fre__cut_match(char *string,                   /* Remove a character sequence from a string. */
-				      size_t *numof_tokens_skiped,
-				      size_t string_size,
-				      size_t bo,
-				      size_t eo);
+int            intern__fre__exec_match(fre_pattern *freg_object,      /* Find the leftmost match at or after start. */
+				       char *string,
+				       size_t string_len,
+				       size_t start,
+				       fre_smatch *match_arr,
+				       size_t numof_sm);
 
 /* DEBUG only. */
 void print_pattern_hook(fre_pattern* pat);
@@ -230,19 +757,168 @@ int          intern__fre__split_pattern(char * pattern,            /* Strip a pa
 					size_t token_ind);
 int          intern__fre__perl_to_posix(fre_pattern *freg_object, /* Convert Perl-like constructs into POSIX constructs. */
 					size_t is_sub);
+int          intern__fre__compile_replacement(fre_pattern *freg_object); /* Compile the substitute pattern into segments. */
+int          intern__fre__compile_translit(fre_pattern *freg_object);    /* Compile a transliteration into a byte map. */
 					
 /** Regex operations routines. **/
 int          intern__fre__match_op(char *string,                   /* Execute a match operation. */			  
+				   size_t string_len,
 				   fre_pattern *freg_object,
-				   size_t *offset_to_start);
+				   size_t offset_to_start);
 int          intern__fre__substitute_op(char *string,              /* Execute a substitution operation. */
+					size_t string_len,
 					size_t string_size,
 					fre_pattern *freg_object,
-				        size_t *offset_to_start);
+				        size_t offset_to_start);
 int          intern__fre__transliterate_op(char *string,           /* Execute a transliteration operation. */
-					   size_t string_size,
+					   size_t string_len,
 					   fre_pattern *freg_object);
 
+/** Native engines. **/
+int          intern__fre__parse_ere(const char *pattern,            /* Parse a POSIX ERE into a tree. */
+				    bool icase,
+				    bool newline,
+				    fre_ast_tree **tree);
+void         intern__fre__free_ast(fre_ast_tree *tree);            /* Release a parsed POSIX ERE. */
+fre_prog*    intern__fre__compile_prog(fre_ast_tree *tree,         /* Compile a parsed POSIX ERE into a program. */
+				       bool reverse);
+fre_prog*    intern__fre__combine_progs(fre_prog **progs,          /* Put programs side by side into one. */
+					const int *ids,
+					size_t numof_progs);
+fre_prog*    intern__fre__clone_prog(fre_prog *prog);              /* Copy a program. */
+void         intern__fre__free_prog(fre_prog *prog);               /* Release a program. */
+fre_literal* intern__fre__extract_literal(fre_ast_tree *tree);     /* Find the literal every match contains. */
+int          intern__fre__compile_literal(fre_pattern *freg_object);/* Take a plain literal pattern off regcomp(). */
+int          intern__fre__literal_char(const char *pattern,        /* The byte of a pattern's literal character. */
+					size_t *pos);
+int          intern__fre__compile_native(fre_pattern *freg_object);/* Pick and prepare the engine of a pattern. */
+int          intern__fre__exec_native(fre_pattern *freg_object,    /* Find the leftmost-longest match with a native engine. */
+				      char *string,
+				      size_t string_len,
+				      size_t start,
+				      fre_smatch *match);
+ssize_t      intern__fre__max_match_len(fre_pattern *freg_object); /* Lenght of a pattern's longest match, or -1. */
+bool         intern__fre__matches_byte(fre_pattern *freg_object,   /* Whether a match of a pattern may hold byte. */
+				       unsigned char byte);
+fre_dfa*     intern__fre__dfa_build(fre_prog *prog,                /* Prepare the (lazy) DFA of a program. */
+				    bool anchored);
+fre_dfa*     intern__fre__clone_dfa(fre_dfa *dfa,                  /* A DFA like dfa, for the given copy of its program. */
+				    fre_prog *prog);
+fre_dfa*     intern__fre__set_dfa_build(fre_prog *prog);           /* Prepare the (lazy) DFA of combined programs. */
+void         intern__fre__free_dfa(fre_dfa *dfa);                  /* Release a DFA. */
+int          intern__fre__dfa_complete(fre_dfa *dfa,               /* Build every state of a DFA, if there aren't too many. */
+				       size_t max_states);
+bool         intern__fre__assert_holds(int assertion,              /* Whether an assertion holds between two contexts. */
+				       int prev,
+				       int next);
+int          intern__fre__dfa_exec(fre_pattern *freg_object,       /* Leftmost-longest match of a DFA-backed pattern. */
+				   const unsigned char *string,
+				   size_t string_len,
+				   size_t start,
+				   fre_smatch *match);
+int          intern__fre__set_dfa_exec(fre_dfa *dfa,               /* Which of the combined programs match string. */
+				       const unsigned char *string,
+				       size_t string_len,
+				       fre_smatch *found,
+				       size_t numof_left);
+int          intern__fre__compile_ac(fre_pattern *freg_object);    /* Take an alternation of literals off regcomp(). */
+fre_jit_code* intern__fre__jit_build(fre_pattern *freg_object);    /* Native code for the forward scan of a pattern's DFA. */
+fre_jit_code* intern__fre__clone_jit(fre_jit_code *jit);           /* Copy native code. */
+void         intern__fre__free_jit(fre_jit_code *jit);             /* Release native code. */
+fre_ac*      intern__fre__clone_ac(fre_ac *ac);                    /* Copy an Aho-Corasick automaton. */
+void         intern__fre__free_ac(fre_ac *ac);                     /* Release an Aho-Corasick automaton. */
+int          intern__fre__ac_exec(fre_ac *ac,                      /* Leftmost-longest occurrence of any of the literals. */
+				  const unsigned char *string,
+				  size_t string_len,
+				  size_t start,
+				  fre_smatch *match);
+fre_bt*      intern__fre__bt_build(fre_prog *prog,                 /* Prepare the backtracker of a program. */
+				   bool icase);
+fre_bt*      intern__fre__clone_bt(fre_bt *bt,                     /* A backtracker like bt, for the given copy of its program. */
+				   fre_prog *prog);
+void         intern__fre__free_bt(fre_bt *bt);                     /* Release a backtracker. */
+int          intern__fre__bt_exec(fre_bt *bt,                      /* Leftmost-longest match and sub-matches, with back-references. */
+				  const unsigned char *string,
+				  size_t string_len,
+				  size_t start,
+				  fre_smatch *match_arr,
+				  size_t numof_sm);
+fre_bitpar*  intern__fre__bitpar_build(fre_ast_tree *tree);        /* The Glushkov automaton of a short pattern. */
+fre_bitpar*  intern__fre__clone_bitpar(fre_bitpar *bitpar);        /* Copy a Glushkov automaton. */
+void         intern__fre__free_bitpar(fre_bitpar *bitpar);         /* Release a Glushkov automaton. */
+int          intern__fre__bitpar_exec(fre_bitpar *bitpar,          /* Whether a match ends in string, and where the leftmost may begin. */
+				      const unsigned char *string,
+				      size_t string_len,
+				      size_t start,
+				      size_t *restart);
+fre_pike*    intern__fre__pike_build(fre_prog *prog);              /* Prepare the Pike VM of a program. */
+fre_pike*    intern__fre__clone_pike(fre_pike *pike,               /* A Pike VM like pike, for the given copy of its program. */
+				     fre_prog *prog);
+void         intern__fre__free_pike(fre_pike *pike);               /* Release a Pike VM. */
+int          intern__fre__pike_exec(fre_pike *pike,                /* Leftmost-longest match and sub-matches, in linear time. */
+				    const unsigned char *string,
+				    size_t string_len,
+				    size_t start,
+				    size_t stop,
+				    bool anchored,
+				    fre_smatch *match_arr,
+				    size_t numof_sm);
+
+/** Pattern sets. **/
+fre_patset*  intern__fre__set_compile(char **patterns,             /* Parse and combine matching patterns. */
+				      size_t numof_patterns);
+int          intern__fre__set_exec(fre_patset *set,                /* Which of a set's patterns match string. */
+				   char *string,
+				   size_t string_len,
+				   size_t *ids,
+				   fre_off *offsets);
+void         intern__fre__free_set(fre_patset *set);               /* Release a pattern set. */
+
+/** Files, streams and lines. **/
+void         intern__fre__scan_init(fre_scan *scan,                /* Prepare a pattern to search a text a window at a time. */
+				    fre_pattern *freg_object,
+				    bool whole,
+				    size_t window,
+				    fre_match_callback callback,
+				    void *arg);
+int          intern__fre__scan(fre_scan *scan,                     /* Hand the final matches found in a window to the callback. */
+			       const char *string,
+			       size_t string_len,
+			       bool at_end,
+			       size_t *start);
+int          intern__fre__match_file(fre_pattern *freg_object,     /* Hand each match in a mapped file to a callback. */
+				     const char *path,
+				     fre_match_callback callback,
+				     void *arg);
+fre_patstream* intern__fre__stream_new(fre_pattern *freg_object,   /* Bind a pattern to a text fed a chunk at a time. */
+				       size_t window,
+				       fre_match_callback callback,
+				       void *arg);
+int          intern__fre__stream_feed(fre_patstream *stream,       /* Search the next chunk of a stream. */
+				      const char *buf,
+				      size_t len);
+int          intern__fre__stream_finish(fre_patstream *stream);    /* Search what a stream kept, as its end. */
+void         intern__fre__free_stream(fre_patstream *stream);      /* Release a stream. */
+int          intern__fre__grep_lines(fre_pattern *freg_object,     /* Select the lines of a buffer a pattern matches. */
+				     const char *buf,
+				     size_t len,
+				     bool invert,
+				     fre_line *lines,
+				     size_t numof_lines,
+				     fre_line_callback callback,
+				     void *arg,
+				     size_t *numof_selected);
+
+/** SIMD kernels. **/
+void         intern__fre__simd_init(void);                         /* Find out which kernels the CPU can run. */
+const unsigned char* intern__fre__find_literal(const unsigned char *string, /* First occurrence of a literal in string. */
+					       size_t string_len,
+					       const fre_literal *lit);
+size_t       intern__fre__translit_map(unsigned char *dest,        /* Map every byte of string to dest, count those in the search list. */
+				       const unsigned char *string,
+				       size_t string_len,
+				       const fre_translit *tr);
+
 /* Thread specific pmatch-table. */
 #define fre_pmatch_table (intern__fre__pmatch_location())
 
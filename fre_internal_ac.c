@@ -0,0 +1,276 @@
+/*
+ *
+ *  Libfre  -  Aho-Corasick matching engine.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <ctype.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+/*
+ * Build the automaton of the given literals, laid back to back in words,
+ * where word_end[N] is where the Nth one ends. fold gives the byte each
+ * byte of the input is compared as.
+ */
+static fre_ac* intern__fre__ac_build(const unsigned char *words,
+				     const size_t *word_end,
+				     size_t numof_words,
+				     const unsigned char *fold)
+{
+  size_t i = 0, w = 0, c = 0, head = 0, tail = 0;
+  size_t numof_states = 1, max_states = 0, nc = 0;
+  int32_t state = 0, next = 0;
+  int32_t *delta = NULL, *fail = NULL, *queue = NULL;
+  uint8_t fold_class[256];
+  fre_ac *ac = NULL;
+
+  if ((ac = calloc(1, sizeof(fre_ac))) == NULL){
+    intern__fre__errmesg("Calloc");
+    return NULL;
+  }
+  /* Class 0 is every byte no literal has, the others one folded byte each. */
+  memset(fold_class, 0, sizeof(fold_class));
+  nc = 1;
+  for (i = 0; i < word_end[numof_words - 1]; i++)
+    if (fold_class[words[i]] == 0)
+      fold_class[words[i]] = (uint8_t)nc++;
+  for (c = 0; c < 256; c++)
+    ac->byte_class[c] = fold_class[fold[c]];
+  ac->numof_classes = nc;
+
+  max_states = word_end[numof_words - 1] + 1;
+  if ((delta = malloc(max_states * nc * sizeof(int32_t))) == NULL
+      || (fail = malloc(max_states * sizeof(int32_t))) == NULL
+      || (queue = malloc(max_states * sizeof(int32_t))) == NULL
+      || (ac->out_len = calloc(max_states, sizeof(uint16_t))) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  memset(delta, 0xff, max_states * nc * sizeof(int32_t));
+
+  /* The trie of the literals. */
+  for (w = 0, i = 0; w < numof_words; w++){
+    state = 0;
+    for (; i < word_end[w]; i++){
+      c = fold_class[words[i]];
+      if (delta[state * nc + c] == -1)
+	delta[state * nc + c] = (int32_t)numof_states++;
+      state = delta[state * nc + c];
+    }
+    ac->out_len[state] = (uint16_t)(word_end[w] - ((w > 0) ? word_end[w-1] : 0));
+    if (ac->out_len[state] > ac->max_len)
+      ac->max_len = ac->out_len[state];
+  }
+
+  /*
+   * Breadth first, each missing edge goes where the failure link's does,
+   * and a state ends the longest literal its failure link's state ends, unless it ends one itself.
+   */
+  fail[0] = 0;
+  for (c = 0; c < nc; c++){
+    if ((next = delta[c]) == -1)
+      delta[c] = 0;
+    else {
+      fail[next] = 0;
+      queue[tail++] = next;
+    }
+  }
+  while (head < tail){
+    state = queue[head++];
+    if (ac->out_len[state] == 0)
+      ac->out_len[state] = ac->out_len[fail[state]];
+    for (c = 0; c < nc; c++){
+      if ((next = delta[state * nc + c]) == -1)
+	delta[state * nc + c] = delta[fail[state] * nc + c];
+      else {
+	fail[next] = delta[fail[state] * nc + c];
+	queue[tail++] = next;
+      }
+    }
+  }
+
+  /* Row offsets, negative for states ending a literal, as the DFA has them. */
+  if ((ac->trans = malloc(numof_states * nc * sizeof(int32_t))) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  for (i = 0; i < numof_states * nc; i++){
+    next = delta[i];
+    ac->trans[i] = ((ac->out_len[next] != 0) ? -(next * (int32_t)nc) - 1 : next * (int32_t)nc);
+  }
+  ac->numof_states = numof_states;
+  free(delta);
+  free(fail);
+  free(queue);
+  return ac;
+
+ errjmp:
+  if (delta != NULL)
+    free(delta);
+  if (fail != NULL)
+    free(fail);
+  if (queue != NULL)
+    free(queue);
+  intern__fre__free_ac(ac);
+  return NULL;
+
+} /* intern__fre__ac_build() */
+
+
+/*
+ * Give a matching pattern that's an alternation of plain literals,
+ * optionally parenthesized as a whole, to FRE_ENGINE_AC.
+ * Like FRE_ENGINE_LITERAL, the pattern is never handed to regcomp().
+ * Returns FRE_OP_UNSUCCESSFUL for any other pattern.
+ */
+int intern__fre__compile_ac(fre_pattern *freg_object)
+{
+  size_t pos = 0, numof_words = 0, len = 0, c = 0;
+  int byte = 0;
+  bool grouped = false;
+  const char *p = NULL;
+  unsigned char words[FRE_MAX_PATTERN_LENGHT];
+  size_t word_end[FRE_MAX_PATTERN_LENGHT];
+  unsigned char fold[256];
+
+  if (!freg_object){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  if (freg_object->fre_op_flag == TRANSLITERATE
+      || freg_object->backref_pos->in_pattern_c > 0
+      || MB_CUR_MAX != 1)
+    return FRE_OP_UNSUCCESSFUL;
+
+  /* REG_ICASE compares bytes once tolower()'d. */
+  for (c = 0; c < 256; c++)
+    fold[c] = (unsigned char)((freg_object->fre_mod_icase) ? tolower((int)c) : (int)c);
+  p = freg_object->striped_pattern[0];
+  if (p[0] == '('){
+    grouped = true;
+    ++pos;
+  }
+  while (1){
+    while ((byte = intern__fre__literal_char(p, &pos)) != -1 && len < FRE_MAX_PATTERN_LENGHT)
+      words[len++] = fold[byte];
+    /* No empty literal, these match everywhere. */
+    if (byte != -1 || len == ((numof_words > 0) ? word_end[numof_words - 1] : 0))
+      return FRE_OP_UNSUCCESSFUL;
+    word_end[numof_words++] = len;
+    if (p[pos] == '|'){
+      ++pos;
+      continue;
+    }
+    if (grouped && p[pos] == ')' && p[pos+1] == '\0')
+      break;
+    if (!grouped && p[pos] == '\0')
+      break;
+    return FRE_OP_UNSUCCESSFUL;
+  }
+
+  if ((freg_object->ac = intern__fre__ac_build(words, word_end, numof_words, fold)) == NULL)
+    return FRE_ERROR;
+  freg_object->ac->grouped = grouped;
+  freg_object->numof_groups = ((grouped) ? 1 : 0);
+  freg_object->engine = FRE_ENGINE_AC;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__compile_ac() */
+
+
+/* Copy an Aho-Corasick automaton. */
+fre_ac* intern__fre__clone_ac(fre_ac *ac)
+{
+  fre_ac *clone = NULL;
+
+  if (ac == NULL){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((clone = malloc(sizeof(fre_ac))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return NULL;
+  }
+  *clone = *ac;
+  clone->trans = NULL;
+  clone->out_len = NULL;
+  if ((clone->trans = malloc(ac->numof_states * ac->numof_classes * sizeof(int32_t))) == NULL
+      || (clone->out_len = malloc(ac->numof_states * sizeof(uint16_t))) == NULL){
+    intern__fre__errmesg("Malloc");
+    intern__fre__free_ac(clone);
+    return NULL;
+  }
+  memcpy(clone->trans, ac->trans, ac->numof_states * ac->numof_classes * sizeof(int32_t));
+  memcpy(clone->out_len, ac->out_len, ac->numof_states * sizeof(uint16_t));
+  return clone;
+
+} /* intern__fre__clone_ac() */
+
+
+/* Release an Aho-Corasick automaton. */
+void intern__fre__free_ac(fre_ac *ac)
+{
+  if (ac == NULL)
+    return;
+  if (ac->trans != NULL)
+    free(ac->trans);
+  if (ac->out_len != NULL)
+    free(ac->out_len);
+  free(ac);
+
+} /* intern__fre__free_ac() */
+
+
+/*
+ * Find the leftmost-longest occurrence of any of the literals at or after start,
+ * as regexec() would for their alternation. Once an occurrence is found,
+ * the scan goes on only as far as one beginning at or before it could end.
+ */
+int intern__fre__ac_exec(fre_ac *ac,
+			 const unsigned char *string,
+			 size_t string_len,
+			 size_t start,
+			 fre_smatch *match)
+{
+  size_t i = 0, bo = 0, stop = string_len;
+  size_t best_bo = SIZE_MAX, best_eo = 0;
+  int32_t row = 0, next = 0;
+  const int32_t *trans = ac->trans;
+  const uint8_t *byte_class = ac->byte_class;
+
+  if (!string || !match || start > string_len){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  for (i = start; i < stop; i++){
+    if ((next = trans[row + byte_class[string[i]]]) >= 0){
+      row = next;
+      continue;
+    }
+    row = FRE_DFA_ROW(next);
+    bo = i + 1 - ac->out_len[(size_t)row / ac->numof_classes];
+    /* An earlier begining, or the same one and a longer match. */
+    if (best_bo == SIZE_MAX || bo <= best_bo){
+      best_bo = bo;
+      best_eo = i + 1;
+      if (best_bo + ac->max_len < stop)
+	stop = best_bo + ac->max_len;
+    }
+  }
+  if (best_bo == SIZE_MAX)
+    return FRE_OP_UNSUCCESSFUL;
+  match->bo = (fre_off)best_bo;
+  match->eo = (fre_off)best_eo;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__ac_exec() */
@@ -0,0 +1,556 @@
+/*
+ *
+ *  Libfre  -  Backtracking engine, for patterns with back-references.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <ctype.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+#define FRE_SET_HAS(set, byte) ((set)[(byte) >> 3] & (1u << ((byte) & 7)))
+
+/* Context of the byte at string[pos], FRE_CTX_EDGE outside of string. */
+#define FRE_BT_CTX(prog, string, string_len, pos)			\
+  (((pos) < 0 || (size_t)(pos) >= (string_len)) ? FRE_CTX_EDGE		\
+   : (prog)->class_ctx[(prog)->byte_class[(string)[(pos)]]])
+
+
+/*
+ * Find the back-referenced slots live at each instruction: those a back-reference
+ * may read on some path from it, before an instruction saves them again,
+ * and how tries of the instruction are kept.
+ */
+static void intern__fre__bt_liveness(fre_bt *bt,
+				     int *numof_ins)
+{
+  size_t k = 0, s = 0, numof_slots = bt->numof_slots;
+  int pc = 0;
+  bool changed = true, live = false;
+  const fre_inst *inst = NULL;
+  fre_prog *prog = bt->prog;
+
+  while (changed){
+    changed = false;
+    for (pc = (int)prog->numof_insts - 1; pc >= 0; pc--){
+      inst = &prog->insts[pc];
+      for (k = 0; k < bt->numof_ref_slots; k++){
+	s = (size_t)bt->ref_slots[k];
+	if (bt->live[(size_t)pc * numof_slots + s])
+	  continue;
+	switch (inst->op){
+	case FRE_I_BREF:
+	  live = (s == 2 * (size_t)inst->arg || s == 2 * (size_t)inst->arg + 1
+		  || bt->live[(size_t)inst->out * numof_slots + s]);
+	  break;
+	case FRE_I_SAVE:
+	  live = (s != (size_t)inst->arg && bt->live[(size_t)inst->out * numof_slots + s]);
+	  break;
+	case FRE_I_SPLIT:
+	  live = (bt->live[(size_t)inst->out * numof_slots + s]
+		  || bt->live[(size_t)inst->out1 * numof_slots + s]);
+	  break;
+	case FRE_I_BYTES:
+	case FRE_I_ASSERT:
+	  live = bt->live[(size_t)inst->out * numof_slots + s];
+	  break;
+	default:
+	  live = false;
+	  break;
+	}
+	if (live){
+	  bt->live[(size_t)pc * numof_slots + s] = true;
+	  changed = true;
+	}
+      }
+    }
+  }
+
+  for (pc = 0; pc < (int)prog->numof_insts; pc++){
+    inst = &prog->insts[pc];
+    if (inst->op != FRE_I_MATCH)
+      ++numof_ins[inst->out];
+    if (inst->op == FRE_I_SPLIT)
+      ++numof_ins[inst->out1];
+  }
+  for (pc = 0; pc < (int)prog->numof_insts; pc++){
+    for (k = 0; k < bt->numof_ref_slots; k++)
+      if (bt->live[(size_t)pc * numof_slots + (size_t)bt->ref_slots[k]])
+	break;
+    if (k == bt->numof_ref_slots)
+      bt->kept[pc] = FRE_BT_KEPT_BIT;
+    else
+      bt->kept[pc] = ((numof_ins[pc] > 1) ? FRE_BT_KEPT_BLOCK : FRE_BT_KEPT_NONE);
+  }
+
+} /* intern__fre__bt_liveness() */
+
+
+/* Prepare the backtracker of a program, its memo is allocated by the first scan. */
+fre_bt* intern__fre__bt_build(fre_prog *prog,
+			      bool icase)
+{
+  size_t i = 0;
+  int *numof_ins = NULL;
+  fre_bt *bt = NULL;
+
+  if (!prog){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((bt = calloc(1, sizeof(fre_bt))) == NULL){
+    intern__fre__errmesg("Calloc");
+    return NULL;
+  }
+  bt->prog = prog;
+  bt->icase = icase;
+  bt->numof_slots = 2 * (prog->numof_groups + 1);
+  bt->jobs_size = 64;
+  if ((bt->referenced = calloc(bt->numof_slots, sizeof(bool))) == NULL
+      || (bt->caps = malloc(bt->numof_slots * sizeof(int))) == NULL
+      || (bt->best = malloc(bt->numof_slots * sizeof(int))) == NULL
+      || (bt->jobs = malloc(bt->jobs_size * sizeof(fre_bt_job))) == NULL){
+    intern__fre__errmesg("Malloc");
+    intern__fre__free_bt(bt);
+    return NULL;
+  }
+  for (i = 0; i < bt->numof_slots; i++)
+    bt->caps[i] = -1;
+  for (i = 0; i < prog->numof_insts; i++){
+    if (prog->insts[i].op == FRE_I_BREF){
+      bt->referenced[2 * prog->insts[i].arg] = true;
+      bt->referenced[2 * prog->insts[i].arg + 1] = true;
+    }
+  }
+  if ((bt->ref_slots = malloc(bt->numof_slots * sizeof(int))) == NULL
+      || (bt->live = calloc(prog->numof_insts * bt->numof_slots, sizeof(bool))) == NULL
+      || (bt->kept = malloc(prog->numof_insts)) == NULL
+      || (bt->last_block = malloc(prog->numof_insts * sizeof(int))) == NULL
+      || (numof_ins = calloc(prog->numof_insts, sizeof(int))) == NULL){
+    intern__fre__errmesg("Malloc");
+    intern__fre__free_bt(bt);
+    return NULL;
+  }
+  for (i = 0; i < bt->numof_slots; i++)
+    if (bt->referenced[i])
+      bt->ref_slots[bt->numof_ref_slots++] = (int)i;
+  for (i = 0; i < prog->numof_insts; i++)
+    bt->last_block[i] = -1;
+  intern__fre__bt_liveness(bt, numof_ins);
+  free(numof_ins);
+  return bt;
+
+} /* intern__fre__bt_build() */
+
+
+/* A backtracker like bt, for the given copy of its program. */
+fre_bt* intern__fre__clone_bt(fre_bt *bt,
+			      fre_prog *prog)
+{
+  if (!bt || !prog){
+    errno = EINVAL;
+    return NULL;
+  }
+  return intern__fre__bt_build(prog, bt->icase);
+
+} /* intern__fre__clone_bt() */
+
+
+/* Release a backtracker. */
+void intern__fre__free_bt(fre_bt *bt)
+{
+  if (bt == NULL)
+    return;
+  if (bt->referenced != NULL)
+    free(bt->referenced);
+  if (bt->live != NULL)
+    free(bt->live);
+  if (bt->kept != NULL)
+    free(bt->kept);
+  if (bt->ref_slots != NULL)
+    free(bt->ref_slots);
+  if (bt->blocks != NULL)
+    free(bt->blocks);
+  if (bt->block_bits != NULL)
+    free(bt->block_bits);
+  if (bt->last_block != NULL)
+    free(bt->last_block);
+  if (bt->caps != NULL)
+    free(bt->caps);
+  if (bt->best != NULL)
+    free(bt->best);
+  if (bt->memo != NULL)
+    free(bt->memo);
+  if (bt->dirty != NULL)
+    free(bt->dirty);
+  if (bt->jobs != NULL)
+    free(bt->jobs);
+  free(bt);
+
+} /* intern__fre__free_bt() */
+
+
+/* Forget the blocks. */
+static void intern__fre__bt_forget_blocks(fre_bt *bt)
+{
+  size_t pc = 0;
+
+  if (bt->blocks != NULL)
+    memset(bt->blocks, 0xff, bt->blocks_size * (2 + bt->numof_ref_slots) * sizeof(int));
+  for (pc = 0; pc < bt->prog->numof_insts; pc++)
+    bt->last_block[pc] = -1;
+  bt->numof_blocks = 0;
+
+} /* intern__fre__bt_forget_blocks() */
+
+
+/*
+ * Clear the memo, only the words set since it was last cleared, and the blocks.
+ * Those grown past a few pages are let go, for the next scan to regrow.
+ */
+static void intern__fre__bt_forget(fre_bt *bt)
+{
+  while (bt->numof_dirty > 0)
+    bt->memo[bt->dirty[--bt->numof_dirty]] = 0;
+  if (bt->numof_blocks == 0)
+    return;
+  if (bt->blocks_size > 4096){
+    free(bt->blocks);
+    free(bt->block_bits);
+    bt->blocks = NULL;
+    bt->block_bits = NULL;
+    bt->blocks_size = 0;
+  }
+  intern__fre__bt_forget_blocks(bt);
+
+} /* intern__fre__bt_forget() */
+
+
+/* Hash of the key of a block, FNV-1a over its ints. */
+static inline uint64_t intern__fre__bt_hash(const int *key,
+					    size_t key_len)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  size_t i = 0;
+
+  for (i = 0; i < key_len; i++){
+    hash ^= (uint32_t)key[i];
+    hash *= 1099511628211ULL;
+  }
+  return (hash ^ (hash >> 32));
+
+} /* intern__fre__bt_hash() */
+
+
+/*
+ * Find key in the blocks, or add it with all its bits clear.
+ * They only save work: once they'd use more than FRE_BT_BLOCKS_BUDGET bytes,
+ * they're all forgotten, and added again from there.
+ * Returns the index of the block, FRE_ERROR when out of memory.
+ */
+static int intern__fre__bt_block(fre_bt *bt,
+				 const int *key)
+{
+  size_t i = 0, idx = 0, size = 0, key_len = 2 + bt->numof_ref_slots;
+  int *slot = NULL, *temp = NULL;
+  uint64_t *bits = NULL;
+
+  if (bt->numof_blocks > 0){
+    idx = intern__fre__bt_hash(key, key_len) & (bt->blocks_size - 1);
+    while ((slot = bt->blocks + idx * key_len)[0] >= 0){
+      if (memcmp(slot, key, key_len * sizeof(int)) == 0)
+	return (int)idx;
+      idx = (idx + 1) & (bt->blocks_size - 1);
+    }
+    if (2 * (bt->numof_blocks + 1) * (key_len * sizeof(int) + sizeof(uint64_t)) > FRE_BT_BLOCKS_BUDGET)
+      intern__fre__bt_forget_blocks(bt);
+  }
+
+  if (2 * (bt->numof_blocks + 1) > bt->blocks_size){
+    size = ((bt->blocks_size > 0) ? 2 * bt->blocks_size : 64);
+    if ((temp = malloc(size * key_len * sizeof(int))) == NULL
+	|| (bits = malloc(size * sizeof(uint64_t))) == NULL){
+      if (temp != NULL)
+	free(temp);
+      intern__fre__errmesg("Malloc");
+      return FRE_ERROR;
+    }
+    memset(temp, 0xff, size * key_len * sizeof(int));
+    for (i = 0; i < bt->blocks_size; i++){
+      slot = bt->blocks + i * key_len;
+      if (slot[0] < 0)
+	continue;
+      idx = intern__fre__bt_hash(slot, key_len) & (size - 1);
+      while (temp[idx * key_len] >= 0)
+	idx = (idx + 1) & (size - 1);
+      memcpy(temp + idx * key_len, slot, key_len * sizeof(int));
+      bits[idx] = bt->block_bits[i];
+    }
+    if (bt->blocks != NULL){
+      free(bt->blocks);
+      free(bt->block_bits);
+    }
+    bt->blocks = temp;
+    bt->block_bits = bits;
+    bt->blocks_size = size;
+    for (i = 0; i < bt->prog->numof_insts; i++)
+      bt->last_block[i] = -1;
+  }
+
+  idx = intern__fre__bt_hash(key, key_len) & (bt->blocks_size - 1);
+  while (bt->blocks[idx * key_len] >= 0)
+    idx = (idx + 1) & (bt->blocks_size - 1);
+  memcpy(bt->blocks + idx * key_len, key, key_len * sizeof(int));
+  bt->block_bits[idx] = 0;
+  ++bt->numof_blocks;
+  return (int)idx;
+
+} /* intern__fre__bt_block() */
+
+
+/*
+ * Set the bit of pc at pos in its block, with the values of the slots live there.
+ * FRE_OP_UNSUCCESSFUL when it already was.
+ */
+static int intern__fre__bt_visit(fre_bt *bt,
+				 int pc,
+				 int pos)
+{
+  size_t k = 0, key_len = 2 + bt->numof_ref_slots;
+  int key[2 + 2 * FRE_MAX_SUB_MATCHES];
+  int idx = bt->last_block[pc];
+  uint64_t bit = (uint64_t)1 << (pos & 63);
+  const bool *live = bt->live + (size_t)pc * bt->numof_slots;
+
+  key[0] = pc;
+  for (k = 0; k < bt->numof_ref_slots; k++)
+    key[1 + k] = (live[bt->ref_slots[k]] ? bt->caps[bt->ref_slots[k]] : -2);
+  key[key_len - 1] = pos / 64;
+  /* Paths mostly go on in the block pc was last tried in. */
+  if (idx < 0 || memcmp(bt->blocks + (size_t)idx * key_len, key, key_len * sizeof(int)) != 0){
+    if ((idx = intern__fre__bt_block(bt, key)) == FRE_ERROR)
+      return FRE_ERROR;
+    bt->last_block[pc] = idx;
+  }
+  if (bt->block_bits[idx] & bit)
+    return FRE_OP_UNSUCCESSFUL;
+  bt->block_bits[idx] |= bit;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__bt_visit() */
+
+
+/* Push a choice to try, or a capture slot to restore (pc -1). */
+static int intern__fre__bt_push(fre_bt *bt,
+				int pc,
+				int pos,
+				int slot)
+{
+  fre_bt_job *temp = NULL;
+
+  if (bt->numof_jobs == bt->jobs_size){
+    if ((temp = realloc(bt->jobs, bt->jobs_size * 2 * sizeof(fre_bt_job))) == NULL){
+      intern__fre__errmesg("Realloc");
+      return FRE_ERROR;
+    }
+    bt->jobs = temp;
+    bt->jobs_size *= 2;
+  }
+  bt->jobs[bt->numof_jobs].pc = pc;
+  bt->jobs[bt->numof_jobs].pos = pos;
+  bt->jobs[bt->numof_jobs].slot = slot;
+  ++bt->numof_jobs;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__bt_push() */
+
+
+/*
+ * Find the leftmost-longest match at or after start, trying the program's paths
+ * depth first, greedy repetitions and left alternatives first. The sub-matches
+ * are those of the first path found reaching the end of the longest match.
+ * Each instruction is tried at most once per position and values of the
+ * back-referenced slots it may still read, the others can't change where a
+ * path may go. That's O(n * m) instructions without such slots, O(n^(g + 1) * m)
+ * when g groups are back-referenced.
+ * Returns FRE_BT_OVER_BUDGET when string is too long for the memo,
+ * or when more instructions than that ran: regexec() is left to take over.
+ */
+int intern__fre__bt_exec(fre_bt *bt,
+			 const unsigned char *string,
+			 size_t string_len,
+			 size_t start,
+			 fre_smatch *match_arr,
+			 size_t numof_sm)
+{
+  size_t i = 0, bo = 0, idx = 0, n = 0, numof_insts = 0;
+  size_t numof_bits = 0, numof_words = 0, steps = 0, max_steps = 0;
+  int pc = 0, pos = 0, best_end = -1, cap_bo = 0, cap_eo = 0, ret = 0;
+  uint64_t bit = 0;
+  fre_bt_job job;
+  const fre_inst *inst = NULL;
+  fre_prog *prog = NULL;
+
+  if (!bt || !string || !match_arr || start > string_len || numof_sm == 0){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  prog = bt->prog;
+  numof_insts = prog->numof_insts;
+  if (string_len >= INT_MAX || (string_len + 1) > FRE_BT_MAX_MEMO_BITS / numof_insts)
+    return FRE_BT_OVER_BUDGET;
+  numof_bits = (string_len + 1) * numof_insts;
+  numof_words = (numof_bits + 63) / 64;
+  /* The memo is all clear in between scans. */
+  if (numof_words > bt->memo_words){
+    if (bt->memo != NULL)
+      free(bt->memo);
+    if (bt->dirty != NULL)
+      free(bt->dirty);
+    bt->dirty = NULL;
+    bt->memo_words = 0;
+    if ((bt->memo = calloc(numof_words, sizeof(uint64_t))) == NULL
+	|| (bt->dirty = malloc(numof_words * sizeof(size_t))) == NULL){
+      intern__fre__errmesg("Malloc");
+      return FRE_ERROR;
+    }
+    bt->memo_words = numof_words;
+  }
+  /* Each back-referenced group tries them again for each of its O(n) values. */
+  for (i = 0, n = 1; i < bt->numof_ref_slots; i += 2)
+    n = ((n > SIZE_MAX / (string_len - start + 1)) ? SIZE_MAX : n * (string_len - start + 1));
+  if (bt->numof_ref_slots == 0)
+    n = 0;
+  max_steps = ((n > SIZE_MAX / numof_bits - FRE_BT_STEPS_PER_BIT)
+	       ? SIZE_MAX : (FRE_BT_STEPS_PER_BIT + n) * numof_bits);
+
+  for (bo = start; bo <= string_len && best_end < 0; bo++){
+    if (intern__fre__bt_push(bt, prog->start, (int)bo, 0) == FRE_ERROR)
+      goto errjmp;
+    while (bt->numof_jobs > 0){
+      job = bt->jobs[--bt->numof_jobs];
+      if (job.pc < 0){
+	bt->caps[job.slot] = job.pos;
+	continue;
+      }
+      pc = job.pc;
+      pos = job.pos;
+      while (1){
+	if (bt->kept[pc] == FRE_BT_KEPT_BLOCK){
+	  if ((ret = intern__fre__bt_visit(bt, pc, pos)) == FRE_ERROR)
+	    goto errjmp;
+	  if (ret == FRE_OP_UNSUCCESSFUL)
+	    break;
+	}
+	else if (bt->kept[pc] == FRE_BT_KEPT_BIT){
+	  idx = (size_t)pos * numof_insts + (size_t)pc;
+	  bit = (uint64_t)1 << (idx & 63);
+	  if (bt->memo[idx >> 6] & bit)
+	    break;
+	  if (bt->memo[idx >> 6] == 0)
+	    bt->dirty[bt->numof_dirty++] = idx >> 6;
+	  bt->memo[idx >> 6] |= bit;
+	}
+	if (++steps > max_steps){
+	  bt->numof_jobs = 0;
+	  intern__fre__bt_forget(bt);
+	  for (i = 0; i < bt->numof_slots; i++)
+	    bt->caps[i] = -1;
+	  return FRE_BT_OVER_BUDGET;
+	}
+	inst = &prog->insts[pc];
+	switch (inst->op){
+	case FRE_I_BYTES:
+	  if ((size_t)pos < string_len && FRE_SET_HAS(prog->sets[inst->arg], string[pos])){
+	    pc = inst->out;
+	    ++pos;
+	    continue;
+	  }
+	  break;
+	case FRE_I_SPLIT:
+	  if (intern__fre__bt_push(bt, inst->out1, pos, 0) == FRE_ERROR)
+	    goto errjmp;
+	  pc = inst->out;
+	  continue;
+	case FRE_I_ASSERT:
+	  if (intern__fre__assert_holds(inst->arg, FRE_BT_CTX(prog, string, string_len, pos - 1),
+					FRE_BT_CTX(prog, string, string_len, pos))){
+	    pc = inst->out;
+	    continue;
+	  }
+	  break;
+	case FRE_I_SAVE:
+	  if (intern__fre__bt_push(bt, -1, bt->caps[inst->arg], inst->arg) == FRE_ERROR)
+	    goto errjmp;
+	  bt->caps[inst->arg] = pos;
+	  pc = inst->out;
+	  continue;
+	case FRE_I_BREF:
+	  /* A group that didn't take part in the match matches nothing. */
+	  cap_bo = bt->caps[2 * inst->arg];
+	  cap_eo = bt->caps[2 * inst->arg + 1];
+	  if (cap_bo < 0 || cap_eo < cap_bo
+	      || (size_t)(cap_eo - cap_bo) > string_len - (size_t)pos)
+	    break;
+	  if (!bt->icase){
+	    if (memcmp(string + cap_bo, string + pos, (size_t)(cap_eo - cap_bo)) != 0)
+	      break;
+	  }
+	  else {
+	    for (n = 0; n < (size_t)(cap_eo - cap_bo); n++)
+	      if (tolower(string[cap_bo + n]) != tolower(string[pos + n]))
+		break;
+	    if (n < (size_t)(cap_eo - cap_bo))
+	      break;
+	  }
+	  pc = inst->out;
+	  pos += cap_eo - cap_bo;
+	  continue;
+	case FRE_I_MATCH:
+	  if (pos > best_end){
+	    best_end = pos;
+	    memcpy(bt->best, bt->caps, bt->numof_slots * sizeof(int));
+	  }
+	  /* Nothing can be longer. */
+	  if ((size_t)pos == string_len)
+	    bt->numof_jobs = 0;
+	  break;
+	}
+	break;
+      }
+    }
+  }
+  intern__fre__bt_forget(bt);
+  for (i = 0; i < bt->numof_slots; i++)
+    bt->caps[i] = -1;
+  if (best_end < 0)
+    return FRE_OP_UNSUCCESSFUL;
+
+  for (i = 0; i < numof_sm; i++){
+    if (2 * i + 1 < bt->numof_slots && bt->best[2 * i] >= 0 && bt->best[2 * i + 1] >= 0){
+      match_arr[i].bo = (fre_off)bt->best[2 * i];
+      match_arr[i].eo = (fre_off)bt->best[2 * i + 1];
+    }
+    else
+      match_arr[i].bo = match_arr[i].eo = -1;
+  }
+  return FRE_OP_SUCCESSFUL;
+
+ errjmp:
+  bt->numof_jobs = 0;
+  intern__fre__bt_forget(bt);
+  for (i = 0; i < bt->numof_slots; i++)
+    bt->caps[i] = -1;
+  return FRE_ERROR;
+
+} /* intern__fre__bt_exec() */
@@ -0,0 +1,274 @@
+/*
+ *
+ *  Libfre  -  Bit-parallel scanner, for short patterns.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+#define FRE_SET_HAS(set, byte) ((set)[(byte) >> 3] & (1u << ((byte) & 7)))
+
+/* Positions reached by a piece of the pattern, see intern__fre__glushkov(). */
+typedef struct fre_glushkov_info {
+  uint64_t              first;            /* Positions a match of the piece may begin at. */
+  uint64_t              last;             /* Positions it may end at. */
+  bool                  nullable;         /* True when it matches the empty string. */
+
+} fre_glushkov_info;
+
+/* The automaton being built. */
+typedef struct fre_glushkov {
+  fre_ast_tree          *tree;
+  size_t                numof_positions;  /* Positions given yet, bit 0 is the initial state. */
+  uint64_t              follow[64];       /* Positions following each position. */
+  int                   set[64];          /* Byte set of each position. */
+  bool                  unsupported;      /* True when the pattern doesn't fit. */
+
+} fre_glushkov;
+
+
+/* A piece followed by another, info = info then other. */
+static void intern__fre__glushkov_cat(fre_glushkov *g,
+				      fre_glushkov_info *info,
+				      const fre_glushkov_info *other)
+{
+  size_t p = 0;
+
+  for (p = 1; p < g->numof_positions; p++)
+    if (info->last & ((uint64_t)1 << p))
+      g->follow[p] |= other->first;
+  if (info->nullable)
+    info->first |= other->first;
+  info->last = ((other->nullable) ? (info->last | other->last) : other->last);
+  info->nullable = info->nullable && other->nullable;
+
+} /* intern__fre__glushkov_cat() */
+
+
+/*
+ * Give positions to each byte set of a node, once for each copy of
+ * it a repetition makes, and link them as the node's matches go.
+ */
+static void intern__fre__glushkov(fre_glushkov *g,
+				  int node_ind,
+				  fre_glushkov_info *info)
+{
+  size_t p = 0;
+  int i = 0;
+  fre_ast_node *node = &g->tree->nodes[node_ind];
+  fre_glushkov_info other;
+
+  memset(info, 0, sizeof(fre_glushkov_info));
+  info->nullable = true;
+  if (g->unsupported)
+    return;
+  switch (node->kind){
+  case FRE_AST_EMPTY:
+    return;
+  case FRE_AST_BYTES:
+    if (g->numof_positions > FRE_BITPAR_MAX_POSITIONS){
+      g->unsupported = true;
+      return;
+    }
+    p = g->numof_positions++;
+    g->set[p] = node->arg;
+    g->follow[p] = 0;
+    info->first = info->last = (uint64_t)1 << p;
+    info->nullable = false;
+    return;
+  case FRE_AST_GROUP:
+    intern__fre__glushkov(g, node->left, info);
+    return;
+  case FRE_AST_CAT:
+    intern__fre__glushkov(g, node->left, info);
+    intern__fre__glushkov(g, node->right, &other);
+    intern__fre__glushkov_cat(g, info, &other);
+    return;
+  case FRE_AST_ALT:
+    intern__fre__glushkov(g, node->left, info);
+    intern__fre__glushkov(g, node->right, &other);
+    info->first |= other.first;
+    info->last |= other.last;
+    info->nullable = info->nullable || other.nullable;
+    return;
+  case FRE_AST_REPEAT:
+    /* x{n,m} is n copies of x, then m-n of x?, or x* without a maximum. */
+    for (i = 0; i < node->min; i++){
+      intern__fre__glushkov(g, node->left, &other);
+      intern__fre__glushkov_cat(g, info, &other);
+    }
+    if (node->max == -1){
+      intern__fre__glushkov(g, node->left, &other);
+      for (p = 1; p < g->numof_positions; p++)
+	if (other.last & ((uint64_t)1 << p))
+	  g->follow[p] |= other.first;
+      other.nullable = true;
+      intern__fre__glushkov_cat(g, info, &other);
+      return;
+    }
+    for (i = node->min; i < node->max; i++){
+      intern__fre__glushkov(g, node->left, &other);
+      other.nullable = true;
+      intern__fre__glushkov_cat(g, info, &other);
+    }
+    return;
+  default:
+    /* Assertions need the context of each position, back-references the backtracker. */
+    g->unsupported = true;
+    return;
+  }
+
+} /* intern__fre__glushkov() */
+
+
+/*
+ * Build the Glushkov automaton of a parsed pattern. Returns NULL, errno
+ * left to 0, when it has assertions, more than FRE_BITPAR_MAX_POSITIONS
+ * positions once its repetitions are unrolled, matches the empty string,
+ * or isn't a sequence of byte sets: the cached DFA steps through
+ * alternations as fast as a table of follow sets would.
+ */
+fre_bitpar* intern__fre__bitpar_build(fre_ast_tree *tree)
+{
+  size_t p = 0, c = 0;
+  fre_glushkov *g = NULL;
+  fre_glushkov_info info;
+  fre_bitpar *bitpar = NULL;
+
+  if (!tree){
+    errno = EINVAL;
+    return NULL;
+  }
+  if (tree->assertions != 0 || tree->backrefs)
+    return NULL;
+  if ((g = calloc(1, sizeof(fre_glushkov))) == NULL){
+    intern__fre__errmesg("Calloc");
+    return NULL;
+  }
+  g->tree = tree;
+  g->numof_positions = 1;
+  intern__fre__glushkov(g, tree->root, &info);
+  if (g->unsupported || info.nullable || info.first != 2){
+    free(g);
+    return NULL;
+  }
+
+  if ((bitpar = calloc(1, sizeof(fre_bitpar))) == NULL){
+    intern__fre__errmesg("Calloc");
+    free(g);
+    return NULL;
+  }
+  bitpar->first = info.first;
+  bitpar->last = info.last;
+  for (p = 1; p < g->numof_positions; p++){
+    if ((g->follow[p] & ~(((uint64_t)1 << p) | ((uint64_t)1 << (p + 1)))) != 0){
+      free(g);
+      free(bitpar);
+      return NULL;
+    }
+    if (g->follow[p] & ((uint64_t)1 << p))
+      bitpar->loops |= (uint64_t)1 << p;
+  }
+  /* A position is entered on the bytes of its set, FRE_POSIX_* classes already expanded. */
+  for (p = 1; p < g->numof_positions; p++)
+    for (c = 0; c < 256; c++)
+      if (FRE_SET_HAS(tree->sets[g->set[p]], c))
+	bitpar->byte_mask[c] |= (uint64_t)1 << p;
+  free(g);
+  return bitpar;
+
+} /* intern__fre__bitpar_build() */
+
+
+/* Copy a Glushkov automaton. */
+fre_bitpar* intern__fre__clone_bitpar(fre_bitpar *bitpar)
+{
+  fre_bitpar *clone = NULL;
+
+  if (bitpar == NULL){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((clone = malloc(sizeof(fre_bitpar))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return NULL;
+  }
+  *clone = *bitpar;
+  return clone;
+
+} /* intern__fre__clone_bitpar() */
+
+
+/* Release a Glushkov automaton. */
+void intern__fre__free_bitpar(fre_bitpar *bitpar)
+{
+  if (bitpar == NULL)
+    return;
+  free(bitpar);
+
+} /* intern__fre__free_bitpar() */
+
+
+/* Just after the last byte of a block where all the matches died, see below. */
+#define FRE_BITPAR_DEAD(dead, died, block) do {				\
+    size_t _bit = 64;							\
+    while (_bit-- > 0)							\
+      if ((died) & ((uint64_t)1 << _bit)){				\
+	(dead) = (block) + _bit + 1;					\
+	break;								\
+      }									\
+  } while (0)
+
+
+/*
+ * Scan string from start for the first byte a match ends at, following every
+ * match begining at or after start at once. Where all of them had died last
+ * goes to *restart: the leftmost match, that goes on past the end found,
+ * can't begin before it. Returns FRE_OP_UNSUCCESSFUL when no match ends in string.
+ * Whether the state died at each byte is only gathered in a bitmap per block
+ * of 64 bytes, a branch on it would be as hard to predict as the text.
+ */
+int intern__fre__bitpar_exec(fre_bitpar *bitpar,
+			     const unsigned char *string,
+			     size_t string_len,
+			     size_t start,
+			     size_t *restart)
+{
+  size_t i = 0, block = 0, block_end = 0, dead = start;
+  uint64_t state = 0, died = 0;
+  const uint64_t first = bitpar->first, last = bitpar->last, loops = bitpar->loops;
+  const uint64_t *byte_mask = bitpar->byte_mask;
+
+  if (!string || !restart || start > string_len){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  for (block = start; block < string_len; block += 64){
+    block_end = ((string_len - block > 64) ? block + 64 : string_len);
+    died = 0;
+    for (i = block; i < block_end; i++){
+      state = ((state << 1) | (state & loops) | first) & byte_mask[string[i]];
+      died |= (uint64_t)(state == 0) << (i - block);
+      if (state & last)
+	goto found;
+    }
+    FRE_BITPAR_DEAD(dead, died, block);
+  }
+  return FRE_OP_UNSUCCESSFUL;
+
+ found:
+  FRE_BITPAR_DEAD(dead, died, block);
+  *restart = dead;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__bitpar_exec() */
@@ -0,0 +1,359 @@
+/*
+ *
+ *  Libfre  -  Caches of compiled patterns.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+/* 64 bits FNV-1a hash of a NUL terminated pattern. */
+uint64_t intern__fre__hash_pattern(char *pattern)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  size_t i = 0;
+
+  for (i = 0; pattern[i] != '\0'; i++){
+    hash ^= (unsigned char)pattern[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+
+/* Unlink an entry from its cache's LRU list, the entry stays in its hash bucket. */
+static inline void intern__fre__lru_unlink(fre_pcache *cache, fre_pcache_entry *entry)
+{
+  if (entry->lru_prev) entry->lru_prev->lru_next = entry->lru_next;
+  else cache->lru_head = entry->lru_next;
+  if (entry->lru_next) entry->lru_next->lru_prev = entry->lru_prev;
+  else cache->lru_tail = entry->lru_prev;
+  entry->lru_prev = NULL;
+  entry->lru_next = NULL;
+}
+
+
+/* Make entry the most recently used one. */
+static inline void intern__fre__lru_push_front(fre_pcache *cache, fre_pcache_entry *entry)
+{
+  entry->lru_prev = NULL;
+  entry->lru_next = cache->lru_head;
+  if (cache->lru_head) cache->lru_head->lru_prev = entry;
+  cache->lru_head = entry;
+  if (cache->lru_tail == NULL) cache->lru_tail = entry;
+}
+
+
+/* Remove the least recently used entry of cache and release its fre_pattern. */
+static void intern__fre__pcache_evict(fre_pcache *cache)
+{
+  fre_pcache_entry *victim = cache->lru_tail;
+  fre_pcache_entry **link = NULL;
+
+  if (victim == NULL)
+    return;
+  intern__fre__lru_unlink(cache, victim);
+  for (link = &cache->buckets[victim->hash & (FRE_PCACHE_BUCKETS - 1)];
+       *link != NULL;
+       link = &(*link)->hash_next){
+    if (*link == victim){
+      *link = victim->hash_next;
+      break;
+    }
+  }
+  intern__fre__free_pattern(victim->object);
+  free(victim->pattern);
+  free(victim);
+  --cache->numof_entries;
+}
+
+
+/*
+ * Return the fre_pattern object of pattern, from the calling thread's cache when
+ * it's there, else from the _plp_parser(), in which case the new object is cached.
+ * Objects returned by this function belong to the cache, never free them.
+ */
+fre_pattern* intern__fre__pcache_lookup(char *pattern)
+{
+  fre_pcache *cache = fre_pmatch_table->pattern_cache;
+  fre_pcache_entry *entry = NULL;
+  fre_pattern *freg_object = NULL;
+  uint64_t hash = intern__fre__hash_pattern(pattern);
+  size_t bucket = hash & (FRE_PCACHE_BUCKETS - 1);
+
+  for (entry = cache->buckets[bucket]; entry != NULL; entry = entry->hash_next){
+    if (entry->hash == hash && strcmp(entry->pattern, pattern) == 0){
+      ++cache->hits;
+      if (entry != cache->lru_head){
+	intern__fre__lru_unlink(cache, entry);
+	intern__fre__lru_push_front(cache, entry);
+      }
+      return entry->object;
+    }
+  }
+  ++cache->misses;
+  if ((freg_object = intern__fre__shared_lookup(pattern)) == NULL){
+    intern__fre__errmesg("_shared_lookup");
+    return NULL;
+  }
+  /* The cache is disabled, our caller owns the object. */
+  if (cache->capacity == 0)
+    return freg_object;
+
+  if ((entry = malloc(sizeof(fre_pcache_entry))) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  if ((entry->pattern = strdup(pattern)) == NULL){
+    intern__fre__errmesg("Strdup");
+    free(entry);
+    goto errjmp;
+  }
+  while (cache->numof_entries >= cache->capacity)
+    intern__fre__pcache_evict(cache);
+  entry->hash = hash;
+  entry->object = freg_object;
+  entry->hash_next = cache->buckets[bucket];
+  cache->buckets[bucket] = entry;
+  intern__fre__lru_push_front(cache, entry);
+  ++cache->numof_entries;
+
+  return freg_object;
+
+ errjmp:
+  intern__fre__free_pattern(freg_object);
+  return NULL;
+
+} /* intern__fre__pcache_lookup() */
+
+
+/* Change the capacity of cache, evicting least recently used patterns until it fits. */
+int intern__fre__pcache_resize(fre_pcache *cache,
+			       size_t capacity)
+{
+  if (cache == NULL){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  while (cache->numof_entries > capacity)
+    intern__fre__pcache_evict(cache);
+  cache->capacity = capacity;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__pcache_resize() */
+
+
+
+/** The process-wide shared pattern table. **/
+
+/*
+ * Lowest epoch announced by a thread currently walking the shared table,
+ * ULONG_MAX when no thread is. Tables of exited threads, given back by
+ * intern__fre__key_delete(), lie past head_list_tos and aren't looked at.
+ * Must be called with the shared table's lock held.
+ */
+static unsigned long intern__fre__shared_min_epoch(void)
+{
+  unsigned long min_epoch = ULONG_MAX, epoch = 0;
+  size_t i = 0;
+
+  pthread_mutex_lock(fre_headnode_table->table_lock);
+  for (i = 0; i < fre_headnode_table->head_list_tos; i++){
+    epoch = __atomic_load_n(&fre_headnode_table->head_list[i]->shared_epoch, __ATOMIC_SEQ_CST);
+    if (epoch != 0 && epoch < min_epoch)
+      min_epoch = epoch;
+  }
+  pthread_mutex_unlock(fre_headnode_table->table_lock);
+  return min_epoch;
+}
+
+
+/*
+ * Drop the table's reference to retired entries no reader can still see.
+ * Must be called with the shared table's lock held.
+ */
+static void intern__fre__shared_reclaim(void)
+{
+  fre_shared_entry **link = &fre_shared_pattern_table->retired;
+  fre_shared_entry *entry = NULL;
+  unsigned long min_epoch = 0;
+
+  if (*link == NULL)
+    return;
+  min_epoch = intern__fre__shared_min_epoch();
+  while ((entry = *link) != NULL){
+    /* A reader that entered before the entry was unlinked may still hold a pointer to it. */
+    if (entry->retire_epoch > min_epoch){
+      link = &entry->fifo_next;
+      continue;
+    }
+    *link = entry->fifo_next;
+    intern__fre__shared_release(entry);
+  }
+}
+
+
+/*
+ * Unlink the oldest entry of the shared table and put it on the retired list.
+ * Must be called with the shared table's lock held.
+ */
+static void intern__fre__shared_evict(void)
+{
+  fre_shared_entry *victim = fre_shared_pattern_table->fifo_head;
+  fre_shared_entry **link = NULL;
+
+  if (victim == NULL)
+    return;
+  for (link = &fre_shared_pattern_table->buckets[victim->hash & (FRE_SHARED_BUCKETS - 1)];
+       *link != NULL;
+       link = &(*link)->hash_next){
+    if (*link == victim){
+      /* Readers already past the link keep walking the victim's chain, which stays intact. */
+      __atomic_store_n(link, victim->hash_next, __ATOMIC_SEQ_CST);
+      break;
+    }
+  }
+  fre_shared_pattern_table->fifo_head = victim->fifo_next;
+  if (fre_shared_pattern_table->fifo_head == NULL)
+    fre_shared_pattern_table->fifo_tail = NULL;
+  --fre_shared_pattern_table->numof_entries;
+  victim->retire_epoch = __atomic_add_fetch(&fre_shared_pattern_table->epoch, 1, __ATOMIC_SEQ_CST);
+  victim->fifo_next = fre_shared_pattern_table->retired;
+  fre_shared_pattern_table->retired = victim;
+}
+
+
+/* Walk a bucket of the shared table, return a referenced entry or NULL. */
+static inline fre_shared_entry* intern__fre__shared_find(size_t bucket,
+							 uint64_t hash,
+							 char *pattern)
+{
+  fre_shared_entry *entry = NULL;
+
+  for (entry = __atomic_load_n(&fre_shared_pattern_table->buckets[bucket], __ATOMIC_SEQ_CST);
+       entry != NULL;
+       entry = __atomic_load_n(&entry->hash_next, __ATOMIC_ACQUIRE)){
+    if (entry->hash == hash && strcmp(entry->pattern, pattern) == 0){
+      __atomic_add_fetch(&entry->refcount, 1, __ATOMIC_SEQ_CST);
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+
+/*
+ * Return a clone of the parsed pattern, for the calling thread to execute.
+ * Patterns are parsed once per process: hits take no lock, a thread
+ * only announces the epoch it's reading in, so that evictions never
+ * free an entry under its feet. Misses parse the pattern without holding
+ * any lock and publish it under the table's lock.
+ * The returned object must be released with intern__fre__free_pattern().
+ */
+fre_pattern* intern__fre__shared_lookup(char *pattern)
+{
+  fre_pmatch *ptable = fre_pmatch_table;
+  fre_shared_entry *entry = NULL;
+  fre_pattern *freg_object = NULL, *clone = NULL;
+  uint64_t hash = intern__fre__hash_pattern(pattern);
+  size_t bucket = hash & (FRE_SHARED_BUCKETS - 1);
+
+  __atomic_store_n(&ptable->shared_epoch,
+		   __atomic_load_n(&fre_shared_pattern_table->epoch, __ATOMIC_SEQ_CST),
+		   __ATOMIC_SEQ_CST);
+  entry = intern__fre__shared_find(bucket, hash, pattern);
+  __atomic_store_n(&ptable->shared_epoch, 0, __ATOMIC_RELEASE);
+
+  if (entry == NULL){
+    if ((freg_object = intern__fre__plp_parser(pattern)) == NULL){
+      intern__fre__errmesg("_plp_parser: Failed to parse the given pattern");
+      return NULL;
+    }
+    pthread_mutex_lock(fre_shared_pattern_table->table_lock);
+    /* The table is disabled, our caller owns the parsed object. */
+    if (fre_shared_pattern_table->capacity == 0){
+      pthread_mutex_unlock(fre_shared_pattern_table->table_lock);
+      return freg_object;
+    }
+    /* Another thread may have published the same pattern in the meantime. */
+    if ((entry = intern__fre__shared_find(bucket, hash, pattern)) != NULL){
+      pthread_mutex_unlock(fre_shared_pattern_table->table_lock);
+      intern__fre__free_pattern(freg_object);
+    }
+    else {
+      if ((entry = malloc(sizeof(fre_shared_entry))) == NULL
+	  || (entry->pattern = strdup(pattern)) == NULL){
+	intern__fre__errmesg("Malloc");
+	pthread_mutex_unlock(fre_shared_pattern_table->table_lock);
+	free(entry);
+	/* Still usable, just not shared. */
+	return freg_object;
+      }
+      entry->hash = hash;
+      entry->object = freg_object;
+      entry->refcount = 2;  /* The table's and our caller's. */
+      entry->retire_epoch = 0;
+      entry->fifo_next = NULL;
+      entry->hash_next = fre_shared_pattern_table->buckets[bucket];
+      __atomic_store_n(&fre_shared_pattern_table->buckets[bucket], entry, __ATOMIC_SEQ_CST);
+      if (fre_shared_pattern_table->fifo_tail)
+	fre_shared_pattern_table->fifo_tail->fifo_next = entry;
+      else
+	fre_shared_pattern_table->fifo_head = entry;
+      fre_shared_pattern_table->fifo_tail = entry;
+      ++fre_shared_pattern_table->numof_entries;
+      while (fre_shared_pattern_table->numof_entries > fre_shared_pattern_table->capacity)
+	intern__fre__shared_evict();
+      intern__fre__shared_reclaim();
+      pthread_mutex_unlock(fre_shared_pattern_table->table_lock);
+    }
+  }
+  if ((clone = intern__fre__clone_pattern(entry->object)) == NULL){
+    intern__fre__errmesg("_clone_pattern");
+    intern__fre__shared_release(entry);
+    return NULL;
+  }
+  clone->shared_entry = entry;
+
+  return clone;
+
+} /* intern__fre__shared_lookup() */
+
+
+/*
+ * Drop one reference to a shared entry.
+ * The last reference is dropped either by the table, once the entry is
+ * retired and unreachable, or by the last clone made from it.
+ */
+void intern__fre__shared_release(fre_shared_entry *entry)
+{
+  if (entry == NULL)
+    return;
+  if (__atomic_sub_fetch(&entry->refcount, 1, __ATOMIC_ACQ_REL) == 0)
+    intern__fre__free_shared_entry(entry);
+}
+
+
+/* Change the number of patterns kept by the shared table, evicting the oldest as needed. */
+int intern__fre__shared_resize(size_t capacity)
+{
+  pthread_mutex_lock(fre_shared_pattern_table->table_lock);
+  while (fre_shared_pattern_table->numof_entries > capacity)
+    intern__fre__shared_evict();
+  fre_shared_pattern_table->capacity = capacity;
+  intern__fre__shared_reclaim();
+  pthread_mutex_unlock(fre_shared_pattern_table->table_lock);
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__shared_resize() */
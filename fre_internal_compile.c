@@ -0,0 +1,1428 @@
+/*
+ *
+ *  Libfre  -  POSIX ERE parser and compiler for the native engines.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <ctype.h>
+#include <locale.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+/* State of the parser, the tree it builds and where it's at in the pattern. */
+typedef struct fre_parser {
+  const char            *pattern;
+  size_t                pos;
+  size_t                depth;            /* Number of open parentheses. */
+  bool                  icase;            /* REG_ICASE */
+  bool                  newline;          /* REG_NEWLINE */
+  bool                  unsupported;      /* True when the pattern must be left to regcomp(). */
+  bool                  branch_start;     /* True before the first piece of a top-level branch. */
+  unsigned int          closed_groups;    /* Bit N is set once group N is closed, back-references may use it. */
+  fre_ast_tree          *tree;
+
+} fre_parser;
+
+
+#define FRE_SET_ADD(set, byte) ((set)[(byte) >> 3] |= (uint8_t)(1u << ((byte) & 7)))
+#define FRE_SET_HAS(set, byte) ((set)[(byte) >> 3] & (1u << ((byte) & 7)))
+
+static int intern__fre__parse_alt(fre_parser *parser);
+
+
+/* Add a node to the tree, returns its index or FRE_ERROR. */
+static int intern__fre__ast_node(fre_ast_tree *tree,
+				 fre_ast_f kind,
+				 int left,
+				 int right,
+				 int arg)
+{
+  fre_ast_node *temp = NULL;
+
+  if (tree->numof_nodes == tree->nodes_size){
+    if ((temp = realloc(tree->nodes, tree->nodes_size * 2 * sizeof(fre_ast_node))) == NULL){
+      intern__fre__errmesg("Realloc");
+      return FRE_ERROR;
+    }
+    tree->nodes = temp;
+    tree->nodes_size *= 2;
+  }
+  temp = &tree->nodes[tree->numof_nodes];
+  temp->kind = kind;
+  temp->left = left;
+  temp->right = right;
+  temp->arg = arg;
+  temp->min = 0;
+  temp->max = 0;
+  return (int)tree->numof_nodes++;
+
+} /* intern__fre__ast_node() */
+
+
+/*
+ * Add a byte set to the tree, folding its case under REG_ICASE and
+ * reusing an identical set if there's one. Returns its index or FRE_ERROR.
+ */
+static int intern__fre__ast_set(fre_parser *parser,
+				uint8_t *set,
+				bool negate)
+{
+  size_t i = 0;
+  uint8_t folded[32];
+  uint8_t (*temp)[32] = NULL;
+  fre_ast_tree *tree = parser->tree;
+
+  memcpy(folded, set, 32);
+  if (parser->icase){
+    for (i = 0; i < 256; i++){
+      if (FRE_SET_HAS(set, i)){
+	FRE_SET_ADD(folded, (unsigned char)tolower((int)i));
+	FRE_SET_ADD(folded, (unsigned char)toupper((int)i));
+      }
+    }
+  }
+  if (negate){
+    for (i = 0; i < 32; i++)
+      folded[i] = (uint8_t)~folded[i];
+    /* REG_NEWLINE: a non-matching list never matches a newline. */
+    if (parser->newline)
+      folded['\n' >> 3] &= (uint8_t)~(1u << ('\n' & 7));
+  }
+  for (i = 0; i < tree->numof_sets; i++)
+    if (memcmp(tree->sets[i], folded, 32) == 0)
+      return (int)i;
+  if (tree->numof_sets == tree->sets_size){
+    if ((temp = realloc(tree->sets, tree->sets_size * 2 * sizeof(*tree->sets))) == NULL){
+      intern__fre__errmesg("Realloc");
+      return FRE_ERROR;
+    }
+    tree->sets = temp;
+    tree->sets_size *= 2;
+  }
+  memcpy(tree->sets[tree->numof_sets], folded, 32);
+  return (int)tree->numof_sets++;
+
+} /* intern__fre__ast_set() */
+
+
+/* A FRE_AST_BYTES node for the given set. */
+static int intern__fre__ast_bytes(fre_parser *parser,
+				  uint8_t *set,
+				  bool negate)
+{
+  int set_ind = 0;
+  if ((set_ind = intern__fre__ast_set(parser, set, negate)) == FRE_ERROR)
+    return FRE_ERROR;
+  return intern__fre__ast_node(parser->tree, FRE_AST_BYTES, -1, -1, set_ind);
+
+} /* intern__fre__ast_bytes() */
+
+
+/* Add the bytes of the named character class, returns false for unknown names. */
+static bool intern__fre__class_set(const char *name,
+				   size_t name_len,
+				   uint8_t *set)
+{
+  static const char *names[] = { "alpha", "digit", "alnum", "upper", "lower", "space",
+				 "blank", "punct", "print", "graph", "cntrl", "xdigit" };
+  int (*tests[])(int) = { isalpha, isdigit, isalnum, isupper, islower, isspace,
+			  isblank, ispunct, isprint, isgraph, iscntrl, isxdigit };
+  size_t i = 0, c = 0;
+
+  for (i = 0; i < sizeof(names) / sizeof(names[0]); i++){
+    if (strlen(names[i]) == name_len && strncmp(names[i], name, name_len) == 0){
+      for (c = 0; c < 256; c++)
+	if (tests[i]((int)c))
+	  FRE_SET_ADD(set, c);
+      return true;
+    }
+  }
+  return false;
+
+} /* intern__fre__class_set() */
+
+
+/*
+ * Parse a bracket expression, parser->pos is right after its '['.
+ * Collating elements and equivalence classes of more than one character,
+ * and ranges outside of the C locale are left to regcomp().
+ */
+static int intern__fre__parse_bracket(fre_parser *parser)
+{
+  const char *p = parser->pattern;
+  size_t start = 0, name_len = 0;
+  bool negate = false, first = true;
+  bool c_collate = false;
+  const char *locale = setlocale(LC_COLLATE, NULL);
+  int low = 0, high = 0, c = 0;
+  uint8_t set[32];
+
+  memset(set, 0, 32);
+  c_collate = (locale == NULL || strcmp(locale, "C") == 0 || strcmp(locale, "POSIX") == 0);
+  if (p[parser->pos] == '^'){
+    negate = true;
+    ++parser->pos;
+  }
+  while (1){
+    if (p[parser->pos] == '\0'){
+      parser->unsupported = true;
+      return FRE_OP_UNSUCCESSFUL;
+    }
+    if (p[parser->pos] == ']' && !first){
+      ++parser->pos;
+      break;
+    }
+    first = false;
+    /* [:class:] [=c=] [.c.] */
+    if (p[parser->pos] == '[' && (p[parser->pos+1] == ':' || p[parser->pos+1] == '='
+				  || p[parser->pos+1] == '.')){
+      char kind = p[parser->pos+1];
+      start = parser->pos + 2;
+      for (name_len = 0; p[start + name_len] != '\0'; name_len++)
+	if (p[start + name_len] == kind && p[start + name_len + 1] == ']')
+	  break;
+      if (p[start + name_len] == '\0'){
+	parser->unsupported = true;
+	return FRE_OP_UNSUCCESSFUL;
+      }
+      parser->pos = start + name_len + 2;
+      if (kind == ':'){
+	if (!intern__fre__class_set(p + start, name_len, set)){
+	  parser->unsupported = true;
+	  return FRE_OP_UNSUCCESSFUL;
+	}
+	continue;
+      }
+      if (name_len != 1){
+	parser->unsupported = true;
+	return FRE_OP_UNSUCCESSFUL;
+      }
+      low = (unsigned char)p[start];
+    }
+    else
+      low = (unsigned char)p[parser->pos++];
+
+    /* A range, unless the '-' is the last character of the list. */
+    if (p[parser->pos] == '-' && p[parser->pos+1] != ']' && p[parser->pos+1] != '\0'){
+      ++parser->pos;
+      if (p[parser->pos] == '['){
+	if (p[parser->pos+1] != '.' || p[parser->pos+2] == '\0'
+	    || p[parser->pos+3] != '.' || p[parser->pos+4] != ']'){
+	  parser->unsupported = true;
+	  return FRE_OP_UNSUCCESSFUL;
+	}
+	high = (unsigned char)p[parser->pos+2];
+	parser->pos += 5;
+      }
+      else
+	high = (unsigned char)p[parser->pos++];
+      if (!c_collate || low > high){
+	parser->unsupported = true;
+	return FRE_OP_UNSUCCESSFUL;
+      }
+      for (c = low; c <= high; c++)
+	FRE_SET_ADD(set, c);
+      continue;
+    }
+    FRE_SET_ADD(set, low);
+  }
+
+  return intern__fre__ast_bytes(parser, set, negate);
+
+} /* intern__fre__parse_bracket() */
+
+
+/* Parse an atom: a parenthesized expression, a bracket expression, '.', an anchor or a character. */
+static int intern__fre__parse_atom(fre_parser *parser)
+{
+  const char *p = parser->pattern;
+  int node = 0, group = 0;
+  uint8_t set[32];
+
+  memset(set, 0, 32);
+  switch (p[parser->pos]){
+  case '(':
+    ++parser->pos;
+    ++parser->depth;
+    group = (int)++parser->tree->numof_groups;
+    if ((node = intern__fre__parse_alt(parser)) == FRE_ERROR || parser->unsupported)
+      return node;
+    if (p[parser->pos] != ')'){
+      parser->unsupported = true;
+      return FRE_OP_UNSUCCESSFUL;
+    }
+    ++parser->pos;
+    if (group < 10)
+      parser->closed_groups |= 1u << group;
+    --parser->depth;
+    return intern__fre__ast_node(parser->tree, FRE_AST_GROUP, node, -1, group);
+  case '[':
+    ++parser->pos;
+    return intern__fre__parse_bracket(parser);
+  case '.':
+    ++parser->pos;
+    /* Never the NULL byte, nor a newline under REG_NEWLINE. */
+    memset(set, 0xff, 32);
+    set[0] &= (uint8_t)~1u;
+    if (parser->newline)
+      set['\n' >> 3] &= (uint8_t)~(1u << ('\n' & 7));
+    return intern__fre__ast_bytes(parser, set, false);
+  case '^':
+    /*
+     * glibc lets '.' and non-matching lists match the newline before an anchor
+     * found in the middle of a pattern, anchors are only taken at either end of it.
+     */
+    if (!parser->branch_start){
+      parser->unsupported = true;
+      return FRE_OP_UNSUCCESSFUL;
+    }
+    ++parser->pos;
+    parser->tree->assertions |= 1u << (parser->newline ? FRE_ASSERT_BOL : FRE_ASSERT_BOT);
+    return intern__fre__ast_node(parser->tree, FRE_AST_ASSERT, -1, -1,
+				 (parser->newline ? FRE_ASSERT_BOL : FRE_ASSERT_BOT));
+  case '$':
+    if (parser->depth > 0 || (p[parser->pos+1] != '\0' && p[parser->pos+1] != '|')){
+      parser->unsupported = true;
+      return FRE_OP_UNSUCCESSFUL;
+    }
+    ++parser->pos;
+    parser->tree->assertions |= 1u << (parser->newline ? FRE_ASSERT_EOL : FRE_ASSERT_EOT);
+    return intern__fre__ast_node(parser->tree, FRE_AST_ASSERT, -1, -1,
+				 (parser->newline ? FRE_ASSERT_EOL : FRE_ASSERT_EOT));
+  case '\\':
+    /* Word boundaries are zero-width assertions, like anchors but anywhere in the pattern. */
+    if (p[parser->pos+1] != '\0' && strchr("bB<>", p[parser->pos+1]) != NULL){
+      switch (p[parser->pos+1]){
+      case 'b': node = FRE_ASSERT_WORDB; break;
+      case 'B': node = FRE_ASSERT_NWORDB; break;
+      case '<': node = FRE_ASSERT_BOW; break;
+      default:  node = FRE_ASSERT_EOW; break;
+      }
+      parser->pos += 2;
+      parser->tree->assertions |= 1u << node;
+      return intern__fre__ast_node(parser->tree, FRE_AST_ASSERT, -1, -1, node);
+    }
+    /* Back-references, \1 to \9, to a group closed already. Only the backtracker runs them. */
+    if (p[parser->pos+1] >= '1' && p[parser->pos+1] <= '9'){
+      group = p[parser->pos+1] - '0';
+      if (!(parser->closed_groups & (1u << group))){
+	parser->unsupported = true;
+	return FRE_OP_UNSUCCESSFUL;
+      }
+      parser->pos += 2;
+      parser->tree->backrefs = true;
+      return intern__fre__ast_node(parser->tree, FRE_AST_BREF, -1, -1, group);
+    }
+    /* Other GNU escapes are left to regcomp(), anything else is a literal. */
+    if (p[parser->pos+1] == '\0' || isdigit((unsigned char)p[parser->pos+1])
+	|| strchr("wWsS`'", p[parser->pos+1]) != NULL){
+      parser->unsupported = true;
+      return FRE_OP_UNSUCCESSFUL;
+    }
+    ++parser->pos;
+    break;
+  case '*': case '+': case '?': case '{': case ')':
+    parser->unsupported = true;
+    return FRE_OP_UNSUCCESSFUL;
+  default:
+    break;
+  }
+  FRE_SET_ADD(set, (unsigned char)p[parser->pos]);
+  ++parser->pos;
+  return intern__fre__ast_bytes(parser, set, false);
+
+} /* intern__fre__parse_atom() */
+
+
+/* Parse an interval's bound, returns -1 when there's no number. */
+static int intern__fre__parse_bound(fre_parser *parser)
+{
+  int bound = -1;
+  while (isdigit((unsigned char)parser->pattern[parser->pos])){
+    bound = ((bound < 0) ? 0 : bound) * 10 + (parser->pattern[parser->pos++] - '0');
+    if (bound > RE_DUP_MAX)
+      return -2;
+  }
+  return bound;
+
+} /* intern__fre__parse_bound() */
+
+
+/* Parse an atom followed by any number of '*' '+' '?' and {n,m}. */
+static int intern__fre__parse_piece(fre_parser *parser)
+{
+  const char *p = parser->pattern;
+  int node = 0, min = 0, max = 0;
+  size_t i = 0, first_node = parser->tree->numof_nodes;
+
+  if ((node = intern__fre__parse_atom(parser)) == FRE_ERROR || parser->unsupported)
+    return node;
+  while (p[parser->pos] == '*' || p[parser->pos] == '+'
+	 || p[parser->pos] == '?' || p[parser->pos] == '{'){
+    /* glibc doesn't treat anchors under a repetition the POSIX way, leave these to it. */
+    for (i = first_node; i < parser->tree->numof_nodes; i++){
+      if (parser->tree->nodes[i].kind == FRE_AST_ASSERT){
+	parser->unsupported = true;
+	return FRE_OP_UNSUCCESSFUL;
+      }
+    }
+    switch (p[parser->pos++]){
+    case '*': min = 0; max = -1; break;
+    case '+': min = 1; max = -1; break;
+    case '?': min = 0; max = 1; break;
+    default:
+      if ((min = intern__fre__parse_bound(parser)) < 0){
+	parser->unsupported = true;
+	return FRE_OP_UNSUCCESSFUL;
+      }
+      max = min;
+      if (p[parser->pos] == ','){
+	++parser->pos;
+	if ((max = intern__fre__parse_bound(parser)) == -2 || (max >= 0 && max < min)){
+	  parser->unsupported = true;
+	  return FRE_OP_UNSUCCESSFUL;
+	}
+      }
+      if (p[parser->pos++] != '}'){
+	parser->unsupported = true;
+	return FRE_OP_UNSUCCESSFUL;
+      }
+      break;
+    }
+    if ((node = intern__fre__ast_node(parser->tree, FRE_AST_REPEAT, node, -1, 0)) == FRE_ERROR)
+      return FRE_ERROR;
+    parser->tree->nodes[node].min = min;
+    parser->tree->nodes[node].max = max;
+  }
+  return node;
+
+} /* intern__fre__parse_piece() */
+
+
+/* Parse a concatenation of pieces, up to a '|', a ')' or the end of the pattern. */
+static int intern__fre__parse_cat(fre_parser *parser)
+{
+  const char *p = parser->pattern;
+  int node = -1, piece = 0;
+
+  while (p[parser->pos] != '\0' && p[parser->pos] != '|'
+	 && !(p[parser->pos] == ')' && parser->depth > 0)){
+    parser->branch_start = (node == -1 && parser->depth == 0);
+    if ((piece = intern__fre__parse_piece(parser)) == FRE_ERROR || parser->unsupported)
+      return piece;
+    if (node == -1)
+      node = piece;
+    else if ((node = intern__fre__ast_node(parser->tree, FRE_AST_CAT, node, piece, 0)) == FRE_ERROR)
+      return FRE_ERROR;
+  }
+  if (node == -1)
+    return intern__fre__ast_node(parser->tree, FRE_AST_EMPTY, -1, -1, 0);
+  return node;
+
+} /* intern__fre__parse_cat() */
+
+
+/* Parse alternatives separated by '|'. */
+static int intern__fre__parse_alt(fre_parser *parser)
+{
+  int node = 0, branch = 0;
+
+  if ((node = intern__fre__parse_cat(parser)) == FRE_ERROR || parser->unsupported)
+    return node;
+  while (parser->pattern[parser->pos] == '|'){
+    ++parser->pos;
+    if ((branch = intern__fre__parse_cat(parser)) == FRE_ERROR || parser->unsupported)
+      return branch;
+    if ((node = intern__fre__ast_node(parser->tree, FRE_AST_ALT, node, branch, 0)) == FRE_ERROR)
+      return FRE_ERROR;
+  }
+  return node;
+
+} /* intern__fre__parse_alt() */
+
+
+/*
+ * Parse a POSIX ERE, as made by _perl_to_posix(), into a tree.
+ * icase and newline stand for REG_ICASE and REG_NEWLINE.
+ * Returns FRE_OP_UNSUCCESSFUL, leaving *tree NULL, for patterns the native
+ * engines don't handle (GNU escapes, locale dependent ranges...),
+ * these are left to regcomp(). regcomp() already accepted the pattern,
+ * anything it would reject is taken as unsupported too.
+ */
+int intern__fre__parse_ere(const char *pattern,
+			   bool icase,
+			   bool newline,
+			   fre_ast_tree **tree)
+{
+  int root = 0;
+  fre_parser parser;
+
+  if (!pattern || !tree){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  *tree = NULL;
+  parser.pattern = pattern;
+  parser.pos = 0;
+  parser.depth = 0;
+  parser.icase = icase;
+  parser.newline = newline;
+  parser.unsupported = false;
+  parser.branch_start = true;
+  parser.closed_groups = 0;
+  if ((parser.tree = calloc(1, sizeof(fre_ast_tree))) == NULL){
+    intern__fre__errmesg("Calloc");
+    return FRE_ERROR;
+  }
+  parser.tree->nodes_size = 32;
+  parser.tree->sets_size = 16;
+  if ((parser.tree->nodes = malloc(parser.tree->nodes_size * sizeof(fre_ast_node))) == NULL
+      || (parser.tree->sets = malloc(parser.tree->sets_size * sizeof(*parser.tree->sets))) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  if ((root = intern__fre__parse_alt(&parser)) == FRE_ERROR)
+    goto errjmp;
+  /* Stopped early, on an unmatched ')' most likely. */
+  if (parser.unsupported || pattern[parser.pos] != '\0'){
+    intern__fre__free_ast(parser.tree);
+    return FRE_OP_UNSUCCESSFUL;
+  }
+  parser.tree->root = root;
+  *tree = parser.tree;
+  return FRE_OP_SUCCESSFUL;
+
+ errjmp:
+  intern__fre__free_ast(parser.tree);
+  return FRE_ERROR;
+
+} /* intern__fre__parse_ere() */
+
+
+/* Release a parsed POSIX ERE. */
+void intern__fre__free_ast(fre_ast_tree *tree)
+{
+  if (tree == NULL)
+    return;
+  if (tree->nodes != NULL)
+    free(tree->nodes);
+  if (tree->sets != NULL)
+    free(tree->sets);
+  free(tree);
+
+} /* intern__fre__free_ast() */
+
+
+/* Add an instruction to a program, returns its index or FRE_ERROR. */
+static int intern__fre__emit(fre_prog *prog,
+			     size_t *insts_size,
+			     fre_opcode op,
+			     int out,
+			     int out1,
+			     int arg)
+{
+  fre_inst *temp = NULL;
+
+  if (prog->numof_insts >= FRE_PROG_MAX_INSTS){
+    errno = E2BIG;
+    return FRE_ERROR;
+  }
+  if (prog->numof_insts == *insts_size){
+    if ((temp = realloc(prog->insts, *insts_size * 2 * sizeof(fre_inst))) == NULL){
+      intern__fre__errmesg("Realloc");
+      return FRE_ERROR;
+    }
+    prog->insts = temp;
+    *insts_size *= 2;
+  }
+  temp = &prog->insts[prog->numof_insts];
+  temp->op = op;
+  temp->out = out;
+  temp->out1 = out1;
+  temp->arg = arg;
+  return (int)prog->numof_insts++;
+
+} /* intern__fre__emit() */
+
+
+/* The assertion that reads, backward, like the given one does forward. */
+static int intern__fre__reverse_assert(int assertion)
+{
+  switch (assertion){
+  case FRE_ASSERT_BOT: return FRE_ASSERT_EOT;
+  case FRE_ASSERT_EOT: return FRE_ASSERT_BOT;
+  case FRE_ASSERT_BOL: return FRE_ASSERT_EOL;
+  case FRE_ASSERT_EOL: return FRE_ASSERT_BOL;
+  case FRE_ASSERT_BOW: return FRE_ASSERT_EOW;
+  case FRE_ASSERT_EOW: return FRE_ASSERT_BOW;
+  default: return assertion;
+  }
+
+} /* intern__fre__reverse_assert() */
+
+
+/*
+ * Compile the node so that it continues at instruction next,
+ * returns the index of its first instruction or FRE_ERROR.
+ * Programs are built from their end, so that no jump ever needs patching.
+ */
+static int intern__fre__compile_node(fre_ast_tree *tree,
+				     int node_ind,
+				     int next,
+				     fre_prog *prog,
+				     size_t *insts_size)
+{
+  int i = 0, entry = next, loop = 0, body = 0;
+  fre_ast_node *node = &tree->nodes[node_ind];
+
+  switch (node->kind){
+  case FRE_AST_EMPTY:
+    return next;
+  case FRE_AST_BYTES:
+    return intern__fre__emit(prog, insts_size, FRE_I_BYTES, next, -1, node->arg);
+  case FRE_AST_ASSERT:
+    return intern__fre__emit(prog, insts_size, FRE_I_ASSERT, next, -1,
+			     (prog->reverse ? intern__fre__reverse_assert(node->arg) : node->arg));
+  case FRE_AST_BREF:
+    return intern__fre__emit(prog, insts_size, FRE_I_BREF, next, -1, node->arg);
+  case FRE_AST_CAT:
+    if (prog->reverse){
+      if ((entry = intern__fre__compile_node(tree, node->left, next, prog, insts_size)) == FRE_ERROR)
+	return FRE_ERROR;
+      return intern__fre__compile_node(tree, node->right, entry, prog, insts_size);
+    }
+    if ((entry = intern__fre__compile_node(tree, node->right, next, prog, insts_size)) == FRE_ERROR)
+      return FRE_ERROR;
+    return intern__fre__compile_node(tree, node->left, entry, prog, insts_size);
+  case FRE_AST_ALT:
+    if ((entry = intern__fre__compile_node(tree, node->left, next, prog, insts_size)) == FRE_ERROR
+	|| (body = intern__fre__compile_node(tree, node->right, next, prog, insts_size)) == FRE_ERROR)
+      return FRE_ERROR;
+    return intern__fre__emit(prog, insts_size, FRE_I_SPLIT, entry, body, 0);
+  case FRE_AST_GROUP:
+    if ((entry = intern__fre__emit(prog, insts_size, FRE_I_SAVE, next, -1,
+				   node->arg * 2 + (prog->reverse ? 0 : 1))) == FRE_ERROR
+	|| (entry = intern__fre__compile_node(tree, node->left, entry, prog, insts_size)) == FRE_ERROR)
+      return FRE_ERROR;
+    return intern__fre__emit(prog, insts_size, FRE_I_SAVE, entry, -1,
+			     node->arg * 2 + (prog->reverse ? 1 : 0));
+  case FRE_AST_REPEAT:
+    if (node->max == -1){
+      /* x* : a split looping back on itself. */
+      if ((loop = intern__fre__emit(prog, insts_size, FRE_I_SPLIT, -1, next, 0)) == FRE_ERROR
+	  || (body = intern__fre__compile_node(tree, node->left, loop, prog, insts_size)) == FRE_ERROR)
+	return FRE_ERROR;
+      prog->insts[loop].out = body;
+      entry = loop;
+    }
+    else {
+      /* x{0,n} : (x(x(x)?)?)? */
+      for (i = node->min; i < node->max; i++){
+	if ((body = intern__fre__compile_node(tree, node->left, entry, prog, insts_size)) == FRE_ERROR
+	    || (entry = intern__fre__emit(prog, insts_size, FRE_I_SPLIT, body, next, 0)) == FRE_ERROR)
+	  return FRE_ERROR;
+      }
+    }
+    for (i = 0; i < node->min; i++)
+      if ((entry = intern__fre__compile_node(tree, node->left, entry, prog, insts_size)) == FRE_ERROR)
+	return FRE_ERROR;
+    return entry;
+  default:
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+
+} /* intern__fre__compile_node() */
+
+
+/*
+ * Partition bytes in classes no instruction of the program can tell apart,
+ * newlines and word characters getting their own when assertions look for them.
+ */
+static void intern__fre__byte_classes(fre_prog *prog)
+{
+  size_t i = 0, c = 0, numof_classes = 1;
+  int16_t split_to[256][2];
+  uint8_t newline_set[32], word_set[32];
+  bool use_newline = false, use_word = false;
+
+  memset(newline_set, 0, 32);
+  memset(word_set, 0, 32);
+  FRE_SET_ADD(newline_set, '\n');
+  for (c = 0; c < 256; c++)
+    if (isalnum((int)c) || c == '_')
+      FRE_SET_ADD(word_set, c);
+  use_newline = (prog->assertions & ((1u << FRE_ASSERT_BOL) | (1u << FRE_ASSERT_EOL))) != 0;
+  use_word = (prog->assertions & ((1u << FRE_ASSERT_WORDB) | (1u << FRE_ASSERT_NWORDB)
+				  | (1u << FRE_ASSERT_BOW) | (1u << FRE_ASSERT_EOW))) != 0;
+
+  memset(prog->byte_class, 0, 256);
+  /* Refine the partition with each set, the newline and the word characters. */
+  for (i = 0; i < prog->numof_sets + 2; i++){
+    uint8_t *set = ((i < prog->numof_sets) ? prog->sets[i]
+		    : ((i == prog->numof_sets) ? newline_set : word_set));
+    size_t new_numof_classes = 0;
+    if ((i == prog->numof_sets && !use_newline) || (i == prog->numof_sets + 1 && !use_word))
+      continue;
+    memset(split_to, 0xff, sizeof(split_to));
+    for (c = 0; c < 256; c++){
+      int side = FRE_SET_HAS(set, c) ? 1 : 0;
+      if (split_to[prog->byte_class[c]][side] == -1)
+	split_to[prog->byte_class[c]][side] = (int16_t)new_numof_classes++;
+      prog->byte_class[c] = (uint8_t)split_to[prog->byte_class[c]][side];
+    }
+    numof_classes = new_numof_classes;
+  }
+  prog->numof_classes = numof_classes;
+  for (c = 256; c-- > 0;){
+    prog->class_repr[prog->byte_class[c]] = (uint8_t)c;
+    if (use_newline && c == '\n')
+      prog->class_ctx[prog->byte_class[c]] = FRE_CTX_NEWLINE;
+    else if (use_word && FRE_SET_HAS(word_set, c))
+      prog->class_ctx[prog->byte_class[c]] = FRE_CTX_WORD;
+    else
+      prog->class_ctx[prog->byte_class[c]] = FRE_CTX_OTHER;
+  }
+
+} /* intern__fre__byte_classes() */
+
+
+/*
+ * Compile a parsed POSIX ERE into a program, to run forward or backward.
+ * Capture slots 0 and 1 bracket the whole match, 2N and 2N+1 the Nth sub-expression.
+ */
+fre_prog* intern__fre__compile_prog(fre_ast_tree *tree,
+				    bool reverse)
+{
+  int entry = 0;
+  size_t insts_size = 64;
+  fre_prog *prog = NULL;
+
+  if (!tree){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((prog = calloc(1, sizeof(fre_prog))) == NULL){
+    intern__fre__errmesg("Calloc");
+    return NULL;
+  }
+  prog->reverse = reverse;
+  prog->numof_groups = tree->numof_groups;
+  prog->assertions = tree->assertions;
+  if ((prog->insts = malloc(insts_size * sizeof(fre_inst))) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  if ((prog->sets = malloc((tree->numof_sets ? tree->numof_sets : 1) * sizeof(*prog->sets))) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  memcpy(prog->sets, tree->sets, tree->numof_sets * sizeof(*prog->sets));
+  prog->numof_sets = tree->numof_sets;
+
+  if ((entry = intern__fre__emit(prog, &insts_size, FRE_I_MATCH, -1, -1, 0)) == FRE_ERROR
+      || (entry = intern__fre__emit(prog, &insts_size, FRE_I_SAVE, entry, -1, (reverse ? 0 : 1))) == FRE_ERROR
+      || (entry = intern__fre__compile_node(tree, tree->root, entry, prog, &insts_size)) == FRE_ERROR
+      || (entry = intern__fre__emit(prog, &insts_size, FRE_I_SAVE, entry, -1, (reverse ? 1 : 0))) == FRE_ERROR)
+    goto errjmp;
+  prog->start = entry;
+  intern__fre__byte_classes(prog);
+  return prog;
+
+ errjmp:
+  intern__fre__free_prog(prog);
+  return NULL;
+
+} /* intern__fre__compile_prog() */
+
+
+/*
+ * Put programs side by side into one, the FRE_I_MATCH of the Nth program
+ * getting ids[N] for ->arg. A chain of splits, after the programs, starts them all.
+ */
+fre_prog* intern__fre__combine_progs(fre_prog **progs,
+				     const int *ids,
+				     size_t numof_progs)
+{
+  size_t i = 0, j = 0, numof_insts = 0, numof_sets = 0;
+  int base = 0, set_base = 0, split_base = 0;
+  fre_inst *inst = NULL;
+  fre_prog *prog = NULL;
+
+  if (!progs || !ids || numof_progs == 0){
+    errno = EINVAL;
+    return NULL;
+  }
+  for (i = 0; i < numof_progs; i++){
+    numof_insts += progs[i]->numof_insts;
+    numof_sets += progs[i]->numof_sets;
+  }
+  split_base = (int)numof_insts;
+  numof_insts += numof_progs - 1;
+  if ((prog = calloc(1, sizeof(fre_prog))) == NULL){
+    intern__fre__errmesg("Calloc");
+    return NULL;
+  }
+  if ((prog->insts = malloc(numof_insts * sizeof(fre_inst))) == NULL
+      || (prog->sets = malloc((numof_sets ? numof_sets : 1) * sizeof(*prog->sets))) == NULL){
+    intern__fre__errmesg("Malloc");
+    intern__fre__free_prog(prog);
+    return NULL;
+  }
+  for (i = 0; i < numof_progs; i++){
+    memcpy(prog->sets + set_base, progs[i]->sets, progs[i]->numof_sets * sizeof(*prog->sets));
+    for (j = 0; j < progs[i]->numof_insts; j++){
+      inst = &prog->insts[base + (int)j];
+      *inst = progs[i]->insts[j];
+      if (inst->out >= 0)
+	inst->out += base;
+      if (inst->out1 >= 0)
+	inst->out1 += base;
+      if (inst->op == FRE_I_BYTES)
+	inst->arg += set_base;
+      else if (inst->op == FRE_I_MATCH)
+	inst->arg = ids[i];
+    }
+    /* The Nth split starts the Nth program, or goes on to the next split. */
+    if (i + 1 < numof_progs){
+      inst = &prog->insts[split_base + (int)i];
+      inst->op = FRE_I_SPLIT;
+      inst->out = progs[i]->start + base;
+      inst->out1 = ((i + 2 < numof_progs) ? split_base + (int)i + 1
+		    : progs[i+1]->start + base + (int)progs[i]->numof_insts);
+      inst->arg = 0;
+    }
+    base += (int)progs[i]->numof_insts;
+    set_base += (int)progs[i]->numof_sets;
+    prog->assertions |= progs[i]->assertions;
+  }
+  prog->start = ((numof_progs > 1) ? split_base : progs[0]->start);
+  prog->numof_insts = numof_insts;
+  prog->numof_sets = numof_sets;
+  intern__fre__byte_classes(prog);
+  return prog;
+
+} /* intern__fre__combine_progs() */
+
+
+/* Copy a program. */
+fre_prog* intern__fre__clone_prog(fre_prog *prog)
+{
+  fre_prog *clone = NULL;
+
+  if (prog == NULL){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((clone = malloc(sizeof(fre_prog))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return NULL;
+  }
+  *clone = *prog;
+  clone->insts = NULL;
+  clone->sets = NULL;
+  if ((clone->insts = malloc(prog->numof_insts * sizeof(fre_inst))) == NULL
+      || (clone->sets = malloc((prog->numof_sets ? prog->numof_sets : 1) * sizeof(*prog->sets))) == NULL){
+    intern__fre__errmesg("Malloc");
+    intern__fre__free_prog(clone);
+    return NULL;
+  }
+  memcpy(clone->insts, prog->insts, prog->numof_insts * sizeof(fre_inst));
+  memcpy(clone->sets, prog->sets, prog->numof_sets * sizeof(*prog->sets));
+  return clone;
+
+} /* intern__fre__clone_prog() */
+
+
+/* Release a program. */
+void intern__fre__free_prog(fre_prog *prog)
+{
+  if (prog == NULL)
+    return;
+  if (prog->insts != NULL)
+    free(prog->insts);
+  if (prog->sets != NULL)
+    free(prog->sets);
+  free(prog);
+
+} /* intern__fre__free_prog() */
+
+
+/* What is known of the literals found in the matches of a node of the tree. */
+typedef struct fre_lit_info {
+  bool                  exact;            /* True when the node only matches ->prefix. */
+  fre_literal           prefix;           /* Every match begins with it. */
+  fre_literal           suffix;           /* Every match ends with it. */
+  fre_literal           required;         /* Every match contains it. */
+
+} fre_lit_info;
+
+
+/*
+ * Write a followed by b to dest, dest may be a or b.
+ * Past FRE_LITERAL_MAX_LENGHT, keep the tail of it when keep_tail is true, its head otherwise.
+ */
+static void intern__fre__lit_cat(fre_literal *dest,
+				 const fre_literal *a,
+				 const fre_literal *b,
+				 bool keep_tail)
+{
+  size_t i = 0, skip = 0;
+  fre_literal joint;
+
+  joint.len = 0;
+  joint.prefix = false;
+  if (keep_tail && a->len + b->len > FRE_LITERAL_MAX_LENGHT)
+    skip = a->len + b->len - FRE_LITERAL_MAX_LENGHT;
+  for (i = skip; i < a->len + b->len && joint.len < FRE_LITERAL_MAX_LENGHT; i++){
+    joint.bytes[joint.len] = ((i < a->len) ? a->bytes[i] : b->bytes[i - a->len]);
+    joint.alt[joint.len++] = ((i < a->len) ? a->alt[i] : b->alt[i - a->len]);
+  }
+  *dest = joint;
+
+} /* intern__fre__lit_cat() */
+
+
+/* Keep the longest of dest and candidate in dest. */
+static void intern__fre__lit_longest(fre_literal *dest,
+				     const fre_literal *candidate)
+{
+  if (candidate->len > dest->len)
+    *dest = *candidate;
+
+} /* intern__fre__lit_longest() */
+
+
+/*
+ * Gather, bottom-up, the literals every match of a node begins with, ends with and contains.
+ * Positions of a literal accept one byte, or two, as a bracket expression or REG_ICASE
+ * may ask for. Zero-width assertions don't break a literal, they're checked by the engine.
+ */
+static void intern__fre__literal_info(fre_ast_tree *tree,
+				      int node_ind,
+				      fre_lit_info *info)
+{
+  size_t c = 0, n = 0, numof_bytes = 0;
+  int i = 0;
+  bool left_exact = false;
+  fre_ast_node *node = &tree->nodes[node_ind];
+  fre_lit_info other;
+  fre_literal joint;
+
+  memset(info, 0, sizeof(fre_lit_info));
+  switch (node->kind){
+  case FRE_AST_EMPTY:
+  case FRE_AST_ASSERT:
+    info->exact = true;
+    return;
+  case FRE_AST_BYTES:
+    for (c = 0; c < 256 && numof_bytes <= 2; c++){
+      if (FRE_SET_HAS(tree->sets[node->arg], c)){
+	if (numof_bytes++ == 0)
+	  info->prefix.bytes[0] = (unsigned char)c;
+	info->prefix.alt[0] = (unsigned char)c;
+      }
+    }
+    if (numof_bytes == 0 || numof_bytes > 2)
+      return;
+    info->prefix.len = 1;
+    info->exact = true;
+    break;
+  case FRE_AST_GROUP:
+    intern__fre__literal_info(tree, node->left, info);
+    return;
+  case FRE_AST_CAT:
+    intern__fre__literal_info(tree, node->left, info);
+    intern__fre__literal_info(tree, node->right, &other);
+    if (info->exact && other.exact
+	&& info->prefix.len + other.prefix.len <= FRE_LITERAL_MAX_LENGHT){
+      intern__fre__lit_cat(&info->prefix, &info->prefix, &other.prefix, false);
+      break;
+    }
+    left_exact = info->exact;
+    info->exact = false;
+    intern__fre__lit_cat(&joint, &info->suffix, &other.prefix, false);
+    if (other.exact)
+      intern__fre__lit_cat(&info->suffix, &info->suffix, &other.prefix, true);
+    else
+      info->suffix = other.suffix;
+    if (left_exact)
+      intern__fre__lit_cat(&info->prefix, &info->prefix, &other.prefix, false);
+    intern__fre__lit_longest(&info->required, &other.required);
+    intern__fre__lit_longest(&info->required, &joint);
+    intern__fre__lit_longest(&info->required, &info->prefix);
+    intern__fre__lit_longest(&info->required, &info->suffix);
+    return;
+  case FRE_AST_ALT:
+    intern__fre__literal_info(tree, node->left, info);
+    intern__fre__literal_info(tree, node->right, &other);
+    if (info->exact && other.exact && info->prefix.len == other.prefix.len
+	&& memcmp(info->prefix.bytes, other.prefix.bytes, other.prefix.len) == 0
+	&& memcmp(info->prefix.alt, other.prefix.alt, other.prefix.len) == 0)
+      return;
+    info->exact = false;
+    for (n = 0; n < info->prefix.len && n < other.prefix.len; n++)
+      if (info->prefix.bytes[n] != other.prefix.bytes[n] || info->prefix.alt[n] != other.prefix.alt[n])
+	break;
+    info->prefix.len = n;
+    for (n = 0; n < info->suffix.len && n < other.suffix.len; n++)
+      if (info->suffix.bytes[info->suffix.len - n - 1] != other.suffix.bytes[other.suffix.len - n - 1]
+	  || info->suffix.alt[info->suffix.len - n - 1] != other.suffix.alt[other.suffix.len - n - 1])
+	break;
+    memmove(info->suffix.bytes, info->suffix.bytes + info->suffix.len - n, n);
+    memmove(info->suffix.alt, info->suffix.alt + info->suffix.len - n, n);
+    info->suffix.len = n;
+    info->required = info->prefix;
+    intern__fre__lit_longest(&info->required, &info->suffix);
+    return;
+  case FRE_AST_REPEAT:
+    if (node->max == 0){
+      info->exact = true;
+      return;
+    }
+    intern__fre__literal_info(tree, node->left, info);
+    if (node->min == 0){
+      memset(info, 0, sizeof(fre_lit_info));
+      return;
+    }
+    if (!info->exact || info->prefix.len == 0)
+      return;
+    /* x{n} of a literal x is a literal, x{n,m} begins and ends with x{n}. */
+    joint = info->prefix;
+    for (i = 1; i < node->min && info->prefix.len < FRE_LITERAL_MAX_LENGHT; i++)
+      intern__fre__lit_cat(&info->prefix, &info->prefix, &joint, false);
+    if (node->min == node->max && (size_t)node->min * joint.len <= FRE_LITERAL_MAX_LENGHT)
+      break;
+    for (i = 1; i < node->min && info->suffix.len < FRE_LITERAL_MAX_LENGHT; i++)
+      intern__fre__lit_cat(&info->suffix, &info->suffix, &joint, true);
+    info->exact = false;
+    info->required = info->prefix;
+    return;
+  default:
+    return;
+  }
+  /* An exact literal is its own prefix, suffix and required literal. */
+  info->suffix = info->required = info->prefix;
+
+} /* intern__fre__literal_info() */
+
+
+/*
+ * Find a literal every match of a parsed pattern contains, to look for
+ * before running the pattern's engine. The literal every match begins with
+ * is preferred, the engine can then start right at it, unless some other literal
+ * is much longer. Returns NULL when there's none.
+ */
+fre_literal* intern__fre__extract_literal(fre_ast_tree *tree)
+{
+  fre_lit_info info;
+  fre_literal *lit = NULL;
+
+  if (!tree){
+    errno = EINVAL;
+    return NULL;
+  }
+  intern__fre__literal_info(tree, tree->root, &info);
+  if (info.prefix.len == 0 && info.required.len == 0)
+    return NULL;
+  if ((lit = malloc(sizeof(fre_literal))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return NULL;
+  }
+  if (info.prefix.len > 0 && info.prefix.len * 2 >= info.required.len){
+    *lit = info.prefix;
+    lit->prefix = true;
+  }
+  else {
+    *lit = info.required;
+    lit->prefix = false;
+  }
+  return lit;
+
+} /* intern__fre__extract_literal() */
+
+
+/*
+ * The byte stood for by the character of a POSIX ERE at *pos, an ordinary character
+ * or a special one escaped as \Q..\E does, *pos is then moved past it.
+ * Returns -1, leaving *pos alone, for anything else.
+ */
+int intern__fre__literal_char(const char *pattern,
+			      size_t *pos)
+{
+  const char *p = pattern + *pos;
+
+  if (*p == '\0')
+    return -1;
+  if (*p == '\\'){
+    if (p[1] == '\0' || strchr(".[\\()*+?{|^$", p[1]) == NULL)
+      return -1;
+    *pos += 2;
+    return (unsigned char)p[1];
+  }
+  if (strchr(".[()*+?{|^$", *p) != NULL)
+    return -1;
+  *pos += 1;
+  return (unsigned char)*p;
+
+} /* intern__fre__literal_char() */
+
+
+/*
+ * Give a matching pattern that's nothing but a literal, ordinary characters
+ * and escaped special ones as \Q..\E leaves them, to FRE_ENGINE_LITERAL.
+ * Such a pattern is never handed to regcomp(). Under REG_ICASE, a position
+ * accepts every byte regcomp() would fold the same way, when there's two of them at most.
+ * Returns FRE_OP_UNSUCCESSFUL for any other pattern.
+ */
+int intern__fre__compile_literal(fre_pattern *freg_object)
+{
+  size_t i = 0, len = 0;
+  int c = 0, other = 0, numof_bytes = 0;
+  const char *p = NULL;
+  fre_literal lit;
+
+  if (!freg_object){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  if (freg_object->fre_op_flag == TRANSLITERATE
+      || freg_object->backref_pos->in_pattern_c > 0
+      || MB_CUR_MAX != 1)
+    return FRE_OP_UNSUCCESSFUL;
+
+  p = freg_object->striped_pattern[0];
+  while (p[i] != '\0'){
+    if (len == FRE_LITERAL_MAX_LENGHT || (c = intern__fre__literal_char(p, &i)) == -1)
+      return FRE_OP_UNSUCCESSFUL;
+    lit.bytes[len] = lit.alt[len] = (unsigned char)c;
+    if (freg_object->fre_mod_icase){
+      for (other = 0, numof_bytes = 0; other < 256; other++){
+	if (other != c && tolower(other) == tolower(c)){
+	  lit.alt[len] = (unsigned char)other;
+	  ++numof_bytes;
+	}
+      }
+      if (numof_bytes > 1)
+	return FRE_OP_UNSUCCESSFUL;
+    }
+    ++len;
+  }
+  if (len == 0)
+    return FRE_OP_UNSUCCESSFUL;
+  lit.len = len;
+  lit.prefix = true;
+  if ((freg_object->literal = malloc(sizeof(fre_literal))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return FRE_ERROR;
+  }
+  *freg_object->literal = lit;
+  freg_object->numof_groups = 0;
+  freg_object->engine = FRE_ENGINE_LITERAL;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__compile_literal() */
+
+
+/*
+ * Whether the Pike VM finds the sub-matches regexec() would in a node, *nullable
+ * set when the node can match the empty string, *grouped when it has a group.
+ * Taking a repetition's iterations greedily, a backtracking matcher's way,
+ * may go through one more empty iteration than regexec() does: such
+ * repetitions of a group are left to regexec().
+ */
+static bool intern__fre__pike_captures(fre_ast_tree *tree,
+				       int node_ind,
+				       bool *nullable,
+				       bool *grouped)
+{
+  bool ok = true, other_nullable = false, other_grouped = false;
+  fre_ast_node *node = &tree->nodes[node_ind];
+
+  *nullable = *grouped = false;
+  switch (node->kind){
+  case FRE_AST_EMPTY:
+  case FRE_AST_ASSERT:
+  case FRE_AST_BREF:
+    *nullable = true;
+    return true;
+  case FRE_AST_BYTES:
+    return true;
+  case FRE_AST_GROUP:
+    ok = intern__fre__pike_captures(tree, node->left, nullable, grouped);
+    *grouped = true;
+    return ok;
+  case FRE_AST_CAT:
+  case FRE_AST_ALT:
+    ok = intern__fre__pike_captures(tree, node->left, nullable, grouped);
+    if (!intern__fre__pike_captures(tree, node->right, &other_nullable, &other_grouped))
+      ok = false;
+    *nullable = ((node->kind == FRE_AST_CAT) ? (*nullable && other_nullable) : (*nullable || other_nullable));
+    *grouped = *grouped || other_grouped;
+    return ok;
+  case FRE_AST_REPEAT:
+    ok = intern__fre__pike_captures(tree, node->left, nullable, grouped);
+    if (*nullable && *grouped && (node->max == -1 || node->max > 1))
+      ok = false;
+    *nullable = *nullable || node->min == 0;
+    return ok;
+  default:
+    return false;
+  }
+
+} /* intern__fre__pike_captures() */
+
+
+/*
+ * Pick the engine executing a pattern's matching pattern.
+ * Once regcomp() accepted ->striped_pattern[0], try to build the DFA, or the
+ * backtracker when the pattern has back-references, if the locale is single-byte.
+ * Any reason not to use it just leaves the pattern to regexec().
+ * The literal its matches contain, if any, is kept in ->literal either way.
+ */
+int intern__fre__compile_native(fre_pattern *freg_object)
+{
+  int ret = 0;
+  bool pike_captures = false, nullable = false, grouped = false;
+  fre_ast_tree *tree = NULL;
+
+  if (!freg_object){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  freg_object->engine = FRE_ENGINE_REGEX;
+  if (freg_object->fre_op_flag == TRANSLITERATE
+      || MB_CUR_MAX != 1)
+    return FRE_OP_UNSUCCESSFUL;
+
+  if ((ret = intern__fre__parse_ere(freg_object->striped_pattern[0],
+				    freg_object->fre_mod_icase,
+				    !freg_object->fre_mod_newline, &tree)) != FRE_OP_SUCCESSFUL)
+    return ret;
+  freg_object->literal = intern__fre__extract_literal(tree);
+  /* No DFA can match back-references, the backtracker does, without regexec(). */
+  if (tree->backrefs){
+    if ((freg_object->prog = intern__fre__compile_prog(tree, false)) == NULL
+	|| (freg_object->bt = intern__fre__bt_build(freg_object->prog,
+						    freg_object->fre_mod_icase)) == NULL)
+      goto unsupported;
+    intern__fre__free_ast(tree);
+    freg_object->numof_groups = freg_object->prog->numof_groups;
+    freg_object->engine = FRE_ENGINE_BACKTRACK;
+    return FRE_OP_SUCCESSFUL;
+  }
+  if ((freg_object->prog = intern__fre__compile_prog(tree, false)) == NULL
+      || (freg_object->rev_prog = intern__fre__compile_prog(tree, true)) == NULL)
+    goto unsupported;
+  pike_captures = intern__fre__pike_captures(tree, tree->root, &nullable, &grouped);
+  /* Optional, the DFA alone will do without it. */
+  if ((freg_object->bitpar = intern__fre__bitpar_build(tree)) == NULL)
+    errno = 0;
+  intern__fre__free_ast(tree);
+  tree = NULL;
+  if ((freg_object->dfa = intern__fre__dfa_build(freg_object->prog, false)) == NULL
+      || (freg_object->rev_dfa = intern__fre__dfa_build(freg_object->rev_prog, true)) == NULL)
+    goto unsupported;
+  /* The DFA finds where matches are, the Pike VM the sub-matches in them, or regexec(). */
+  if (freg_object->prog->numof_groups > 0 && pike_captures
+      && (freg_object->pike = intern__fre__pike_build(freg_object->prog)) == NULL)
+    goto unsupported;
+  freg_object->numof_groups = freg_object->prog->numof_groups;
+  freg_object->engine = FRE_ENGINE_DFA;
+  /* Optional as well, when asked for by fre_jit_set_enabled(). */
+  if (__atomic_load_n(&fre_jit_enabled, __ATOMIC_RELAXED)
+      && (freg_object->jit = intern__fre__jit_build(freg_object)) == NULL)
+    errno = 0;
+  return FRE_OP_SUCCESSFUL;
+
+ unsupported:
+  /* Too many instructions, or short on memory: regexec() will do. */
+  errno = 0;
+  intern__fre__free_ast(tree);
+  intern__fre__free_bt(freg_object->bt);
+  intern__fre__free_pike(freg_object->pike);
+  intern__fre__free_bitpar(freg_object->bitpar);
+  intern__fre__free_dfa(freg_object->dfa);
+  intern__fre__free_dfa(freg_object->rev_dfa);
+  intern__fre__free_prog(freg_object->prog);
+  intern__fre__free_prog(freg_object->rev_prog);
+  freg_object->bt = NULL;
+  freg_object->pike = NULL;
+  freg_object->bitpar = NULL;
+  freg_object->dfa = freg_object->rev_dfa = NULL;
+  freg_object->prog = freg_object->rev_prog = NULL;
+  return FRE_OP_UNSUCCESSFUL;
+
+} /* intern__fre__compile_native() */
+
+
+/*
+ * Find the leftmost-longest match at or after start with the pattern's native engine.
+ * match receives the whole match only, sub-matches are left to regexec().
+ */
+int intern__fre__exec_native(fre_pattern *freg_object,
+			     char *string,
+			     size_t string_len,
+			     size_t start,
+			     fre_smatch *match)
+{
+  int ret = 0;
+  const unsigned char *found = NULL;
+
+  switch (freg_object->engine){
+  case FRE_ENGINE_DFA:
+    /* The bit-parallel scanner finds whether a match ends, the DFA where it is. */
+    if (freg_object->bitpar != NULL
+	&& (ret = intern__fre__bitpar_exec(freg_object->bitpar, (const unsigned char*)string,
+					   string_len, start, &start)) != FRE_OP_SUCCESSFUL)
+      return ret;
+    return intern__fre__dfa_exec(freg_object, (const unsigned char*)string,
+				 string_len, start, match);
+  case FRE_ENGINE_AC:
+    return intern__fre__ac_exec(freg_object->ac, (const unsigned char*)string,
+				string_len, start, match);
+  case FRE_ENGINE_LITERAL:
+    if ((found = intern__fre__find_literal((const unsigned char*)string + start, string_len - start,
+					   freg_object->literal)) == NULL)
+      return FRE_OP_UNSUCCESSFUL;
+    match->bo = (fre_off)((const char*)found - string);
+    match->eo = match->bo + (fre_off)freg_object->literal->len;
+    return FRE_OP_SUCCESSFUL;
+  default:
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+
+} /* intern__fre__exec_native() */
+
+
+/*
+ * Lenght of the longest match of a pattern, -1 when there's none: its program
+ * loops, it has back-references, or regexec() runs it. The program is walked
+ * depth first, an instruction met again before it's done closes a loop.
+ */
+ssize_t intern__fre__max_match_len(fre_pattern *freg_object)
+{
+  size_t sp = 0, i = 0;
+  int pc = 0, next[2] = { -1, -1 };
+  int *stack = NULL;
+  uint8_t *color = NULL;          /* 0 not seen yet, 1 being walked, 2 done. */
+  ssize_t *longest = NULL;        /* Longest path from each instruction to FRE_I_MATCH, -1 for none. */
+  ssize_t retval = -1;
+  const fre_inst *inst = NULL;
+  fre_prog *prog = NULL;
+
+  if (!freg_object){
+    errno = EINVAL;
+    return -1;
+  }
+  switch (freg_object->engine){
+  case FRE_ENGINE_LITERAL:
+    return (ssize_t)freg_object->literal->len;
+  case FRE_ENGINE_AC:
+    return (ssize_t)freg_object->ac->max_len;
+  case FRE_ENGINE_DFA:
+    prog = freg_object->prog;
+    break;
+  default:
+    return -1;
+  }
+  if ((stack = malloc((2 * prog->numof_insts + 1) * sizeof(int))) == NULL
+      || (color = calloc(prog->numof_insts, sizeof(uint8_t))) == NULL
+      || (longest = malloc(prog->numof_insts * sizeof(ssize_t))) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto cleanup;
+  }
+
+  stack[sp++] = prog->start;
+  while (sp > 0){
+    pc = stack[sp - 1];
+    inst = &prog->insts[pc];
+    next[0] = ((inst->op == FRE_I_MATCH) ? -1 : inst->out);
+    next[1] = ((inst->op == FRE_I_SPLIT) ? inst->out1 : -1);
+    if (color[pc] == 0){
+      if (inst->op == FRE_I_BREF)
+	goto cleanup;
+      color[pc] = 1;
+      for (i = 0; i < 2; i++){
+	if (next[i] < 0)
+	  continue;
+	if (color[next[i]] == 1)
+	  goto cleanup;
+	if (color[next[i]] == 0)
+	  stack[sp++] = next[i];
+      }
+      continue;
+    }
+    --sp;
+    if (color[pc] == 2)
+      continue;
+    color[pc] = 2;
+    if (inst->op == FRE_I_MATCH)
+      longest[pc] = 0;
+    else if (inst->op == FRE_I_BYTES)
+      longest[pc] = ((longest[next[0]] < 0) ? -1 : longest[next[0]] + 1);
+    else {
+      longest[pc] = longest[next[0]];
+      if (next[1] >= 0 && longest[next[1]] > longest[pc])
+	longest[pc] = longest[next[1]];
+    }
+  }
+  retval = longest[prog->start];
+
+ cleanup:
+  if (stack)
+    free(stack);
+  if (color)
+    free(color);
+  if (longest)
+    free(longest);
+  return retval;
+
+} /* intern__fre__max_match_len() */
+
+
+/*
+ * Whether a match of the pattern may hold byte, true when it isn't known:
+ * patterns regexec() runs aren't looked into.
+ */
+bool intern__fre__matches_byte(fre_pattern *freg_object,
+			       unsigned char byte)
+{
+  size_t i = 0;
+  fre_prog *prog = NULL;
+
+  if (!freg_object)
+    return true;
+  switch (freg_object->engine){
+  case FRE_ENGINE_LITERAL:
+    for (i = 0; i < freg_object->literal->len; i++)
+      if (freg_object->literal->bytes[i] == byte || freg_object->literal->alt[i] == byte)
+	return true;
+    return false;
+  case FRE_ENGINE_AC:
+    /* Class 0 holds the bytes none of the literals has. */
+    return (freg_object->ac->byte_class[byte] != 0);
+  case FRE_ENGINE_DFA:
+  case FRE_ENGINE_BACKTRACK:
+    prog = freg_object->prog;
+    /* Back-references only match again what their group did. */
+    for (i = 0; i < prog->numof_insts; i++)
+      if (prog->insts[i].op == FRE_I_BYTES
+	  && (prog->sets[prog->insts[i].arg][byte >> 3] & (1u << (byte & 7))))
+	return true;
+    return false;
+  default:
+    return true;
+  }
+
+} /* intern__fre__matches_byte() */
@@ -0,0 +1,850 @@
+/*
+ *
+ *  Libfre  -  DFA matching engine.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/types.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+size_t fre_dfa_budget = FRE_DFA_DEFAULT_BUDGET; /* Set by fre_dfa_set_budget(). */
+
+
+/*
+ * A state is serialized, to be hashed and compared, as:
+ * [ key length, context, stopped, flags, numof_groups, (group length, instructions...)... ]
+ * Groups hold the instructions threads are at, the first group holding the threads
+ * that started matching the earliest. Once a group matches, later groups are dropped
+ * and no new thread is started (stopped): the match can only get longer from there.
+ * States of a multi DFA have all their threads in one group, followed by
+ * (number of patterns, patterns...), the patterns that matched right before the last byte.
+ */
+#define FRE_KEY_LEN           0
+#define FRE_KEY_CTX           1
+#define FRE_KEY_STOPPED       2
+#define FRE_KEY_FLAGS         3
+#define FRE_KEY_NUMOF_GROUPS  4
+#define FRE_KEY_HEADER        5
+
+#define FRE_SET_HAS(set, byte) ((set)[(byte) >> 3] & (1u << ((byte) & 7)))
+
+/* States are flushed before their rows could overflow an int32_t offset. */
+#define FRE_DFA_MAX_ROWS      (INT32_MAX / 2)
+
+static int32_t intern__fre__dfa_step(fre_dfa *dfa, int32_t state_ind, int cls, bool *eot_match);
+static int32_t intern__fre__set_step(fre_dfa *dfa, int32_t state_ind, int cls, bool *eot_match);
+
+
+/* Whether an assertion holds between a position's prev and next contexts. */
+bool intern__fre__assert_holds(int assertion,
+			       int prev,
+			       int next)
+{
+  switch (assertion){
+  case FRE_ASSERT_BOT:    return prev == FRE_CTX_EDGE;
+  case FRE_ASSERT_EOT:    return next == FRE_CTX_EDGE;
+  case FRE_ASSERT_BOL:    return prev == FRE_CTX_EDGE || prev == FRE_CTX_NEWLINE;
+  case FRE_ASSERT_EOL:    return next == FRE_CTX_EDGE || next == FRE_CTX_NEWLINE;
+  case FRE_ASSERT_WORDB:  return (prev == FRE_CTX_WORD) != (next == FRE_CTX_WORD);
+  case FRE_ASSERT_NWORDB: return (prev == FRE_CTX_WORD) == (next == FRE_CTX_WORD);
+  case FRE_ASSERT_BOW:    return prev != FRE_CTX_WORD && next == FRE_CTX_WORD;
+  case FRE_ASSERT_EOW:    return prev == FRE_CTX_WORD && next != FRE_CTX_WORD;
+  default:                return false;
+  }
+
+} /* intern__fre__assert_holds() */
+
+
+/* Hash of a serialized state. */
+static size_t intern__fre__key_hash(const int *key)
+{
+  size_t i = 0, hash = 2166136261u;
+  for (i = 0; i < (size_t)key[FRE_KEY_LEN]; i++){
+    hash ^= (size_t)(unsigned int)key[i];
+    hash *= 16777619u;
+  }
+  return hash;
+
+} /* intern__fre__key_hash() */
+
+
+/* Make room for n more ints in the key being built. */
+static int intern__fre__key_reserve(fre_dfa *dfa,
+				    size_t n)
+{
+  int *temp = NULL;
+  size_t size = dfa->key_size;
+
+  if ((size_t)dfa->key[FRE_KEY_LEN] + n <= size)
+    return FRE_OP_SUCCESSFUL;
+  while ((size_t)dfa->key[FRE_KEY_LEN] + n > size)
+    size *= 2;
+  if ((temp = realloc(dfa->key, size * sizeof(int))) == NULL){
+    intern__fre__errmesg("Realloc");
+    return FRE_ERROR;
+  }
+  dfa->key = temp;
+  dfa->key_size = size;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__key_reserve() */
+
+
+/* Double the hash table of keys. */
+static int intern__fre__grow_key_table(fre_dfa *dfa)
+{
+  size_t i = 0, slot = 0, size = dfa->key_table_size * 2;
+  int32_t *table = NULL;
+
+  if ((table = malloc(size * sizeof(int32_t))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return FRE_ERROR;
+  }
+  memset(table, 0xff, size * sizeof(int32_t));
+  for (i = 0; i < dfa->numof_states; i++){
+    slot = intern__fre__key_hash(dfa->keys[i]) & (size - 1);
+    while (table[slot] != -1)
+      slot = (slot + 1) & (size - 1);
+    table[slot] = (int32_t)i;
+  }
+  dfa->mem_used += (size - dfa->key_table_size) * sizeof(int32_t);
+  free(dfa->key_table);
+  dfa->key_table = table;
+  dfa->key_table_size = size;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__grow_key_table() */
+
+
+/*
+ * Find or add the state serialized in key, returns its index or FRE_ERROR.
+ * A new state has all its transitions unknown.
+ */
+static int32_t intern__fre__dfa_add_state(fre_dfa *dfa,
+					  const int *key)
+{
+  size_t i = 0, slot = 0, size = 0;
+  size_t numof_classes = dfa->prog->numof_classes;
+  int32_t found = 0;
+  bool eot_match = false;
+  void *temp = NULL;
+
+  slot = intern__fre__key_hash(key) & (dfa->key_table_size - 1);
+  while ((found = dfa->key_table[slot]) != -1){
+    if (dfa->keys[found][FRE_KEY_LEN] == key[FRE_KEY_LEN]
+	&& memcmp(dfa->keys[found], key, (size_t)key[FRE_KEY_LEN] * sizeof(int)) == 0)
+      return found;
+    slot = (slot + 1) & (dfa->key_table_size - 1);
+  }
+
+  if (dfa->numof_states == dfa->states_size){
+    size = dfa->states_size * 2;
+    if ((temp = realloc(dfa->keys, size * sizeof(int*))) == NULL){
+      intern__fre__errmesg("Realloc");
+      return FRE_ERROR;
+    }
+    dfa->keys = temp;
+    if ((temp = realloc(dfa->state_flags, size * sizeof(uint8_t))) == NULL){
+      intern__fre__errmesg("Realloc");
+      return FRE_ERROR;
+    }
+    dfa->state_flags = temp;
+    if ((temp = realloc(dfa->trans, size * numof_classes * sizeof(int32_t))) == NULL){
+      intern__fre__errmesg("Realloc");
+      return FRE_ERROR;
+    }
+    dfa->trans = temp;
+    dfa->states_size = size;
+  }
+  if ((dfa->keys[dfa->numof_states] = malloc((size_t)key[FRE_KEY_LEN] * sizeof(int))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return FRE_ERROR;
+  }
+  memcpy(dfa->keys[dfa->numof_states], key, (size_t)key[FRE_KEY_LEN] * sizeof(int));
+  dfa->state_flags[dfa->numof_states] = (uint8_t)key[FRE_KEY_FLAGS];
+  for (i = 0; i < numof_classes; i++)
+    dfa->trans[dfa->numof_states * numof_classes + i] = FRE_DFA_UNKNOWN;
+  dfa->key_table[slot] = (int32_t)dfa->numof_states;
+  found = (int32_t)dfa->numof_states++;
+  dfa->mem_used += ((size_t)key[FRE_KEY_LEN] * sizeof(int) + sizeof(int*) + sizeof(uint8_t)
+		    + numof_classes * sizeof(int32_t));
+  if (dfa->numof_states * 2 > dfa->key_table_size
+      && intern__fre__grow_key_table(dfa) == FRE_ERROR)
+    return FRE_ERROR;
+
+  /* Whether a match ends if the text ends right here. */
+  intern__fre__dfa_step(dfa, found, -1, &eot_match);
+  if (eot_match)
+    dfa->state_flags[found] |= FRE_DFA_EOT_MATCH;
+  return found;
+
+} /* intern__fre__dfa_add_state() */
+
+
+/*
+ * Follow every instruction not consuming a byte from pc, in the order
+ * a backtracking matcher would, with next_ctx the context of the next byte.
+ * Instructions consuming a byte are pushed to the kernel array, returns true when MATCH is reached.
+ */
+static bool intern__fre__closure(fre_dfa *dfa,
+				 int pc,
+				 int prev_ctx,
+				 int next_ctx,
+				 int *kernel,
+				 size_t *numof_kernel)
+{
+  size_t sp = 0;
+  bool matched = false;
+  fre_inst *inst = NULL;
+
+  dfa->stack[sp++] = pc;
+  while (sp > 0){
+    pc = dfa->stack[--sp];
+    if (dfa->visited[pc] == dfa->generation)
+      continue;
+    dfa->visited[pc] = dfa->generation;
+    inst = &dfa->prog->insts[pc];
+    switch (inst->op){
+    case FRE_I_BYTES:
+      kernel[(*numof_kernel)++] = pc;
+      break;
+    case FRE_I_SPLIT:
+      dfa->stack[sp++] = inst->out1;
+      dfa->stack[sp++] = inst->out;
+      break;
+    case FRE_I_ASSERT:
+      if (intern__fre__assert_holds(inst->arg, prev_ctx, next_ctx))
+	dfa->stack[sp++] = inst->out;
+      break;
+    case FRE_I_SAVE:
+      dfa->stack[sp++] = inst->out;
+      break;
+    case FRE_I_MATCH:
+      matched = true;
+      if (dfa->multi)
+	dfa->ids[dfa->numof_ids++] = inst->arg;
+      break;
+    case FRE_I_BREF:
+      /* Programs with back-references go to the backtracker, never to a DFA. */
+      break;
+    }
+  }
+  return matched;
+
+} /* intern__fre__closure() */
+
+
+/*
+ * Find or add the state reached from state_ind on the byte class cls,
+ * cls == -1 standing for the end of the text: then only whether a match
+ * ends there is computed, into *eot_match.
+ * Returns the index of the state or FRE_ERROR.
+ */
+static int32_t intern__fre__dfa_step(fre_dfa *dfa,
+				     int32_t state_ind,
+				     int cls,
+				     bool *eot_match)
+{
+  fre_prog *prog = dfa->prog;
+  const int *from = dfa->keys[state_ind];
+  int *kernel = NULL, *group = NULL;
+  int g = 0, numof_groups = from[FRE_KEY_NUMOF_GROUPS], prev_ctx = from[FRE_KEY_CTX];
+  int next_ctx = ((cls < 0) ? FRE_CTX_EDGE : prog->class_ctx[cls]);
+  int byte = ((cls < 0) ? 0 : prog->class_repr[cls]);
+  size_t i = 0, pos = FRE_KEY_HEADER, group_len = 0, numof_kernel = 0;
+  bool stopped = (from[FRE_KEY_STOPPED] != 0), matched = false;
+
+  if (dfa->multi)
+    return intern__fre__set_step(dfa, state_ind, cls, eot_match);
+  if (++dfa->generation == 0){
+    memset(dfa->visited, 0, prog->numof_insts * sizeof(unsigned int));
+    memset(dfa->targeted, 0, prog->numof_insts * sizeof(unsigned int));
+    dfa->generation = 1;
+  }
+  dfa->key[FRE_KEY_LEN] = FRE_KEY_HEADER;
+  dfa->key[FRE_KEY_CTX] = ((prog->assertions != 0) ? next_ctx : 0);
+  dfa->key[FRE_KEY_NUMOF_GROUPS] = 0;
+  kernel = dfa->stack + (2 * prog->numof_insts + 1);
+  /* Groups of the state, then the thread starting at this position. */
+  for (g = 0; g <= numof_groups; g++){
+    numof_kernel = 0;
+    if (g < numof_groups){
+      group_len = (size_t)from[pos++];
+      group = (int*)&from[pos];
+      pos += group_len;
+      for (i = 0; i < group_len; i++)
+	if (intern__fre__closure(dfa, group[i], prev_ctx, next_ctx, kernel, &numof_kernel))
+	  matched = true;
+    }
+    else if (!stopped && !dfa->anchored)
+      matched = intern__fre__closure(dfa, prog->start, prev_ctx, next_ctx, kernel, &numof_kernel);
+    else
+      break;
+    if (cls >= 0){
+      if (intern__fre__key_reserve(dfa, numof_kernel + 1) == FRE_ERROR)
+	return FRE_ERROR;
+      group_len = 0;
+      for (i = 0; i < numof_kernel; i++){
+	fre_inst *inst = &prog->insts[kernel[i]];
+	if (FRE_SET_HAS(prog->sets[inst->arg], byte)
+	    && dfa->targeted[inst->out] != dfa->generation){
+	  dfa->targeted[inst->out] = dfa->generation;
+	  dfa->key[dfa->key[FRE_KEY_LEN] + 1 + (int)group_len++] = inst->out;
+	}
+      }
+      if (group_len > 0){
+	dfa->key[dfa->key[FRE_KEY_LEN]] = (int)group_len;
+	dfa->key[FRE_KEY_LEN] += (int)group_len + 1;
+	++dfa->key[FRE_KEY_NUMOF_GROUPS];
+      }
+    }
+    if (matched){
+      stopped = true;
+      break;
+    }
+  }
+  if (cls < 0){
+    *eot_match = matched;
+    return state_ind;
+  }
+  dfa->key[FRE_KEY_STOPPED] = (stopped ? 1 : 0);
+  dfa->key[FRE_KEY_FLAGS] = ((matched ? FRE_DFA_MATCH : 0)
+			     | ((stopped && dfa->key[FRE_KEY_NUMOF_GROUPS] == 0) ? FRE_DFA_DEAD : 0));
+  return intern__fre__dfa_add_state(dfa, dfa->key);
+
+} /* intern__fre__dfa_step() */
+
+
+/* For qsort(), sets of instructions and patterns are kept sorted in multi DFAs' keys. */
+static int intern__fre__int_cmp(const void *a,
+				const void *b)
+{
+  return ((*(const int*)a > *(const int*)b) - (*(const int*)a < *(const int*)b));
+
+} /* intern__fre__int_cmp() */
+
+
+/*
+ * intern__fre__dfa_step() of a multi DFA. Threads are never dropped nor ordered,
+ * one starts at every position, and the patterns they matched are kept in the state.
+ * With cls == -1, those that match if the text ends here are left in dfa->ids.
+ */
+static int32_t intern__fre__set_step(fre_dfa *dfa,
+				     int32_t state_ind,
+				     int cls,
+				     bool *eot_match)
+{
+  fre_prog *prog = dfa->prog;
+  const int *from = dfa->keys[state_ind];
+  int *kernel = NULL;
+  int prev_ctx = from[FRE_KEY_CTX];
+  int next_ctx = ((cls < 0) ? FRE_CTX_EDGE : prog->class_ctx[cls]);
+  int byte = ((cls < 0) ? 0 : prog->class_repr[cls]);
+  size_t i = 0, group_len = 0, numof_kernel = 0;
+
+  if (++dfa->generation == 0){
+    memset(dfa->visited, 0, prog->numof_insts * sizeof(unsigned int));
+    memset(dfa->targeted, 0, prog->numof_insts * sizeof(unsigned int));
+    dfa->generation = 1;
+  }
+  kernel = dfa->stack + (2 * prog->numof_insts + 1);
+  dfa->key[FRE_KEY_LEN] = FRE_KEY_HEADER;
+  dfa->numof_ids = 0;
+  if (from[FRE_KEY_NUMOF_GROUPS] > 0)
+    for (i = 0; i < (size_t)from[FRE_KEY_HEADER]; i++)
+      intern__fre__closure(dfa, from[FRE_KEY_HEADER + 1 + i], prev_ctx, next_ctx, kernel, &numof_kernel);
+  intern__fre__closure(dfa, prog->start, prev_ctx, next_ctx, kernel, &numof_kernel);
+  qsort(dfa->ids, dfa->numof_ids, sizeof(int), intern__fre__int_cmp);
+  if (cls < 0){
+    *eot_match = (dfa->numof_ids > 0);
+    return state_ind;
+  }
+
+  if (intern__fre__key_reserve(dfa, numof_kernel + dfa->numof_ids + 2) == FRE_ERROR)
+    return FRE_ERROR;
+  dfa->key[FRE_KEY_CTX] = ((prog->assertions != 0) ? next_ctx : 0);
+  dfa->key[FRE_KEY_STOPPED] = 0;
+  dfa->key[FRE_KEY_FLAGS] = ((dfa->numof_ids > 0) ? FRE_DFA_MATCH : 0);
+  dfa->key[FRE_KEY_NUMOF_GROUPS] = 0;
+  for (i = 0; i < numof_kernel; i++){
+    fre_inst *inst = &prog->insts[kernel[i]];
+    if (FRE_SET_HAS(prog->sets[inst->arg], byte)
+	&& dfa->targeted[inst->out] != dfa->generation){
+      dfa->targeted[inst->out] = dfa->generation;
+      dfa->key[FRE_KEY_HEADER + 1 + group_len++] = inst->out;
+    }
+  }
+  if (group_len > 0){
+    qsort(&dfa->key[FRE_KEY_HEADER + 1], group_len, sizeof(int), intern__fre__int_cmp);
+    dfa->key[FRE_KEY_HEADER] = (int)group_len;
+    dfa->key[FRE_KEY_LEN] += (int)group_len + 1;
+    dfa->key[FRE_KEY_NUMOF_GROUPS] = 1;
+  }
+  dfa->key[dfa->key[FRE_KEY_LEN]] = (int)dfa->numof_ids;
+  for (i = 0; i < dfa->numof_ids; i++)
+    dfa->key[dfa->key[FRE_KEY_LEN] + 1 + (int)i] = dfa->ids[i];
+  dfa->key[FRE_KEY_LEN] += (int)dfa->numof_ids + 1;
+  return intern__fre__dfa_add_state(dfa, dfa->key);
+
+} /* intern__fre__set_step() */
+
+
+/* Add the initial states, for each context of the byte before the scan. */
+static int intern__fre__dfa_init_states(fre_dfa *dfa)
+{
+  int ctx = 0;
+  int32_t state_ind = 0;
+  int key[FRE_KEY_HEADER + 2];
+
+  for (ctx = FRE_CTX_EDGE; ctx <= FRE_CTX_OTHER; ctx++){
+    key[FRE_KEY_LEN] = FRE_KEY_HEADER;
+    key[FRE_KEY_CTX] = ((dfa->prog->assertions != 0) ? ctx : 0);
+    key[FRE_KEY_STOPPED] = (dfa->anchored ? 1 : 0);
+    key[FRE_KEY_FLAGS] = 0;
+    key[FRE_KEY_NUMOF_GROUPS] = 0;
+    if (dfa->anchored){
+      key[FRE_KEY_NUMOF_GROUPS] = 1;
+      key[FRE_KEY_HEADER] = 1;
+      key[FRE_KEY_HEADER + 1] = dfa->prog->start;
+      key[FRE_KEY_LEN] += 2;
+    }
+    /* No pattern matched yet. */
+    if (dfa->multi)
+      key[key[FRE_KEY_LEN]++] = 0;
+    if ((state_ind = intern__fre__dfa_add_state(dfa, key)) == FRE_ERROR)
+      return FRE_ERROR;
+    dfa->init[ctx] = (int32_t)((size_t)state_ind * dfa->prog->numof_classes);
+  }
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__dfa_init_states() */
+
+
+/*
+ * Drop every state but the initial ones and keep_ind, the one a scan is at.
+ * Returns the new index of keep_ind or FRE_ERROR.
+ */
+static int32_t intern__fre__dfa_flush(fre_dfa *dfa,
+				      int32_t keep_ind)
+{
+  size_t i = 0;
+  int32_t state_ind = 0;
+  int *keep = dfa->keys[keep_ind];
+
+  for (i = 0; i < dfa->numof_states; i++)
+    if (i != (size_t)keep_ind)
+      free(dfa->keys[i]);
+  memset(dfa->key_table, 0xff, dfa->key_table_size * sizeof(int32_t));
+  dfa->numof_states = 0;
+  dfa->mem_used = dfa->key_table_size * sizeof(int32_t);
+  ++dfa->numof_flushes;
+  if (intern__fre__dfa_init_states(dfa) == FRE_ERROR){
+    free(keep);
+    return FRE_ERROR;
+  }
+  state_ind = intern__fre__dfa_add_state(dfa, keep);
+  free(keep);
+  return state_ind;
+
+} /* intern__fre__dfa_flush() */
+
+
+/*
+ * Build the state reached from the state at *row on the byte class cls,
+ * flushing the states first if they're over budget (*row is then updated).
+ * The transition is stored to *next, encoded as the DFA's transitions are.
+ */
+static int intern__fre__dfa_fill(fre_dfa *dfa,
+				 int32_t *row,
+				 int cls,
+				 int32_t *next)
+{
+  size_t numof_classes = dfa->prog->numof_classes;
+  int32_t state_ind = (int32_t)((size_t)*row / numof_classes), target = 0;
+
+  if ((dfa->mem_used > dfa->budget || (dfa->numof_states + 1) * numof_classes > FRE_DFA_MAX_ROWS)
+      && dfa->numof_states > FRE_CTX_OTHER + 2){
+    if ((state_ind = intern__fre__dfa_flush(dfa, state_ind)) == FRE_ERROR)
+      return FRE_ERROR;
+    *row = (int32_t)((size_t)state_ind * numof_classes);
+  }
+  if ((target = intern__fre__dfa_step(dfa, state_ind, cls, NULL)) == FRE_ERROR)
+    return FRE_ERROR;
+  *next = (int32_t)((size_t)target * numof_classes);
+  if (dfa->state_flags[target] & (FRE_DFA_MATCH | FRE_DFA_DEAD))
+    *next = -*next - 1;
+  dfa->trans[*row + cls] = *next;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__dfa_fill() */
+
+
+/* Allocate a DFA and its initial states. */
+static fre_dfa* intern__fre__dfa_new(fre_prog *prog,
+				     bool anchored,
+				     bool multi)
+{
+  fre_dfa *dfa = NULL;
+
+  if (!prog){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((dfa = calloc(1, sizeof(fre_dfa))) == NULL){
+    intern__fre__errmesg("Calloc");
+    return NULL;
+  }
+  dfa->prog = prog;
+  dfa->anchored = anchored;
+  dfa->multi = multi;
+  dfa->budget = __atomic_load_n(&fre_dfa_budget, __ATOMIC_RELAXED);
+  dfa->states_size = 16;
+  dfa->key_table_size = 64;
+  dfa->key_size = 64;
+  /* The closure stack (every instruction pushes at most two), then the kernel of a group. */
+  if ((dfa->keys = malloc(dfa->states_size * sizeof(int*))) == NULL
+      || (dfa->state_flags = malloc(dfa->states_size * sizeof(uint8_t))) == NULL
+      || (dfa->trans = malloc(dfa->states_size * prog->numof_classes * sizeof(int32_t))) == NULL
+      || (dfa->key_table = malloc(dfa->key_table_size * sizeof(int32_t))) == NULL
+      || (dfa->stack = malloc((prog->numof_insts * 3 + 1) * sizeof(int))) == NULL
+      || (dfa->visited = calloc(prog->numof_insts, sizeof(unsigned int))) == NULL
+      || (dfa->targeted = calloc(prog->numof_insts, sizeof(unsigned int))) == NULL
+      || (dfa->key = malloc(dfa->key_size * sizeof(int))) == NULL
+      || (multi && (dfa->ids = malloc(prog->numof_insts * sizeof(int))) == NULL)){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  memset(dfa->key_table, 0xff, dfa->key_table_size * sizeof(int32_t));
+  dfa->mem_used = dfa->key_table_size * sizeof(int32_t);
+  if (intern__fre__dfa_init_states(dfa) == FRE_ERROR)
+    goto errjmp;
+  return dfa;
+
+ errjmp:
+  intern__fre__free_dfa(dfa);
+  return NULL;
+
+} /* intern__fre__dfa_new() */
+
+
+/*
+ * Prepare the DFA of a program, an anchored DFA only looks for matches
+ * begining where the scan begins. Only the initial states are built here,
+ * the others when a scan first reaches them, see intern__fre__dfa_exec().
+ */
+fre_dfa* intern__fre__dfa_build(fre_prog *prog,
+				bool anchored)
+{
+  return intern__fre__dfa_new(prog, anchored, false);
+
+} /* intern__fre__dfa_build() */
+
+
+/*
+ * Prepare the DFA of the programs of a fre_set, combined by intern__fre__combine_progs().
+ * It tells which of them match, not where.
+ */
+fre_dfa* intern__fre__set_dfa_build(fre_prog *prog)
+{
+  return intern__fre__dfa_new(prog, false, true);
+
+} /* intern__fre__set_dfa_build() */
+
+
+/* A DFA like dfa for prog, a copy of its program. States are built anew by the copy. */
+fre_dfa* intern__fre__clone_dfa(fre_dfa *dfa,
+				fre_prog *prog)
+{
+  fre_dfa *clone = NULL;
+
+  if (!dfa || !prog){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((clone = intern__fre__dfa_new(prog, dfa->anchored, dfa->multi)) == NULL)
+    return NULL;
+  clone->budget = dfa->budget;
+  return clone;
+
+} /* intern__fre__clone_dfa() */
+
+
+/* Release a DFA, not its program. */
+void intern__fre__free_dfa(fre_dfa *dfa)
+{
+  size_t i = 0;
+  if (dfa == NULL)
+    return;
+  if (dfa->keys != NULL){
+    for (i = 0; i < dfa->numof_states; i++)
+      free(dfa->keys[i]);
+    free(dfa->keys);
+  }
+  if (dfa->key_table != NULL)
+    free(dfa->key_table);
+  if (dfa->trans != NULL)
+    free(dfa->trans);
+  if (dfa->state_flags != NULL)
+    free(dfa->state_flags);
+  if (dfa->stack != NULL)
+    free(dfa->stack);
+  if (dfa->visited != NULL)
+    free(dfa->visited);
+  if (dfa->targeted != NULL)
+    free(dfa->targeted);
+  if (dfa->key != NULL)
+    free(dfa->key);
+  if (dfa->ids != NULL)
+    free(dfa->ids);
+  free(dfa);
+
+} /* intern__fre__free_dfa() */
+
+
+/*
+ * Build every transition not known yet, of every state reachable from the
+ * initial ones. Returns FRE_OP_UNSUCCESSFUL, the states built kept, once there
+ * would be more than max_states or they get over budget: they're never flushed here.
+ */
+int intern__fre__dfa_complete(fre_dfa *dfa,
+			      size_t max_states)
+{
+  size_t i = 0, cls = 0, numof_classes = 0;
+  int32_t row = 0, next = 0;
+
+  if (!dfa || dfa->multi){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  numof_classes = dfa->prog->numof_classes;
+  for (i = 0; i < dfa->numof_states; i++){
+    for (cls = 0; cls < numof_classes; cls++){
+      row = (int32_t)(i * numof_classes);
+      if (dfa->trans[(size_t)row + cls] != FRE_DFA_UNKNOWN)
+	continue;
+      if (dfa->numof_states >= max_states || dfa->mem_used > dfa->budget)
+	return FRE_OP_UNSUCCESSFUL;
+      if (intern__fre__dfa_fill(dfa, &row, (int)cls, &next) == FRE_ERROR){
+	intern__fre__errmesg("_dfa_fill");
+	return FRE_ERROR;
+      }
+    }
+  }
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__dfa_complete() */
+
+
+/* Context of the byte at string[pos], FRE_CTX_EDGE outside of string. */
+#define FRE_DFA_CTX(prog, string, string_len, pos)			\
+  (((pos) < 0 || (size_t)(pos) >= (string_len)) ? FRE_CTX_EDGE		\
+   : (prog)->class_ctx[(prog)->byte_class[(string)[(pos)]]])
+
+
+/*
+ * Find the leftmost-longest match at or after start.
+ * The forward DFA finds where it ends, the anchored backward DFA, run from
+ * there, finds where it begins. Like regexec() with REG_STARTEND, the bytes
+ * around string[start..string_len] give anchors and boundaries their context.
+ * Transitions not known yet are built on the way, the states may be flushed
+ * in the middle of a scan: trans is reloaded after that. The forward DFA
+ * of a pattern with native code is complete and only run by it.
+ */
+int intern__fre__dfa_exec(fre_pattern *freg_object,
+			  const unsigned char *string,
+			  size_t string_len,
+			  size_t start,
+			  fre_smatch *match)
+{
+  size_t i = 0, numof_classes = 0;
+  ssize_t end = -1, begin = -1;
+  int32_t row = 0, next = 0;
+  uint8_t flags = 0, cls = 0;
+  const int32_t *trans = NULL;
+  const uint8_t *byte_class = NULL;
+  fre_dfa *dfa = NULL;
+
+  if (!freg_object || !string || !match || start > string_len
+      || !freg_object->dfa || !freg_object->rev_dfa){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+
+  /* Forward, to the end of the leftmost-longest match. */
+  dfa = freg_object->dfa;
+  if (freg_object->jit != NULL)
+    end = freg_object->jit->scan(string, start, string_len,
+				 FRE_DFA_CTX(dfa->prog, string, string_len, (ssize_t)start - 1));
+  else {
+    trans = dfa->trans;
+    byte_class = dfa->prog->byte_class;
+    numof_classes = dfa->prog->numof_classes;
+    row = dfa->init[FRE_DFA_CTX(dfa->prog, string, string_len, (ssize_t)start - 1)];
+    for (i = start; i < string_len; i++){
+      cls = byte_class[string[i]];
+      if ((next = trans[row + cls]) >= 0){
+	row = next;
+	continue;
+      }
+      if (next == FRE_DFA_UNKNOWN){
+	if (intern__fre__dfa_fill(dfa, &row, cls, &next) == FRE_ERROR){
+	  intern__fre__errmesg("_dfa_fill");
+	  return FRE_ERROR;
+	}
+	trans = dfa->trans;
+	if (next >= 0){
+	  row = next;
+	  continue;
+	}
+      }
+      row = FRE_DFA_ROW(next);
+      flags = dfa->state_flags[(size_t)row / numof_classes];
+      if (flags & FRE_DFA_MATCH)
+	end = (ssize_t)i;
+      if (flags & FRE_DFA_DEAD)
+	break;
+    }
+    if (i == string_len && (dfa->state_flags[(size_t)row / numof_classes] & FRE_DFA_EOT_MATCH))
+      end = (ssize_t)string_len;
+  }
+  if (end < 0)
+    return FRE_OP_UNSUCCESSFUL;
+
+  /* Backward from there, to its begining. */
+  dfa = freg_object->rev_dfa;
+  trans = dfa->trans;
+  byte_class = dfa->prog->byte_class;
+  numof_classes = dfa->prog->numof_classes;
+  row = dfa->init[FRE_DFA_CTX(dfa->prog, string, string_len, end)];
+  for (i = (size_t)end; i > start; i--){
+    cls = byte_class[string[i-1]];
+    if ((next = trans[row + cls]) >= 0){
+      row = next;
+      continue;
+    }
+    if (next == FRE_DFA_UNKNOWN){
+      if (intern__fre__dfa_fill(dfa, &row, cls, &next) == FRE_ERROR){
+	intern__fre__errmesg("_dfa_fill");
+	return FRE_ERROR;
+      }
+      trans = dfa->trans;
+      if (next >= 0){
+	row = next;
+	continue;
+      }
+    }
+    row = FRE_DFA_ROW(next);
+    flags = dfa->state_flags[(size_t)row / numof_classes];
+    if (flags & FRE_DFA_MATCH)
+      begin = (ssize_t)i;
+    if (flags & FRE_DFA_DEAD)
+      break;
+  }
+  if (i == start){
+    if (start == 0){
+      if (dfa->state_flags[(size_t)row / numof_classes] & FRE_DFA_EOT_MATCH)
+	begin = 0;
+    }
+    else {
+      /* The byte before start only tells whether the match may begin at start. */
+      cls = byte_class[string[start-1]];
+      if ((next = dfa->trans[row + cls]) == FRE_DFA_UNKNOWN
+	  && intern__fre__dfa_fill(dfa, &row, cls, &next) == FRE_ERROR){
+	intern__fre__errmesg("_dfa_fill");
+	return FRE_ERROR;
+      }
+      if (dfa->state_flags[(size_t)FRE_DFA_ROW(next) / numof_classes] & FRE_DFA_MATCH)
+	begin = (ssize_t)start;
+    }
+  }
+  if (begin < 0){
+    /* Both DFAs come from the same pattern, this can't happen. */
+    errno = FRE_OPERROR;
+    intern__fre__errmesg("_dfa_exec");
+    return FRE_ERROR;
+  }
+  match->bo = (fre_off)begin;
+  match->eo = (fre_off)end;
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__dfa_exec() */
+
+
+/*
+ * Scan string once with a multi DFA, found[N].eo is set to where the first match
+ * of pattern N ends, for each pattern N not found already (found[N].eo == -1).
+ * Stops as soon as every pattern is found, numof_left being how many aren't.
+ * Returns the number of patterns found or FRE_ERROR.
+ */
+int intern__fre__set_dfa_exec(fre_dfa *dfa,
+			      const unsigned char *string,
+			      size_t string_len,
+			      fre_smatch *found,
+			      size_t numof_left)
+{
+  size_t i = 0, j = 0, pos = 0, numof_classes = 0, numof_found = 0;
+  int32_t row = 0, next = 0;
+  uint8_t cls = 0;
+  bool eot_match = false;
+  const int *key = NULL;
+  const int32_t *trans = NULL;
+  const uint8_t *byte_class = NULL;
+
+  if (!dfa || !dfa->multi || !string || !found){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  trans = dfa->trans;
+  byte_class = dfa->prog->byte_class;
+  numof_classes = dfa->prog->numof_classes;
+  row = dfa->init[FRE_CTX_EDGE];
+  for (i = 0; i < string_len && numof_found < numof_left; i++){
+    cls = byte_class[string[i]];
+    if ((next = trans[row + cls]) >= 0){
+      row = next;
+      continue;
+    }
+    if (next == FRE_DFA_UNKNOWN){
+      if (intern__fre__dfa_fill(dfa, &row, cls, &next) == FRE_ERROR){
+	intern__fre__errmesg("_dfa_fill");
+	return FRE_ERROR;
+      }
+      trans = dfa->trans;
+      if (next >= 0){
+	row = next;
+	continue;
+      }
+    }
+    row = FRE_DFA_ROW(next);
+    key = dfa->keys[(size_t)row / numof_classes];
+    pos = FRE_KEY_HEADER + ((key[FRE_KEY_NUMOF_GROUPS] > 0) ? (size_t)key[FRE_KEY_HEADER] + 1 : 0);
+    for (j = 0; j < (size_t)key[pos]; j++){
+      if (found[key[pos + 1 + j]].eo == -1){
+	found[key[pos + 1 + j]].eo = (fre_off)i;
+	++numof_found;
+      }
+    }
+  }
+  if (i == string_len && numof_found < numof_left
+      && (dfa->state_flags[(size_t)row / numof_classes] & FRE_DFA_EOT_MATCH)){
+    intern__fre__set_step(dfa, (int32_t)((size_t)row / numof_classes), -1, &eot_match);
+    for (j = 0; j < dfa->numof_ids; j++){
+      if (found[dfa->ids[j]].eo == -1){
+	found[dfa->ids[j]].eo = (fre_off)string_len;
+	++numof_found;
+      }
+    }
+  }
+  return (int)numof_found;
+
+} /* intern__fre__set_dfa_exec() */
@@ -33,7 +33,8 @@ enum fre_errcodes {
   FRE_INVALBREF,
   FRE_INVALTRANSL,
   FRE_PATRNTOOLONG,
-  FRE_OPERROR
+  FRE_OPERROR,
+  FRE_INVALREPL
   
 };
  
@@ -51,7 +52,8 @@ static const char fre_errmesg[][FRE_MAX_ERRMESG_LEN] ={
   "No valid position in regmatch_t array[0]",
   "Non matching number of characters in the given transliteration pattern",
   "Libfre takes pattern no longer than 256 bytes including a NULL byte to stay POSIX conformant",
-  "Error executing the requested operation"
+  "Error executing the requested operation",
+  "Invalid sub-match reference in the given substitute pattern"
 };
 
 
@@ -0,0 +1,149 @@
+/*
+ *
+ *  Libfre  -  Memory-mapped file scanning.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+/*
+ * Hand the pages of the mapping a search from start won't look at back to the
+ * kernel, all but the byte before start, its context. They're read again
+ * from the page cache should they be touched once more.
+ */
+static void intern__fre__file_release(char *map,
+				      size_t *released,
+				      size_t start,
+				      size_t page_size)
+{
+  size_t stop = ((start > 0) ? start - 1 : 0);
+
+  stop -= stop % page_size;
+  if (stop <= *released)
+    return;
+  madvise(map + *released, stop - *released, MADV_DONTNEED);
+  *released = stop;
+
+} /* intern__fre__file_release() */
+
+
+/*
+ * End of the window searched from start: FRE_FILE_WINDOW bytes on, or just past
+ * the last newline in them when by_line, the next one if there's none.
+ */
+static size_t intern__fre__file_window_end(const char *map,
+					   size_t file_len,
+					   size_t start,
+					   bool by_line)
+{
+  size_t end = ((file_len - start > FRE_FILE_WINDOW) ? start + FRE_FILE_WINDOW : file_len);
+  size_t i = end;
+  const char *newline = NULL;
+
+  if (!by_line || end == file_len)
+    return end;
+  while (i > start)
+    if (map[--i] == '\n')
+      return i + 1;
+  if ((newline = memchr(map + end, '\n', file_len - end)) == NULL)
+    return file_len;
+  return (size_t)(newline - map) + 1;
+
+} /* intern__fre__file_window_end() */
+
+
+/*
+ * Run a matching pattern over the file at path, mapped read-only, and hand
+ * each match to callback, every one of them with /g, until it returns non-zero.
+ * The file is searched a window at a time, see intern__fre__scan(), the pages
+ * behind it are let go as it moves. Patterns whose matches it can't tell
+ * are final before the end of the file are searched over the whole mapping.
+ */
+int intern__fre__match_file(fre_pattern *freg_object,
+			    const char *path,
+			    fre_match_callback callback,
+			    void *arg)
+{
+  int fd = -1, saved_errno = 0;
+  size_t file_len = 0, start = 0, end = 0, released = 0, page_size = 0;
+  char *map = NULL;
+  char empty[1] = { '\0' };
+  struct stat st;
+  fre_scan scan;
+
+  if (!freg_object || !path || !callback || freg_object->fre_op_flag != MATCH){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  /* errno is kept from where it failed, reporting it or closing may change it. */
+  if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1){
+    saved_errno = errno;
+    intern__fre__errmesg("Open");
+    errno = saved_errno;
+    return FRE_ERROR;
+  }
+  if (fstat(fd, &st) == -1){
+    saved_errno = errno;
+    intern__fre__errmesg("Fstat");
+    goto errjmp;
+  }
+  if ((uintmax_t)st.st_size >= FRE_ARG_STRING_MAX_LENGHT){
+    saved_errno = EOVERFLOW;
+    goto errjmp;
+  }
+  file_len = (size_t)st.st_size;
+  if (file_len == 0)
+    map = empty;
+  else {
+    if ((map = mmap(NULL, file_len, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+      map = NULL;
+      saved_errno = errno;
+      intern__fre__errmesg("Mmap");
+      goto errjmp;
+    }
+    madvise(map, file_len, MADV_SEQUENTIAL);
+  }
+  close(fd);
+  fd = -1;
+
+  page_size = (size_t)sysconf(_SC_PAGESIZE);
+  intern__fre__scan_init(&scan, freg_object, true, FRE_FILE_WINDOW, callback, arg);
+  while (start <= file_len && scan.stopped == false){
+    end = ((scan.mode == FRE_SCAN_WHOLE) ? file_len
+	   : intern__fre__file_window_end(map, file_len, start, (scan.mode == FRE_SCAN_BY_LINE)));
+    if (intern__fre__scan(&scan, map, end, (end == file_len), &start) == FRE_ERROR){
+      saved_errno = errno;
+      goto errjmp;
+    }
+    if (end == file_len)
+      break;
+    intern__fre__file_release(map, &released, start, page_size);
+  }
+
+  if (file_len > 0)
+    munmap(map, file_len);
+  return ((scan.numof_matches > 0) ? FRE_OP_SUCCESSFUL : FRE_OP_UNSUCCESSFUL);
+
+ errjmp:
+  if (fd != -1)
+    close(fd);
+  if (map != NULL && file_len > 0)
+    munmap(map, file_len);
+  errno = saved_errno;
+  return FRE_ERROR;
+
+} /* intern__fre__match_file() */
@@ -0,0 +1,127 @@
+/*
+ *
+ *  Libfre  -  Lines of a buffer selected by a pattern.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+/*
+ * Whether searching the whole buffer finds the lines a pattern matches: it runs
+ * natively, taking the buffer at once, its matches hold no newline, and it doesn't
+ * tell the begining and end of the text apart from those of a line, which they
+ * would be alone. Others are only searched line by line.
+ */
+static bool intern__fre__grep_by_buffer(fre_pattern *freg_object)
+{
+  if (freg_object->engine != FRE_ENGINE_DFA && freg_object->engine != FRE_ENGINE_LITERAL
+      && freg_object->engine != FRE_ENGINE_AC)
+    return false;
+  if (intern__fre__matches_byte(freg_object, '\n'))
+    return false;
+  return (freg_object->prog == NULL
+	  || (freg_object->prog->assertions & ((1u << FRE_ASSERT_BOT) | (1u << FRE_ASSERT_EOT))) == 0);
+
+} /* intern__fre__grep_by_buffer() */
+
+
+/*
+ * Select the lines of buf that a matching pattern matches, as it would each
+ * of them alone, or those it doesn't when invert. They're handed to callback
+ * until it returns non-zero, or else put in lines, the first numof_lines of
+ * them, lines may be NULL to only count them in *numof_selected.
+ * Lines end with a newline, or the end of buf, which doesn't begin another.
+ * The next line that may match is found over the whole buffer, with the
+ * pattern itself when intern__fre__grep_by_buffer() tells it can, or with its
+ * literal, the lines before it are counted with memchr().
+ */
+int intern__fre__grep_lines(fre_pattern *freg_object,
+			    const char *buf,
+			    size_t len,
+			    bool invert,
+			    fre_line *lines,
+			    size_t numof_lines,
+			    fre_line_callback callback,
+			    void *arg,
+			    size_t *numof_selected)
+{
+  int ret = 0;
+  size_t pos = 0, end = 0, next = 0, number = 1;
+  bool by_buffer = false, matched = false;
+  const char *newline = NULL;
+  const unsigned char *found = NULL;
+  fre_smatch match;
+  fre_line line;
+
+  if (!freg_object || (!buf && len > 0) || !numof_selected || freg_object->fre_op_flag != MATCH){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  *numof_selected = 0;
+  by_buffer = intern__fre__grep_by_buffer(freg_object);
+  while (pos < len){
+    /* Where the next match may be, past the end of buf when there's none. */
+    if (by_buffer){
+      if ((ret = intern__fre__exec_match(freg_object, (char*)buf, len, pos, &match, 1)) == FRE_ERROR){
+	intern__fre__errmesg("_exec_match");
+	return FRE_ERROR;
+      }
+      next = ((ret == FRE_OP_SUCCESSFUL) ? (size_t)match.bo : len + 1);
+    }
+    else if (freg_object->literal != NULL){
+      found = intern__fre__find_literal((const unsigned char*)buf + pos, len - pos, freg_object->literal);
+      next = ((found != NULL) ? (size_t)((const char*)found - buf) : len + 1);
+    }
+    else
+      next = pos;
+    if (next > len && !invert)
+      break;
+
+    /* The lines before the one holding it don't match. */
+    do {
+      newline = memchr(buf + pos, '\n', len - pos);
+      end = ((newline != NULL) ? (size_t)(newline - buf) : len);
+      if (next > end)
+	matched = false;
+      else if (by_buffer)
+	matched = true;
+      else {
+	if ((ret = intern__fre__exec_match(freg_object, (char*)buf + pos, end - pos, 0, &match, 1)) == FRE_ERROR){
+	  intern__fre__errmesg("_exec_match");
+	  return FRE_ERROR;
+	}
+	matched = (ret == FRE_OP_SUCCESSFUL);
+      }
+      if (matched != invert){
+	line.offset = (fre_off)pos;
+	line.length = (fre_off)(end - pos);
+	line.number = number;
+	if (callback != NULL){
+	  ++*numof_selected;
+	  if (callback(&line, arg) != 0)
+	    return FRE_OP_SUCCESSFUL;
+	}
+	else {
+	  if (lines != NULL && *numof_selected < numof_lines)
+	    lines[*numof_selected] = line;
+	  ++*numof_selected;
+	}
+      }
+      ++number;
+      pos = end + 1;
+    } while (next > end && pos < len);
+  }
+
+  return ((*numof_selected > 0) ? FRE_OP_SUCCESSFUL : FRE_OP_UNSUCCESSFUL);
+
+} /* intern__fre__grep_lines() */
@@ -20,6 +20,7 @@ static inline fre_pmatch* intern__fre__fetch_head(void);
 pthread_mutex_t fre_stderr_mutex;  /* For when error/debug messages has multiple function calls. */
 pthread_key_t pmatch_table_key;    /* Keys to the pmatch_table kindom. */
 fre_headnodes *fre_headnode_table; /* To keep track of allocated pmatch_tables. */
+fre_shared_patterns *fre_shared_pattern_table; /* Parsed patterns shared by all threads. */
 
 
 int __attribute__ ((constructor)) intern__fre__lib_init(void)
@@ -30,7 +31,7 @@ int __attribute__ ((constructor)) intern__fre__lib_init(void)
     return FRE_ERROR;
   }
   /* Initialize a pthread key to make pmatch_tables thread specific. */
-  if (pthread_key_create(&pmatch_table_key, NULL) != 0){
+  if (pthread_key_create(&pmatch_table_key, intern__fre__key_delete) != 0){
     perror("Pthread_key_create");
     return FRE_ERROR;
   }
@@ -39,6 +40,13 @@ int __attribute__ ((constructor)) intern__fre__lib_init(void)
     perror("intern__fre__init_head_table");
     return FRE_ERROR;
   }
+  /* Initialize the global table of shared, parsed patterns. */
+  if ((fre_shared_pattern_table = intern__fre__init_shared_table()) == NULL){
+    perror("intern__fre__init_shared_table");
+    return FRE_ERROR;
+  }
+  /* Pick the vectorized kernels this CPU can run. */
+  intern__fre__simd_init();
   
   return FRE_OP_SUCCESSFUL;
 }
@@ -51,7 +59,9 @@ void __attribute__ ((destructor)) intern__fre__lib_finit(void)
     perror("Pthread_mutex_destroy");
   }
 
+  /* Per-thread caches hold clones of shared patterns, release them first. */
   intern__fre__free_head_table();
+  intern__fre__free_shared_table();
 
   if (pthread_key_delete(pmatch_table_key) != 0){
     perror("Pthread_key_delete");
@@ -60,12 +70,54 @@ void __attribute__ ((destructor)) intern__fre__lib_finit(void)
 } /* intern__fre__lib_finit() */
 
 
-/* Because pthread_key_create needs a way to free the allocated key. */
+/*
+ * Called by pthreads with the pmatch_table of an exiting thread.
+ * Its pattern cache is emptied, the clones in it dropping their shared table
+ * references, what its last operations allocated is released, and the table
+ * goes back to the unused part of the headnode_table, for the next thread.
+ */
 void intern__fre__key_delete(void *key)
 {
-  if (key != NULL)
-    free(key);
-}
+  fre_pmatch *table = key;
+  size_t i = 0;
+
+  if (table == NULL || fre_headnode_table == NULL)
+    return;
+  intern__fre__pcache_resize(table->pattern_cache, 0);
+  table->pattern_cache->capacity = FRE_PCACHE_CAPACITY;
+  table->pattern_cache->hits = 0;
+  table->pattern_cache->misses = 0;
+  if (table->subs_buffer != NULL){
+    free(table->subs_buffer);
+    table->subs_buffer = NULL;
+  }
+  table->subs_buffer_size = 0;
+  if (table->tr_result != NULL){
+    free(table->tr_result);
+    table->tr_result = NULL;
+  }
+  table->tr_result_size = 0;
+  table->tr_has_result = false;
+  table->tr_count = 0;
+  table->result_len = 0;
+  table->lastop_retval = 0;
+  table->subm_per_match = 0;
+  table->wm_ind = 0;
+  table->sm_ind = 0;
+  __atomic_store_n(&table->shared_epoch, 0, __ATOMIC_SEQ_CST);
+
+  /* Tables in use are kept below head_list_tos, swap this one with the last of them. */
+  pthread_mutex_lock(fre_headnode_table->table_lock);
+  for (i = 0; i < fre_headnode_table->head_list_tos; i++){
+    if (fre_headnode_table->head_list[i] == table){
+      fre_headnode_table->head_list[i] = fre_headnode_table->head_list[--fre_headnode_table->head_list_tos];
+      fre_headnode_table->head_list[fre_headnode_table->head_list_tos] = table;
+      break;
+    }
+  }
+  pthread_mutex_unlock(fre_headnode_table->table_lock);
+
+} /* intern__fre__key_delete() */
 
 /*
  * Do not use this function directly, instead use the
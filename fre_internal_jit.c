@@ -0,0 +1,460 @@
+/*
+ *
+ *  Libfre  -  Native code for the DFA, x86-64 only.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+bool fre_jit_enabled = false; /* Set by fre_jit_set_enabled(). */
+
+/* Bytes of the byte classes, copied at the start of the pages. */
+#define FRE_JIT_CLASSES       256
+
+
+#if defined(__x86_64__)
+
+/* Bytes of code a state may take, besides its jump table, and those taken before the states. */
+#define FRE_JIT_STATE_CODE    384
+#define FRE_JIT_PROLOGUE      128
+
+/* A rel32 jump, or a table entry, to a state's code not emitted yet. */
+typedef struct fre_jit_fixup {
+  size_t                pos;              /* Where the 32 bits offset goes. */
+  size_t                from;             /* What it's relative to. */
+  size_t                state;            /* The state jumped to. */
+  bool                  loop;             /* True to skip what's done on a transition to it. */
+
+} fre_jit_fixup;
+
+/*
+ * The code being emitted, after the byte classes, the transitions
+ * of the states run from a table and the entries of every state.
+ */
+typedef struct fre_jit_emitter {
+  unsigned char         *code;
+  size_t                len;              /* Bytes emitted. */
+  size_t                trans;            /* Offset of the transitions. */
+  size_t                entries;          /* Offset of the entries. */
+  size_t                table_loop;       /* Offset of the loop running states from the table. */
+  size_t                *entry;           /* Code reached from a transition to each state. */
+  size_t                *loop;            /* Code reading the next byte, in each state. */
+  bool                  *branches;        /* True for the states compiled to branches. */
+  fre_jit_fixup         *fixups;
+  size_t                numof_fixups;
+
+} fre_jit_emitter;
+
+
+/* Emit len bytes. */
+static void intern__fre__jit_bytes(fre_jit_emitter *e,
+				   const char *bytes,
+				   size_t len)
+{
+  memcpy(e->code + e->len, bytes, len);
+  e->len += len;
+
+} /* intern__fre__jit_bytes() */
+
+
+/* Emit a 32 bits little-endian value. */
+static void intern__fre__jit_int32(fre_jit_emitter *e,
+				   int32_t value)
+{
+  uint32_t u = (uint32_t)value;
+  size_t i = 0;
+
+  for (i = 0; i < 4; i++)
+    e->code[e->len++] = (unsigned char)(u >> (8 * i));
+
+} /* intern__fre__jit_int32() */
+
+
+/*
+ * Emit the 32 bits of a jump to state, relative to from (the end of the
+ * instruction when 0), to its loop rather than its entry when loop is true.
+ */
+static void intern__fre__jit_target(fre_jit_emitter *e,
+				    size_t state,
+				    size_t from,
+				    bool loop)
+{
+  e->fixups[e->numof_fixups].pos = e->len;
+  e->fixups[e->numof_fixups].from = ((from == 0) ? e->len + 4 : from);
+  e->fixups[e->numof_fixups].state = state;
+  e->fixups[e->numof_fixups].loop = loop;
+  ++e->numof_fixups;
+  intern__fre__jit_int32(e, 0);
+
+} /* intern__fre__jit_target() */
+
+
+/*
+ * Whether a state is worth compiling to branches: it mostly stays itself,
+ * leaving itself on no more than FRE_JIT_SKIP_BYTES bytes. The others
+ * would mispredict about every byte, the table has no branch to mispredict.
+ */
+static bool intern__fre__jit_branches(fre_dfa *dfa,
+				      size_t state)
+{
+  size_t c = 0, numof_classes = dfa->prog->numof_classes, numof_exits = 0;
+  const int32_t *row = dfa->trans + state * numof_classes;
+
+  if (dfa->state_flags[state] & FRE_DFA_DEAD)
+    return false;
+  for (c = 0; c < 256; c++)
+    if ((size_t)FRE_DFA_ROW(row[dfa->prog->byte_class[c]]) / numof_classes != state)
+      ++numof_exits;
+  return numof_exits <= FRE_JIT_SKIP_BYTES;
+
+} /* intern__fre__jit_branches() */
+
+
+/* Emit a branch to the state each class leaving state leads to, the class being in eax. */
+static void intern__fre__jit_exits(fre_jit_emitter *e,
+				   fre_dfa *dfa,
+				   size_t state)
+{
+  size_t cls = 0, numof_classes = dfa->prog->numof_classes, target = 0;
+  const int32_t *row = dfa->trans + state * numof_classes;
+
+  for (cls = 0; cls < numof_classes; cls++){
+    target = (size_t)FRE_DFA_ROW(row[cls]) / numof_classes;
+    if (target == state)
+      continue;
+    intern__fre__jit_bytes(e, "\x3d", 1);                       /* cmp eax, cls */
+    intern__fre__jit_int32(e, (int32_t)cls);
+    intern__fre__jit_bytes(e, "\x0f\x84", 2);                   /* je target */
+    intern__fre__jit_target(e, target, 0, false);
+  }
+
+} /* intern__fre__jit_exits() */
+
+
+/*
+ * Emit the code of a state, registers being:
+ *   rdi string, rsi the next byte's index, rdx string_len,
+ *   r8 where the last match found ends (-1 for none), r9 the byte classes,
+ *   r10 the transitions, r11 the row of the state run from the table.
+ * Reaching it by a transition records a match, or stops at a dead state,
+ * as intern__fre__dfa_exec() does. A state run from the table then goes
+ * to the table loop. Otherwise the classes leaving it are told apart by
+ * branches, by a jump table when there are more than FRE_JIT_MAX_BRANCHES.
+ */
+static void intern__fre__jit_state(fre_jit_emitter *e,
+				   fre_dfa *dfa,
+				   size_t state)
+{
+  size_t i = 0, cls = 0, numof_classes = dfa->prog->numof_classes, numof_exits = 0, table = 0, one = 0, end = 0;
+  const int32_t *row = dfa->trans + state * numof_classes;
+  uint8_t flags = dfa->state_flags[state];
+
+  e->entry[state] = e->len;
+  if (flags & FRE_DFA_MATCH)
+    intern__fre__jit_bytes(e, "\x4c\x8d\x46\xff", 4);           /* lea r8, [rsi-1] */
+  if (flags & FRE_DFA_DEAD)
+    intern__fre__jit_bytes(e, "\x4c\x89\xc0\xc3", 4);           /* mov rax, r8; ret */
+
+  e->loop[state] = e->len;
+  if (!e->branches[state]){
+    intern__fre__jit_bytes(e, "\x41\xbb", 2);                   /* mov r11d, row */
+    intern__fre__jit_int32(e, (int32_t)(state * (numof_classes + 1)));
+    intern__fre__jit_bytes(e, "\xe9", 1);                       /* jmp table_loop */
+    intern__fre__jit_int32(e, (int32_t)e->table_loop - (int32_t)(e->len + 4));
+    return;
+  }
+  for (cls = 0; cls < numof_classes; cls++)
+    if ((size_t)FRE_DFA_ROW(row[cls]) / numof_classes != state)
+      ++numof_exits;
+  /* Bytes 4 at a time while there are, then one. */
+  if (numof_exits <= FRE_JIT_MAX_BRANCHES){
+    intern__fre__jit_bytes(e, "\x48\x8d\x46\x04"                 /* lea rax, [rsi+4] */
+			   "\x48\x39\xd0"                        /* cmp rax, rdx */
+			   "\x0f\x87", 9);                        /* ja one */
+    one = e->len;
+    intern__fre__jit_int32(e, 0);
+    for (i = 0; i < 4; i++){
+      intern__fre__jit_bytes(e, "\x0f\xb6\x04\x37"               /* movzx eax, byte [rdi+rsi] */
+			     "\x48\xff\xc6"                      /* inc rsi */
+			     "\x41\x0f\xb6\x04\x01", 12);        /* movzx eax, byte [r9+rax] */
+      intern__fre__jit_exits(e, dfa, state);
+      if (flags & FRE_DFA_MATCH)
+	intern__fre__jit_bytes(e, "\x4c\x8d\x46\xff", 4);       /* lea r8, [rsi-1] */
+    }
+    intern__fre__jit_bytes(e, "\xe9", 1);                       /* jmp loop */
+    intern__fre__jit_int32(e, (int32_t)e->loop[state] - (int32_t)(e->len + 4));
+    end = e->len;
+    e->len = one;
+    intern__fre__jit_int32(e, (int32_t)(end - (one + 4)));
+    e->len = end;
+  }
+  intern__fre__jit_bytes(e, "\x48\x39\xd6\x72\x04", 5);         /* cmp rsi, rdx; jb +4 */
+  if (flags & FRE_DFA_EOT_MATCH)
+    intern__fre__jit_bytes(e, "\x48\x89\xd0\xc3", 4);           /* mov rax, rdx; ret */
+  else
+    intern__fre__jit_bytes(e, "\x4c\x89\xc0\xc3", 4);           /* mov rax, r8; ret */
+  intern__fre__jit_bytes(e, "\x0f\xb6\x04\x37"                   /* movzx eax, byte [rdi+rsi] */
+			 "\x48\xff\xc6"                          /* inc rsi */
+			 "\x41\x0f\xb6\x04\x01", 12);            /* movzx eax, byte [r9+rax] */
+  if (numof_exits <= FRE_JIT_MAX_BRANCHES){
+    intern__fre__jit_exits(e, dfa, state);
+    intern__fre__jit_bytes(e, "\xe9", 1);                       /* jmp state */
+    intern__fre__jit_target(e, state, 0, false);
+    return;
+  }
+  /* The table follows the 9 bytes after lea, aligned on 4 bytes. */
+  intern__fre__jit_bytes(e, "\x48\x8d\x0d", 3);                 /* lea rcx, [rip+table] */
+  table = (e->len + 4 + 9 + 3) & ~(size_t)3;
+  intern__fre__jit_int32(e, (int32_t)(table - (e->len + 4)));
+  intern__fre__jit_bytes(e, "\x48\x63\x04\x81"                   /* movsxd rax, dword [rcx+rax*4] */
+			 "\x48\x01\xc8"                          /* add rax, rcx */
+			 "\xff\xe0", 9);                         /* jmp rax */
+  while (e->len < table)
+    e->code[e->len++] = 0xcc;                                    /* int3 */
+  for (cls = 0; cls < numof_classes; cls++)
+    intern__fre__jit_target(e, (size_t)FRE_DFA_ROW(row[cls]) / numof_classes, table, false);
+
+} /* intern__fre__jit_state() */
+
+
+/*
+ * Emit the loop running the states not compiled to branches, as intern__fre__dfa_exec()
+ * does from trans. Each row of the table has a transition for each class, to
+ * the target's row or, when it has flags or is compiled to branches, to
+ * -(target + 1). The entry of the target is then jumped to from the entries.
+ * The last int of a row is 1 when a match ends if the text ends there.
+ */
+static void intern__fre__jit_table_loop(fre_jit_emitter *e,
+					fre_dfa *dfa)
+{
+  size_t numof_classes = dfa->prog->numof_classes, eot = 0, loop = 0;
+
+  e->table_loop = e->len;
+  intern__fre__jit_bytes(e, "\x48\x39\xd6\x73", 4);             /* cmp rsi, rdx; jae eot */
+  eot = e->len++;
+  intern__fre__jit_bytes(e, "\x0f\xb6\x04\x37"                   /* movzx eax, byte [rdi+rsi] */
+			 "\x48\xff\xc6"                          /* inc rsi */
+			 "\x41\x0f\xb6\x04\x01"                  /* movzx eax, byte [r9+rax] */
+			 "\x4c\x01\xd8"                          /* add rax, r11 */
+			 "\x4d\x63\x1c\x82"                      /* movsxd r11, dword [r10+rax*4] */
+			 "\x4d\x85\xdb\x79", 23);                /* test r11, r11; jns table_loop */
+  loop = e->len++;
+  e->code[loop] = (unsigned char)(int8_t)((int)e->table_loop - (int)e->len);
+  intern__fre__jit_bytes(e, "\x49\xf7\xd3"                       /* not r11 */
+			 "\x48\x8d\x05", 6);                     /* lea rax, [rip+entries] */
+  intern__fre__jit_int32(e, (int32_t)e->entries - (int32_t)(e->len + 4));
+  intern__fre__jit_bytes(e, "\x4e\x63\x1c\x98"                   /* movsxd r11, dword [rax+r11*4] */
+			 "\x4c\x01\xd8"                          /* add rax, r11 */
+			 "\xff\xe0", 9);                         /* jmp rax */
+  e->code[eot] = (unsigned char)(e->len - (eot + 1));
+  intern__fre__jit_bytes(e, "\x43\x83\xbc\x9a", 4);             /* cmp dword [r10+r11*4+numof_classes*4], 0 */
+  intern__fre__jit_int32(e, (int32_t)(numof_classes * 4));
+  intern__fre__jit_bytes(e, "\x00\x74\x04"                       /* je +4 */
+			 "\x48\x89\xd0\xc3"                      /* mov rax, rdx; ret */
+			 "\x4c\x89\xc0\xc3", 11);                /* mov rax, r8; ret */
+
+} /* intern__fre__jit_table_loop() */
+
+
+/*
+ * Compile the forward scan of a pattern's DFA to native code, once every
+ * state of it is built. The code is mapped writable while emitted, then
+ * only readable and executable. Returns NULL, errno left to 0, when
+ * the DFA has more than FRE_JIT_MAX_STATES states, or when no state of it
+ * is worth compiling to branches: the interpreter is as fast then.
+ */
+fre_jit_code* intern__fre__jit_build(fre_pattern *freg_object)
+{
+  size_t i = 0, cls = 0, numof_classes = 0, numof_branches = 0, size = 0, page = 0, target = 0;
+  int ret = 0;
+  int32_t *trans = NULL;
+  void *map = NULL;
+  fre_dfa *dfa = NULL;
+  fre_jit_code *jit = NULL;
+  fre_jit_emitter e;
+
+  if (!freg_object){
+    errno = EINVAL;
+    return NULL;
+  }
+  memset(&e, 0, sizeof(fre_jit_emitter));
+  if (freg_object->engine != FRE_ENGINE_DFA || (dfa = freg_object->dfa) == NULL)
+    return NULL;
+  if ((ret = intern__fre__dfa_complete(dfa, FRE_JIT_MAX_STATES)) != FRE_OP_SUCCESSFUL){
+    if (ret == FRE_ERROR)
+      intern__fre__errmesg("_dfa_complete");
+    return NULL;
+  }
+  numof_classes = dfa->prog->numof_classes;
+  if ((e.branches = malloc(dfa->numof_states * sizeof(bool))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return NULL;
+  }
+  for (i = 0; i < dfa->numof_states; i++)
+    if ((e.branches[i] = intern__fre__jit_branches(dfa, i)))
+      ++numof_branches;
+  if (numof_branches == 0){
+    free(e.branches);
+    return NULL;
+  }
+
+  page = (size_t)sysconf(_SC_PAGESIZE);
+  e.trans = FRE_JIT_CLASSES;
+  e.entries = e.trans + dfa->numof_states * (numof_classes + 1) * sizeof(int32_t);
+  size = e.entries + dfa->numof_states * sizeof(int32_t) + FRE_JIT_PROLOGUE
+    + dfa->numof_states * (FRE_JIT_STATE_CODE + 4 * numof_classes);
+  size = (size + page - 1) / page * page;
+  if ((jit = calloc(1, sizeof(fre_jit_code))) == NULL
+      || (e.entry = malloc(dfa->numof_states * sizeof(size_t))) == NULL
+      || (e.loop = malloc(dfa->numof_states * sizeof(size_t))) == NULL
+      || (e.fixups = malloc((dfa->numof_states * (numof_classes + 5 * FRE_JIT_MAX_BRANCHES + 2) + 4)
+			    * sizeof(fre_jit_fixup))) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  if ((map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED){
+    map = NULL;
+    intern__fre__errmesg("Mmap");
+    goto errjmp;
+  }
+  e.code = map;
+  memcpy(e.code, dfa->prog->byte_class, FRE_JIT_CLASSES);
+  trans = (int32_t*)(e.code + e.trans);
+  for (i = 0; i < dfa->numof_states; i++){
+    for (cls = 0; cls < numof_classes; cls++){
+      target = (size_t)FRE_DFA_ROW(dfa->trans[i * numof_classes + cls]) / numof_classes;
+      if (e.branches[target] || (dfa->state_flags[target] & (FRE_DFA_MATCH | FRE_DFA_DEAD)))
+	trans[i * (numof_classes + 1) + cls] = -(int32_t)target - 1;
+      else
+	trans[i * (numof_classes + 1) + cls] = (int32_t)(target * (numof_classes + 1));
+    }
+    trans[i * (numof_classes + 1) + numof_classes] = ((dfa->state_flags[i] & FRE_DFA_EOT_MATCH) ? 1 : 0);
+  }
+  e.len = e.entries;
+  for (i = 0; i < dfa->numof_states; i++)
+    intern__fre__jit_target(&e, i, e.entries, false);
+
+  /* ssize_t scan(string, start, string_len, ctx), only using the caller's registers. */
+  jit->entry = e.len;
+  intern__fre__jit_bytes(&e, "\x49\xc7\xc0\xff\xff\xff\xff"     /* mov r8, -1 */
+			 "\x4c\x8d\x0d", 10);                    /* lea r9, [rip+classes] */
+  intern__fre__jit_int32(&e, -(int32_t)(e.len + 4));
+  intern__fre__jit_bytes(&e, "\x4c\x8d\x15", 3);                /* lea r10, [rip+trans] */
+  intern__fre__jit_int32(&e, (int32_t)e.trans - (int32_t)(e.len + 4));
+  /* The initial states are entered without reading a byte. */
+  for (i = FRE_CTX_EDGE; i < FRE_CTX_OTHER; i++){
+    intern__fre__jit_bytes(&e, "\x83\xf9", 2);                  /* cmp ecx, ctx */
+    e.code[e.len++] = (unsigned char)i;
+    intern__fre__jit_bytes(&e, "\x0f\x84", 2);                  /* je init[ctx] */
+    intern__fre__jit_target(&e, (size_t)dfa->init[i] / numof_classes, 0, true);
+  }
+  intern__fre__jit_bytes(&e, "\xe9", 1);                        /* jmp init[FRE_CTX_OTHER] */
+  intern__fre__jit_target(&e, (size_t)dfa->init[FRE_CTX_OTHER] / numof_classes, 0, true);
+  intern__fre__jit_table_loop(&e, dfa);
+  for (i = 0; i < dfa->numof_states; i++)
+    intern__fre__jit_state(&e, dfa, i);
+  for (i = 0; i < e.numof_fixups; i++){
+    e.len = e.fixups[i].pos;
+    intern__fre__jit_int32(&e, (int32_t)(((e.fixups[i].loop) ? e.loop : e.entry)[e.fixups[i].state]
+					 - e.fixups[i].from));
+  }
+  if (mprotect(map, size, PROT_READ | PROT_EXEC) != 0){
+    intern__fre__errmesg("Mprotect");
+    goto errjmp;
+  }
+  jit->code = map;
+  jit->size = size;
+  memcpy(&jit->scan, &(void*){ e.code + jit->entry }, sizeof(void*));
+  free(e.branches);
+  free(e.entry);
+  free(e.loop);
+  free(e.fixups);
+  return jit;
+
+ errjmp:
+  if (map != NULL)
+    munmap(map, size);
+  if (jit != NULL)
+    free(jit);
+  if (e.branches != NULL)
+    free(e.branches);
+  if (e.entry != NULL)
+    free(e.entry);
+  if (e.loop != NULL)
+    free(e.loop);
+  if (e.fixups != NULL)
+    free(e.fixups);
+  return NULL;
+
+} /* intern__fre__jit_build() */
+
+#else
+
+/* No native code for this architecture, the interpreter runs every DFA. */
+fre_jit_code* intern__fre__jit_build(fre_pattern *freg_object)
+{
+  if (!freg_object)
+    errno = EINVAL;
+  return NULL;
+
+} /* intern__fre__jit_build() */
+
+#endif /* __x86_64__ */
+
+
+/* Copy native code to new pages, it runs the same from anywhere. */
+fre_jit_code* intern__fre__clone_jit(fre_jit_code *jit)
+{
+  void *map = NULL;
+  fre_jit_code *clone = NULL;
+
+  if (jit == NULL){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((clone = malloc(sizeof(fre_jit_code))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return NULL;
+  }
+  if ((map = mmap(NULL, jit->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED){
+    intern__fre__errmesg("Mmap");
+    free(clone);
+    return NULL;
+  }
+  memcpy(map, jit->code, jit->size);
+  if (mprotect(map, jit->size, PROT_READ | PROT_EXEC) != 0){
+    intern__fre__errmesg("Mprotect");
+    munmap(map, jit->size);
+    free(clone);
+    return NULL;
+  }
+  *clone = *jit;
+  clone->code = map;
+  memcpy(&clone->scan, &(void*){ clone->code + clone->entry }, sizeof(void*));
+  return clone;
+
+} /* intern__fre__clone_jit() */
+
+
+/* Release native code. */
+void intern__fre__free_jit(fre_jit_code *jit)
+{
+  if (jit == NULL)
+    return;
+  munmap(jit->code, jit->size);
+  free(jit);
+
+} /* intern__fre__free_jit() */
@@ -50,8 +50,12 @@
   }while (0);
 
 
-/* Fetch a user's pattern modifier(s). */
+/* 
+ * Fetch a user's pattern modifier(s).
+ * c, d and r only exist for transliterations, where s means squeeze.
+ */
 # define FRE_FETCH_MODIFIERS(pattern, freg_object, token_ind) do {      \
+    bool is_tr = (freg_object->fre_op_flag == TRANSLITERATE);		\
     errno = 0;								\
     while (pattern[*token_ind] != '\0') {				\
       switch (pattern[*token_ind]) {					\
@@ -62,7 +66,20 @@
 	freg_object->fre_mod_icase = true;				\
 	break;								\
       case 's':								\
-	freg_object->fre_mod_newline = true;				\
+	if (is_tr) freg_object->fre_mod_tr_squeeze = true;		\
+	else freg_object->fre_mod_newline = true;			\
+	break;								\
+      case 'c':								\
+	if (is_tr) freg_object->fre_mod_tr_complement = true;		\
+	else errno = FRE_INVALMODIF;					\
+	break;								\
+      case 'd':								\
+	if (is_tr) freg_object->fre_mod_tr_delete = true;		\
+	else errno = FRE_INVALMODIF;					\
+	break;								\
+      case 'r':								\
+	if (is_tr) freg_object->fre_mod_tr_return = true;		\
+	else errno = FRE_INVALMODIF;					\
 	break;								\
       case 'm':								\
 	freg_object->fre_mod_boleol = true;				\
@@ -100,7 +117,7 @@
     ++(*token_ind);							\
     do {								\
       refnum_string[i++] = pattern[(*token_ind)++];			\
-    } while (isdigit(*token_ind));					\
+    } while (isdigit(pattern[*token_ind]));					\
     refnum = atol(refnum_string);					\
     if (!fre_is_sub){							\
       freg_object->backref_pos->p_sm_number[freg_object->backref_pos->in_pattern_c++] = refnum; \
@@ -162,40 +179,6 @@
   } while (0);
 
 
-/*
- * Replaces a word boundary token sequence if we can, else raise
- * the appropriate fre_pattern flag.
- * Takes the fre_pattern, the ->striped_pattern's top of stack, the new pattern _p_t_p() is builing, its top of stack
- * and lenght, a 0 or 1 value indicating whether this is the matching or substitute pattern and a 0 or 1                   
- * value indicating whether it's a word boundary sequence: '\<' '\>' '\b' or a not a word boundary sequence '\B'.
- * This MACRO might return an integer, careful about using it elsewhere than _perl_to_posix(). 
- */
-# define FRE_REGISTER_BOUNDARY(freg_objet, spa_tos, new_pat, new_pat_tos, new_pat_len, is_sub, is_word) do{ \
-    size_t i = 0;                                                       \
-    errno = 0;								\
-    if (spa_tos == 0){                                                  \
-      if (!is_sub) freg_object->fre_match_op_bow = true;                \
-      else freg_object->fre_subs_op_bow = true;                         \
-    } else if (spa_tos == (strlen(freg_object->striped_pattern[is_sub])-2)){ \
-      if (!is_sub) freg_object->fre_match_op_eow = true;                \
-      else freg_object->fre_subs_op_eow = true;                         \
-    }                                                                   \
-    else {                                                              \
-      if (is_word){                                                     \
-	if ((*new_pat_len += strlen(FRE_POSIX_NON_WORD_CHAR)+1) >= FRE_MAX_PATTERN_LENGHT){ \
-	  errno = FRE_BOUNDOVERF; break;				\
-	}                                                               \
-	while(FRE_POSIX_NON_WORD_CHAR[i] != '\0') FRE_PUSH(FRE_POSIX_NON_WORD_CHAR[i++], new_pat, new_pat_tos); \
-      } else {                                                          \
-	if ((*new_pat_len += strlen(FRE_POSIX_WORD_CHAR)+1) >= FRE_MAX_PATTERN_LENGHT){ \
-	  errno = FRE_BOUNDOVERF; break;				\
-	}                                                               \
-	while (FRE_POSIX_WORD_CHAR[i] != '\0') FRE_PUSH(FRE_POSIX_WORD_CHAR[i++], new_pat, new_pat_tos); \
-      }                                                                 \
-    }                                                                   \
-  } while (0);
-
-
 /*
  * This MACRO is used to verify each escape sequence found in the user's given pattern,
  * and replace any sequences not supported by the POSIX standard.
@@ -258,19 +241,6 @@
       while (FRE_POSIX_NON_SPACE_CHAR[i] != '\0') FRE_PUSH(FRE_POSIX_NON_SPACE_CHAR[i++], new_pat, new_pat_tos); \
       *token_ind += 2;                                                  \
       break;                                                            \
-    case 'b': /* Fall throught */                                       \
-    case '<': /* Fall throught */                                       \
-    case '>':                                                           \
-      FRE_REGISTER_BOUNDARY(freg_object, *token_ind, new_pat,           \
-			    new_pat_tos, new_pat_len, is_sub, 1);       \
-      *token_ind += 2;                                                  \
-      break;                                                            \
-    case 'B':                                                           \
-      FRE_REGISTER_BOUNDARY(freg_object, *token_ind, new_pat,           \
-			    new_pat_tos, new_pat_len, is_sub, 0);       \
-      freg_object->fre_not_boundary = true;                             \
-      *token_ind += 2;                                                  \
-      break;                                                            \
     case 'N':								\
       if (((*new_pat_len) += strlen(FRE_POSIX_ALL_BUT_NEWLINE)) >= FRE_MAX_PATTERN_LENGHT){ \
 	errno = FRE_ESCSEQOVERF; intern__fre__errmesg("\\N");		\
@@ -279,6 +249,9 @@
       while (FRE_POSIX_ALL_BUT_NEWLINE[i] != '\0') FRE_PUSH(FRE_POSIX_ALL_BUT_NEWLINE[i++], new_pat, new_pat_tos); \
       *token_ind += 2;							\
       break;								\
+    case 'b': case 'B':                                                 \
+    case '<': case '>':                                                 \
+      /* Word boundaries, the engines take them as zero-width assertions. */ \
     default:                                                            \
       /* Assume a supported sequence, push the tokens on the pattern stack. */ \
       FRE_PUSH(freg_object->striped_pattern[is_sub][(*token_ind)++], new_pat, new_pat_tos); \
@@ -300,87 +273,5 @@ Most likely obsolete.
     }                                                                   \
   } while (0);
 
-/*
- * Verify and insert a dash separated range.
- * A dash separated range may be between any two printable characters,
- * so long as they appear in increasing order. It depends greatly on your locale.
- * Starting at *token_ind, insert the appropriate range in array.
- * ASCII only!!! 
- */
-# define FRE_INSERT_DASH_RANGE(array, token_ind, low, high) do { \
-    int temp = 0;                                               \
-    int current = low;                                          \
-    if (low >= high){                                           \
-      temp = low; low = high; high = temp;                      \
-    }                                                           \
-    while (current <= high)                                     \
-      array[(*token_ind)++] = current++;                        \
-  } while (0);
-
-
-/*
- * Takes the fre_pattern we're working on, the caller's string, a 0 or 1 value indicating whether
- * to check on either of the matching and substitute pattern respectively, the number of tokens
- * skipped by previous _cut_match() operations and a pointer to an int
- * indicating whether we had success or not. 1 all good, -1 error, 0 not a boundary.
- 
- * Note that in cases when a not-a-word boundary \B is used, *ret must be set to 
- * 0 if it's 1 and 1 if it's 0 once the checks are made.
- */
-
-# define FRE_CHECK_BOUNDARY(freg_object, string, numof_tokens, is_sub, ret) do { \
-    bool op_bow = ((is_sub) ? freg_object->fre_subs_op_bow : freg_object->fre_match_op_bow); \
-    bool op_eow = ((is_sub) ? freg_object->fre_subs_op_eow : freg_object->fre_match_op_eow); \
-    if (op_bow == true){                                                \
-      if (fre_pmatch_table->whole_match[WM_IND]->bo > 0){               \
-	if (isalpha(string[fre_pmatch_table->whole_match[WM_IND]->bo-(*numof_tokens)-1])) *ret = 0; \
-	else *ret = 1;                                                  \
-      }                                                                 \
-      else { *ret = 1;                                                  \
-      }                                                                 \
-      /* Inverse resuls of previous op if the boundary sequence is '\B' */ \
-      if (freg_object->fre_not_boundary == true){                       \
-	if (*ret) *ret = 0; else *ret = 1;                              \
-      }                                                                 \
-    }                                                                   \
-    if (op_eow == true){                                                \
-      /* String's lenght has been checked to be under INT_MAX-1 when entering the library. */ \
-      if (fre_pmatch_table->whole_match[WM_IND]->eo < (int)strlen(string)-1){ \
-	if (isalpha(string[fre_pmatch_table->whole_match[WM_IND]->eo-(*numof_tokens)])) *ret = 0; \
-	else *ret = 1;                                                  \
-      }                                                                 \
-      else { *ret = 1;                                                  \
-      }                                                                 \
-      /* Inverse resuls of previous op if the boundary sequence is '\B' */ \
-      if (freg_object->fre_not_boundary == true){                       \
-	if (*ret) *ret = 0; else *ret = 1;                              \
-      }                                                                 \
-    }                                                                   \
-  } while(0);
-
-
-/*
- * Reset the ptable's ->whole_match[WM_IND] field and all it's corresponding
- * sub-matches to -1.
- */
-# define FRE_CANCEL_CUR_MATCH() do {			      \
-    int i = 0;						      \
-    fre_pmatch_table->whole_match[WM_IND]->bo = -1;	      \
-    fre_pmatch_table->whole_match[WM_IND]->eo = -1;	      \
-    while(i++ < fre_pmatch_table->subm_per_match){	      \
-      fre_pmatch_table->sub_match[SM_IND]->bo = -1;	      \
-      fre_pmatch_table->sub_match[SM_IND]->eo = -1;	      \
-      if (SM_IND > 0) --SM_IND;				      \
-    }							      \
-  } while(0);
-
-# define FRE_CANCEL_ALL_MATCH() do {                             \
-    while(1) {                                                  \
-      FRE_CANCEL_CUR_MATCH();                                   \
-      if (WM_IND > 0) --WM_IND;                                 \
-      else break;                                               \
-    }								\
-  } while(0);
-
 
 #endif /* FRE_INTERNAL_MACRO_HEADER */
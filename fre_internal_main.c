@@ -127,14 +127,37 @@ fre_pattern* intern__fre__plp_parser(char *pattern)
       goto errjmp;
     }
     if (freg_object->fre_op_flag == SUBSTITUTE) {
-      if (intern__fre__perl_to_posix(freg_object, 1) != FRE_OP_SUCCESSFUL){
-	intern__fre__errmesg("_perl_to_posix");
+      if (intern__fre__compile_replacement(freg_object) != FRE_OP_SUCCESSFUL){
+	intern__fre__errmesg("_compile_replacement");
 	goto errjmp;
       }
     }
-    /* Compile the modified matching pattern. */
-    if (intern__fre__compile_pattern(freg_object) == FRE_ERROR){
-      intern__fre__errmesg("_compile_pattern");
+    /* Plain literals, and alternations of them, need no regex_t. */
+    if (intern__fre__compile_literal(freg_object) == FRE_ERROR){
+      intern__fre__errmesg("_compile_literal");
+      goto errjmp;
+    }
+    if (freg_object->engine == FRE_ENGINE_REGEX
+	&& intern__fre__compile_ac(freg_object) == FRE_ERROR){
+      intern__fre__errmesg("_compile_ac");
+      goto errjmp;
+    }
+    if (freg_object->engine == FRE_ENGINE_REGEX){
+      /* Compile the modified matching pattern. */
+      if (intern__fre__compile_pattern(freg_object) == FRE_ERROR){
+	intern__fre__errmesg("_compile_pattern");
+	goto errjmp;
+      }
+      /* Now that regcomp() accepted it, see if the DFA can take over. */
+      if (intern__fre__compile_native(freg_object) == FRE_ERROR){
+	intern__fre__errmesg("_compile_native");
+	goto errjmp;
+      }
+    }
+  }
+  else {
+    if (intern__fre__compile_translit(freg_object) != FRE_OP_SUCCESSFUL){
+      intern__fre__errmesg("_compile_translit");
       goto errjmp;
     }
   }
@@ -149,225 +172,114 @@ fre_pattern* intern__fre__plp_parser(char *pattern)
 } /* intern__fre__plp_parser() */
 
 
+/*
+ * Execute a match operation.
+ * Matches are searched for by moving an offset forward within the caller's
+ * string, the string is never copied nor cut. A global operation keeps
+ * searching from the end of the previous match (or one past it when that
+ * match was empty) until the end of the string.
+ * string_len bytes are looked at, NUL bytes among them included.
+ */
 int intern__fre__match_op(char *string,                  /* The string to bind the pattern against. */
+			  size_t string_len,             /* Its lenght. */
 			  fre_pattern *freg_object,      /* The information gathered by the _plp_parser(). */
-			  size_t *numof_tokens)           /* Number of tokens skiped by a previous global recursion. */
+			  size_t offset_to_start)        /* Where in string to start looking for matches. */
 {
-  size_t reg_c = 0;
-  int i = 0;
-  int replacement_len = 0;
-  size_t string_len = strnlen(string, FRE_ARG_STRING_MAX_LENGHT);
-  int match_ret = 0, match_op_ret = 0;
-  regmatch_t regmatch_arr[FRE_MAX_SUB_MATCHES];
-  char *string_copy = NULL;
-  fre_smatch **stemp = NULL, **wtemp = NULL;
-  
-  if (!string || !freg_object || string_len++ >= FRE_ARG_STRING_MAX_LENGHT){
+  size_t i = 0;
+  size_t start = offset_to_start;
+  size_t numof_sm = 0;
+  int match_ret = 0;
+  fre_smatch match_arr[FRE_MAX_SUB_MATCHES];
+
+  if (!string || !freg_object || string_len >= FRE_ARG_STRING_MAX_LENGHT){
     errno = EINVAL;
     return FRE_ERROR;
   }
-  if ((string_copy = calloc(string_len, sizeof(char))) == NULL){
-    intern__fre__errmesg("Calloc");
-    goto errjmp;
-  }
-  if (SU_strcpy(string_copy, string, string_len) == NULL){
-    intern__fre__errmesg("Calloc");
-    goto errjmp;
-  }
-  
-  if ((match_ret = regexec(freg_object->comp_pattern, string_copy, FRE_MAX_SUB_MATCHES,
-			   regmatch_arr, 0)) == FRE_ERROR){
-    intern__fre__errmesg("Regexec");
-    return FRE_ERROR;
-  }
-  /* Match successful. */
-  if (match_ret == 0){
-    /* Register positions of match/sub-matches now. */
-    if (regmatch_arr[reg_c].rm_so != -1){
-      fre_pmatch_table->lastop_retval = FRE_OP_SUCCESSFUL;
-      fre_pmatch_table->whole_match[WM_IND]->bo = regmatch_arr[reg_c].rm_so + *numof_tokens;
-      fre_pmatch_table->whole_match[WM_IND]->eo = regmatch_arr[reg_c].rm_eo + *numof_tokens;
-      ++reg_c;
-      while (reg_c < FRE_MAX_SUB_MATCHES && regmatch_arr[reg_c].rm_so != -1){
-	fre_pmatch_table->sub_match[SM_IND]->bo = regmatch_arr[reg_c].rm_so + *numof_tokens;
-	fre_pmatch_table->sub_match[SM_IND]->eo = regmatch_arr[reg_c].rm_eo + *numof_tokens;
-	++reg_c;
-	/* Extend the sub-match list if needed. */
-	if (++SM_IND >= fre_pmatch_table->sm_size){
-	  /* 0 == whole_match list, 1 == sub_match list. */
-	  if (intern__fre__extend_ptable_list(1) == FRE_ERROR){
-	    intern__fre__errmesg("_extend_ptable_list");
-	    goto errjmp;
-	  }
-	}
-      }
-    }
-    else {
-      /* 
-       * If the match is considered successful but regmatch[0] 
-       * contains only -1s, we've got a problem. 
-       * Long way of saying it can never happen or chaos and darkness will follow. 
-       */
-      errno = FRE_INVALBREF;
+  if (fre_pmatch_table->lastop_retval != FRE_OP_SUCCESSFUL)
+    fre_pmatch_table->lastop_retval = FRE_OP_UNSUCCESSFUL;
+
+  while (start <= string_len){
+    numof_sm = freg_object->numof_groups + 1;
+    if (numof_sm > FRE_MAX_SUB_MATCHES)
+      numof_sm = FRE_MAX_SUB_MATCHES;
+    if ((match_ret = intern__fre__exec_match(freg_object, string, string_len, start,
+					     match_arr, numof_sm)) == FRE_ERROR){
+      intern__fre__errmesg("_exec_match");
       goto errjmp;
     }
-    /*The number of sub-matches per matches. */
-    fre_pmatch_table->subm_per_match = reg_c - 1;
+    else if (match_ret == FRE_OP_UNSUCCESSFUL)
+      break;
 
-    /* 
-     * Check for the presence of word boundaries now. 
-     * Not sure yet where exactly to check boundaries in a substitute pattern.
-     (I was wrong, substitute pattern MUST not be modified !).
-     */
-    if (freg_object->fre_match_op_bow == true || freg_object->fre_match_op_eow == true){
-      match_ret = 0;
-      FRE_CHECK_BOUNDARY(freg_object, string, numof_tokens, 0, &match_ret);
-      if ((fre_pmatch_table->lastop_retval = match_ret) != FRE_OP_SUCCESSFUL){
-	if (intern__fre__cut_match(string_copy, numof_tokens, string_len,
-				   fre_pmatch_table->whole_match[WM_IND]->bo,
-				   fre_pmatch_table->whole_match[WM_IND]->eo) == NULL){
-	  intern__fre__errmesg("_cut_match");
-	  goto errjmp;
-	}
-	/* Clear the current, unsuccessful match position from the pmatch_table. */
-	FRE_CANCEL_CUR_MATCH();
-	if (intern__fre__match_op(string_copy, freg_object, numof_tokens) == FRE_ERROR){
-	  intern__fre__errmesg("_match_op");
+    /* Register positions of match/sub-matches now. */
+    fre_pmatch_table->lastop_retval = FRE_OP_SUCCESSFUL;
+    fre_pmatch_table->whole_match[WM_IND] = match_arr[0];
+    for (i = 1; i < numof_sm; i++){
+      fre_pmatch_table->sub_match[SM_IND] = match_arr[i];
+      /* Extend the sub-match list if needed. */
+      if (++SM_IND >= fre_pmatch_table->sm_size){
+	/* 0 == whole_match list, 1 == sub_match list. */
+	if (intern__fre__extend_ptable_list(1) == FRE_ERROR){
+	  intern__fre__errmesg("_extend_ptable_list");
 	  goto errjmp;
 	}
       }
     }
-    
-    if (freg_object->fre_match_op_bref == true){
-      /* Decrement SM_IND by the number of sub-matches per matches, _insert_sm() will use it. */
-      SM_IND -= fre_pmatch_table->subm_per_match;
-      if ((replacement_len = intern__fre__insert_sm(freg_object, string, *numof_tokens, 0)) == FRE_ERROR){
-	intern__fre__errmesg("_insert_sm");
-	goto errjmp;
-      }
-      regfree(freg_object->comp_pattern);
-      if (intern__fre__compile_pattern(freg_object) == FRE_ERROR){
-	intern__fre__errmesg("_compile_pattern");
-	goto errjmp;
-      }
-      /* Can the next statement overflow? */
-      /* Only set fre_match_op_bref to false if there's no more backreference to insert. */
-      freg_object->fre_match_op_bref = false;
-      FRE_CANCEL_CUR_MATCH();
-      if ((match_op_ret = intern__fre__match_op(string, freg_object, numof_tokens)) == FRE_ERROR){
-	intern__fre__errmesg("_match_op");
-	goto errjmp;
-      }
-      else if (match_op_ret == FRE_OP_SUCCESSFUL){
-	fre_pmatch_table->lastop_retval = FRE_OP_SUCCESSFUL;
-	freg_object->fre_match_op_bref = true;
-      }
-      else {
-	fre_pmatch_table->lastop_retval = FRE_OP_UNSUCCESSFUL;
-	/* Resets revelant fields of the ptable to -1.
-	   Think about this twice, the current match was cleared before the recursive call to match_op. */
-	FRE_CANCEL_ALL_MATCH();
-      }
-    }
+    /*The number of sub-matches per matches. */
+    fre_pmatch_table->subm_per_match = numof_sm - 1;
     /* Extend the ->whole_match list if needed. */
     if (++WM_IND >= fre_pmatch_table->wm_size)
       if (intern__fre__extend_ptable_list(0) == FRE_ERROR){
 	intern__fre__errmesg("_extend_ptable_list");
 	goto errjmp;
       }
+
     /* Handle global operations. */
-    if (freg_object->fre_mod_global == true){
-      if (intern__fre__cut_match(string_copy, numof_tokens, string_len,
-				 fre_pmatch_table->whole_match[WM_IND-1]->bo,
-				 fre_pmatch_table->whole_match[WM_IND-1]->eo) == NULL){
-	intern__fre__errmesg("_cut_match");
-	goto errjmp;
-      }
-      if (strlen(string_copy) > 0){
-	/* If the original pattern was changed with backrefs, restore it. */
-	if (freg_object->fre_match_op_bref == true){
-	  regfree(freg_object->comp_pattern);
-	  if (SU_strcpy(freg_object->striped_pattern[0],
-			freg_object->saved_pattern[0],
-			FRE_MAX_PATTERN_LENGHT) == NULL){
-	    intern__fre__errmesg("SU_strcpy");
-	    goto errjmp;
-	  }
-	  if (intern__fre__compile_pattern(freg_object) == FRE_ERROR){
-	    intern__fre__errmesg("_compile_pattern");
-	    goto errjmp;
-	  }
-	}
-	if (intern__fre__match_op(string_copy, freg_object, numof_tokens) == FRE_ERROR){
-	  intern__fre__errmesg("_match_op");
-	  goto errjmp;
-	}
-      }
-    }
-  }
-  else {
-    if (fre_pmatch_table->lastop_retval != FRE_OP_SUCCESSFUL)
-      fre_pmatch_table->lastop_retval = FRE_OP_UNSUCCESSFUL;
+    if (freg_object->fre_mod_global == false)
+      break;
+    start = (size_t)match_arr[0].eo;
+    if (match_arr[0].eo == match_arr[0].bo)
+      ++start;
   }
-	 
-  if (string_copy)
-    free(string_copy);
-  string_copy = NULL;
+
   return fre_pmatch_table->lastop_retval;
 
  errjmp:
-  if (string_copy){
-    free(string_copy);
-    string_copy = NULL;
-  }
-  if (stemp){
-    for (i = 0; i < (int)fre_pmatch_table->sm_size; i++)
-      if (stemp[i]){
-	free(stemp[i]);
-	stemp[i] = NULL;
-      }
-    free(stemp);
-    stemp = NULL;
-  }
-  if (wtemp){
-    for (i = 0; i < (int)fre_pmatch_table->wm_size; i++)
-      if(wtemp[i]){
-	free(wtemp[i]);
-	wtemp[i] = NULL;
-      }
-    free(wtemp);
-    wtemp = NULL;
-  }
   fre_pmatch_table->lastop_retval = FRE_ERROR;
   return FRE_ERROR;
 
 } /* intern__fre__match_op() */
 
 
-/* Execute a substitution operation. */
+/*
+ * Execute a substitution operation.
+ * Once _match_op() registered every match, the new string is built in a single
+ * forward pass: the text in between matches, then each segment of the compiled
+ * substitute pattern, literal runs and sub-matches alike.
+ * It is built inside the pmatch-table's subs_buffer and copied back to the caller's
+ * string only once it's known to fit in string_size bytes.
+ */
 int intern__fre__substitute_op(char *string,
+			       size_t string_len,
 			       size_t string_size,
 			       fre_pattern *freg_object,
-			       size_t *offset_to_start)
+			       size_t offset_to_start)
 {
-  char *new_string = NULL;
-  char *string_copy = NULL;   /* use the string directly?? */
   int match_ret = 0;
-  int replacement_len = 0;
-  int sumof_tokens = 0;
-  int sumof_lenghts = 0;
-  int replacement_ind = 0, string_ind = 0;
-  int sp_ind = 0, ns_ind = 0;
-  size_t new_string_len = strnlen(string, FRE_ARG_STRING_MAX_LENGHT);
-  int numof_tokens = 0;
-  size_t subm_per_match = fre_pmatch_table->subm_per_match;
-
-  if (!string || !string_size
-      || !freg_object || !offset_to_start) {
+  size_t i = 0, wm_ind = 0, string_ind = 0;
+  size_t new_string_len = 0, piece_len = 0;
+  size_t subm_per_match = 0;
+  char *piece = NULL;
+  char *new_string = NULL;
+  fre_smatch *match = NULL;
+  fre_repl_seg *seg = NULL;
+  fre_replacement *repl = NULL;
+
+  if (!string || !string_size || !freg_object || !freg_object->replacement) {
     errno = EINVAL;
     goto errjmp;
   }
-  if ((match_ret = intern__fre__match_op(string, freg_object, offset_to_start)) == FRE_ERROR){
+  repl = freg_object->replacement;
+  if ((match_ret = intern__fre__match_op(string, string_len, freg_object, offset_to_start)) == FRE_ERROR){
     intern__fre__errmesg("_match_op");
     goto errjmp;
   }
@@ -375,90 +287,73 @@ int intern__fre__substitute_op(char *string,
     fre_pmatch_table->lastop_retval = FRE_OP_UNSUCCESSFUL; /* redundant */
     return FRE_OP_UNSUCCESSFUL;
   }
+
   /* Successful match. */
-  else {
-    WM_IND = 0; SM_IND = 0;
-    if ((new_string = calloc(string_size, sizeof(char))) == NULL){
-      intern__fre__errmesg("Calloc");
-      goto errjmp;
-    }
-    if ((string_copy = calloc(string_size, sizeof(char))) == NULL){
-      intern__fre__errmesg("Calloc");
-      goto errjmp;
-    }
-    if(SU_strcpy(string_copy, string, string_size) == NULL){
-      intern__fre__errmesg("SU_strcpy");
+  subm_per_match = (size_t)fre_pmatch_table->subm_per_match;
+  if (fre_pmatch_table->subs_buffer_size < string_size){
+    if ((new_string = realloc(fre_pmatch_table->subs_buffer, string_size)) == NULL){
+      intern__fre__errmesg("Realloc");
       goto errjmp;
     }
+    fre_pmatch_table->subs_buffer = new_string;
+    fre_pmatch_table->subs_buffer_size = string_size;
+  }
+  new_string = fre_pmatch_table->subs_buffer;
 
-    while (string_copy[string_ind] != '\0'
-	   && fre_pmatch_table->whole_match[WM_IND]->bo != -1){
-      /* 
-       * Add the sum of all replacement string and sub the number of tokens removed from the caller's
-       * string to the index in ptable->wm->bo to find where in the modified string this index is at. 
-       */
-      if (string_ind == fre_pmatch_table->whole_match[WM_IND]->bo - sumof_tokens + sumof_lenghts){
-	size_t temp_sumof_tokens = (size_t)sumof_tokens;
-	if (intern__fre__cut_match(string_copy, &temp_sumof_tokens, string_size,
-				   fre_pmatch_table->whole_match[WM_IND]->bo,
-				   fre_pmatch_table->whole_match[WM_IND]->eo) == NULL){
-	  intern__fre__errmesg("_cut_match");
-	  goto errjmp;
-	}
-	sumof_tokens = (int)temp_sumof_tokens;
-	/*sumof_tokens += numof_tokens;  can overflow. */
-	if (freg_object->fre_subs_op_bref == true){
-	  if (SU_strcpy(freg_object->striped_pattern[1], freg_object->saved_pattern[1], FRE_MAX_PATTERN_LENGHT) == NULL){
-	    intern__fre__errmesg("SU_strcpy");
-	    goto errjmp;
-	  }
-	  if ((replacement_len = intern__fre__insert_sm(freg_object, string,
-							0, 1)) == FRE_ERROR){
-	    intern__fre__errmesg("_insert_sm");
-	    goto errjmp;
-	  }
-	}
-	for (sp_ind = 0;
-	     freg_object->striped_pattern[1][sp_ind] != '\0';
-	     sp_ind++)
-	  new_string[ns_ind++] = freg_object->striped_pattern[1][sp_ind];
-	++WM_IND; /* Get next match positions. */
+#ifdef FRE_APPEND
+# undef FRE_APPEND
+#endif
+  /* Append piece_len characters of piece to the new string, leaving room for a NULL byte. */
+#define FRE_APPEND() do {						\
+    if (piece_len >= string_size - new_string_len){			\
+      errno = EOVERFLOW;						\
+      goto errjmp;							\
+    }									\
+    memcpy(new_string + new_string_len, piece, piece_len);		\
+    new_string_len += piece_len;					\
+  } while (0)
+
+  for (wm_ind = 0; wm_ind < WM_IND; wm_ind++){
+    match = &fre_pmatch_table->whole_match[wm_ind];
+    /* The text in between the previous match and this one. */
+    piece = string + string_ind;
+    piece_len = (size_t)match->bo - string_ind;
+    FRE_APPEND();
+    for (i = 0; i < repl->segs_c; i++){
+      seg = &repl->segs[i];
+      if (seg->sm_number == -1){
+	piece = repl->literals + seg->lit_off;
+	piece_len = seg->lit_len;
       }
-      else {
-	new_string[ns_ind++] = string_copy[string_ind++];
+      else if (seg->sm_number == 0){
+	piece = string + match->bo;
+	piece_len = (size_t)(match->eo - match->bo);
       }
-      
+      else if ((size_t)seg->sm_number <= subm_per_match
+	       && fre_pmatch_table->sub_match[wm_ind * subm_per_match + seg->sm_number - 1].bo != -1){
+	fre_smatch *subm = &fre_pmatch_table->sub_match[wm_ind * subm_per_match + seg->sm_number - 1];
+	piece = string + subm->bo;
+	piece_len = (size_t)(subm->eo - subm->bo);
+      }
+      /* Sub-matches that didn't participate, or don't exist, are replaced by nothing. */
+      else
+	piece_len = 0;
+      FRE_APPEND();
     }
+    string_ind = (size_t)match->eo;
   }
-  
   /* Make sure we leave no one behind. */
-  while (string_copy[string_ind] != '\0')
-    new_string[ns_ind++] = string_copy[string_ind++];
-  new_string[ns_ind] = '\0';
-
-  if (SU_strcpy(string, new_string, string_size) == NULL){
-    intern__fre__errmesg("SU_strcpy");
-    goto errjmp;
-  }
-  if (new_string){
-    free(new_string);
-    new_string = NULL;
-  }
-  if (string_copy){
-    free(string_copy);
-    string_copy = NULL;
-  }
+  piece = string + string_ind;
+  piece_len = string_len - string_ind;
+  FRE_APPEND();
+  new_string[new_string_len] = '\0';
+#undef FRE_APPEND
+
+  memcpy(string, new_string, new_string_len + 1);
+  fre_pmatch_table->result_len = new_string_len;
   return FRE_OP_SUCCESSFUL;
 
  errjmp:
-  if (new_string){
-    free(new_string);
-    new_string = NULL;
-  }
-  if (string_copy){
-    free(string_copy);
-    string_copy = NULL;
-  }
   fre_pmatch_table->lastop_retval = FRE_ERROR;
   return FRE_ERROR;
   
@@ -466,131 +361,74 @@ int intern__fre__substitute_op(char *string,
 } /* intern__fre__substitute_op() */
 
 
-/* Execute a transliteration operation (paired-character substitution). */
+/* 
+ * Execute a transliteration operation (paired-character substitution).
+ * The pattern was compiled into a byte map by the _plp_parser, 
+ * apply it to the caller's string in place, or with /r to the pmatch-table's tr_result.
+ * The number of bytes found in the search list is left in the pmatch-table's tr_count.
+ * A NUL byte is only written after the string when it shrinks, or to tr_result.
+ */
 int intern__fre__transliterate_op(char *string,
-				  size_t string_size,
+				  size_t string_len,
 				  fre_pattern *freg_object)
 {
-
-  size_t i = 0, j = 0, token_ind = 0;
-  size_t sp_ind = 0;
-  char **new_striped_p = NULL;
-  char *new_string = NULL;
-
-  if (!string || !freg_object || string_size == 0){
+  size_t i = 0, ns_ind = 0, count = 0;
+  int last_translit = -1;          /* With /s, the last byte we transliterated, -1 if it wasn't. */
+  unsigned char byte = 0;
+  unsigned char *src = (unsigned char*)string;
+  unsigned char *dest = (unsigned char*)string;
+  char *temp = NULL;
+  fre_translit *tr = NULL;
+
+  if (!string || !freg_object || !freg_object->translit){
     errno = EINVAL;
     return FRE_ERROR;
   }
-
-  if ((new_string = calloc(string_size, sizeof(char))) == NULL){
-    intern__fre__errmesg("Calloc");
-    return FRE_ERROR;
-  }
-  if ((new_striped_p = malloc(2 * sizeof(char*))) == NULL){
-    intern__fre__errmesg("Malloc");
-    goto errjmp;
-  }
-  for (i = 0; i < 2; i++)
-    if ((new_striped_p[i] = calloc(FRE_MAX_PATTERN_LENGHT, sizeof(char))) == NULL){
-      intern__fre__errmesg("Calloc");
-      goto errjmp;
-    }
- 
-  /*
-   * Ranges are the only supported special characters in a
-   * transliteration operation pattern. Look for and replace them.
-   */
-  while(sp_ind < 2){
-    j = 0; i = 0;
-    while(freg_object->striped_pattern[sp_ind][i] != '\0') {
-      if (freg_object->striped_pattern[sp_ind][i] == '\\'
-	  && freg_object->striped_pattern[sp_ind][i + 1] == 'd'){
-	int low = '0', high = '9';
-	FRE_INSERT_DASH_RANGE(new_striped_p[sp_ind], &j, low, high);
-	i += 2; /* skip \d */
-	continue;
-      }
-      else if (freg_object->striped_pattern[sp_ind][i] == '-'){
-	--j; /* Since the first character has already been added to new_s_p. */
-	FRE_INSERT_DASH_RANGE(new_striped_p[sp_ind], &j,
-			      freg_object->striped_pattern[sp_ind][i - 1],
-			      freg_object->striped_pattern[sp_ind][i + 1]);
-	i += 2; /* skip -x */
-	continue;
-      }
-      new_striped_p[sp_ind][j++] = freg_object->striped_pattern[sp_ind][i++];
-    }
-    if (SU_strcpy(freg_object->striped_pattern[sp_ind],
-		  new_striped_p[sp_ind],
-		  FRE_MAX_PATTERN_LENGHT) == NULL){
-      intern__fre__errmesg("SU_strcpy");
-      goto errjmp;
-    }
-    ++sp_ind;
-  }
-  /* 
-   * If both patterns of a transliteration expression do not contain a matching
-   * number of characters its a syntax error.
-   */
-  if (strlen(freg_object->striped_pattern[0]) !=
-      strlen(freg_object->striped_pattern[1])){
-    errno = FRE_INVALTRANSL;
-    goto errjmp;
-  }
-      
-  /* No need for these arrays anymore. */
-  if (new_striped_p){
-    for (i = 0; i < 2; i++){
-      if (new_striped_p[i]){
-	free(new_striped_p[i]);
-	new_striped_p[i] = NULL;
+  tr = freg_object->translit;
+  if (freg_object->fre_mod_tr_return == true){
+    if (fre_pmatch_table->tr_result_size < string_len + 1){
+      if ((temp = realloc(fre_pmatch_table->tr_result, string_len + 1)) == NULL){
+	intern__fre__errmesg("Realloc");
+	return FRE_ERROR;
       }
+      fre_pmatch_table->tr_result = temp;
+      fre_pmatch_table->tr_result_size = string_len + 1;
     }
-    free(new_striped_p);
-    new_striped_p = NULL;
+    dest = (unsigned char*)fre_pmatch_table->tr_result;
   }
 
-  /* Transliterate right here, right now ! */
-  for (i = 0, token_ind = 0; string[i] != '\0'; i++){
-    j = 0;
-    while (freg_object->striped_pattern[0][j] != '\0') {
-      if (string[i] == freg_object->striped_pattern[0][j]){
-	new_string[token_ind++] = freg_object->striped_pattern[1][j];
-	j = 0;
-	++i;
+  /* The length of the string stays the same, let the kernels do all the work. */
+  if (tr->squeeze == false && tr->has_deletions == false){
+    count = intern__fre__translit_map(dest, src, string_len, tr);
+    ns_ind = string_len;
+  }
+  /* Bytes to delete or squeeze, the string shrinks as we go. */
+  else {
+    for (i = 0; i < string_len; i++){
+      byte = src[i];
+      if (!(tr->in_set[byte >> 3] & (1u << (byte & 7)))){
+	dest[ns_ind++] = byte;
+	last_translit = -1;
 	continue;
       }
-      j++;
+      ++count;
+      if (tr->del_set[byte >> 3] & (1u << (byte & 7)))
+	continue;
+      if (tr->squeeze == true && last_translit == tr->map[byte])
+	continue;
+      dest[ns_ind++] = tr->map[byte];
+      last_translit = tr->map[byte];
     }
-    new_string[token_ind++] = string[i];
-  }
-  new_string[token_ind] = '\0';
-  if (SU_strcpy(string, new_string, string_size) == NULL){
-    intern__fre__errmesg("SU_strcpy");
-    goto errjmp;
   }
-  free(new_string);
-  new_string = NULL;
+  if (ns_ind < string_len || dest != src)
+    dest[ns_ind] = '\0';
 
+  fre_pmatch_table->tr_count = count;
+  fre_pmatch_table->result_len = ns_ind;
+  fre_pmatch_table->tr_has_result = freg_object->fre_mod_tr_return;
   return FRE_OP_SUCCESSFUL;
-  
- errjmp:
-  if (new_striped_p){
-    for (i = 0; i < 2; i++){
-      if (new_striped_p[i]){
-	free(new_striped_p[i]);
-	new_striped_p[i] = NULL;
-      }
-    }
-    free(new_striped_p);
-    new_striped_p = NULL;
-  }
-  if (new_string){
-    free(new_string);
-    new_string = NULL;
-  }
-  return FRE_ERROR;
-}
+
+} /* intern__fre__transliterate_op() */
   
 
 
@@ -599,31 +437,30 @@ void print_ptable_hook(void)
 {
   size_t i = 0, n = 0;
   pthread_mutex_lock(&fre_stderr_mutex);
-  fprintf(stderr, "fre_saved_object: %s\n", ((fre_pmatch_table->fre_saved_object == true) ? "true" : "false"));
   fprintf(stderr, "lastop_retval: %d\n", fre_pmatch_table->lastop_retval);
-  fprintf(stderr, "ls_pattern: %s\n", ((fre_pmatch_table->ls_pattern[0] != '\0') ? fre_pmatch_table->ls_pattern : "NULL"));
-  fprintf(stderr, "ls_object: %s\nWhole_match positions:\n",
-	  ((fre_pmatch_table->ls_object) ? "Defined" : "NULL"));
-  while (i < fre_pmatch_table->wm_size && fre_pmatch_table->whole_match[i]->bo != -1) {
+  fprintf(stderr, "pattern_cache: %zu/%zu entries, %zu hits, %zu misses\nWhole_match positions:\n",
+	  fre_pmatch_table->pattern_cache->numof_entries, fre_pmatch_table->pattern_cache->capacity,
+	  fre_pmatch_table->pattern_cache->hits, fre_pmatch_table->pattern_cache->misses);
+  while (i < fre_pmatch_table->wm_size && fre_pmatch_table->whole_match[i].bo != -1) {
     if (n++ == 3){
       fprintf(stderr, "\n");
       n = 0;
     }
-    fprintf(stderr, "[%zu]->bo: %d    ->eo: %d    ", i,
-	    fre_pmatch_table->whole_match[i]->bo,
-	    fre_pmatch_table->whole_match[i]->eo);
+    fprintf(stderr, "[%zu]->bo: %lld    ->eo: %lld    ", i,
+	    (long long)fre_pmatch_table->whole_match[i].bo,
+	    (long long)fre_pmatch_table->whole_match[i].eo);
     ++i;
   }
   fprintf(stderr, "\nSub_match positions:\n");
   i = 0; n = 0;
-  while (i < fre_pmatch_table->sm_size && fre_pmatch_table->sub_match[i]->bo != -1){
+  while (i < fre_pmatch_table->sm_size && fre_pmatch_table->sub_match[i].bo != -1){
     if (n++ == 2){
       fprintf(stderr, "\n");
       n = 0;
     }
-    fprintf(stderr, "[%zu]->bo: %d    ->eo: %d    ", i,
-	    fre_pmatch_table->sub_match[i]->bo,
-	    fre_pmatch_table->sub_match[i]->eo);
+    fprintf(stderr, "[%zu]->bo: %lld    ->eo: %lld    ", i,
+	    (long long)fre_pmatch_table->sub_match[i].bo,
+	    (long long)fre_pmatch_table->sub_match[i].eo);
     ++i;
   }
   fprintf(stderr, "\nwm_ind: %zu\nsm_ind: %zu\nwm_size: %zu\nsm_size: %zu\n",
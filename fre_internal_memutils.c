@@ -111,6 +111,98 @@ void intern__fre__free_head_table(void)
 } /* intern__fre__free_head_table() */
 
 
+/*
+ * Allocate memory for the global table of parsed patterns
+ * shared by all threads, see fre_internal_cache.c .
+ */
+fre_shared_patterns* intern__fre__init_shared_table(void)
+{
+  fre_shared_patterns *shared_table = NULL;
+
+  if ((shared_table = malloc(sizeof(fre_shared_patterns))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return NULL;
+  }
+  shared_table->buckets = NULL;
+  if ((shared_table->table_lock = malloc(sizeof(pthread_mutex_t))) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  if (pthread_mutex_init(shared_table->table_lock, NULL) != 0){
+    intern__fre__errmesg("Pthread_mutex_init");
+    free(shared_table->table_lock);
+    shared_table->table_lock = NULL;
+    goto errjmp;
+  }
+  if ((shared_table->buckets = calloc(FRE_SHARED_BUCKETS, sizeof(fre_shared_entry*))) == NULL){
+    intern__fre__errmesg("Calloc");
+    goto errjmp;
+  }
+  shared_table->fifo_head = NULL;
+  shared_table->fifo_tail = NULL;
+  shared_table->retired = NULL;
+  shared_table->capacity = FRE_SHARED_CAPACITY;
+  shared_table->numof_entries = 0;
+  shared_table->epoch = 1; /* Readers publish the epoch they entered in, 0 means 'not reading'. */
+
+  return shared_table; /* Success ! */
+
+ errjmp:
+  if (shared_table->table_lock != NULL){
+    pthread_mutex_destroy(shared_table->table_lock);
+    free(shared_table->table_lock);
+  }
+  free(shared_table);
+  return NULL;
+
+} /* intern__fre__init_shared_table() */
+
+
+/*
+ * Release resources of the global shared pattern table.
+ * Only called by _lib_finit, once every clone has been released.
+ */
+void intern__fre__free_shared_table(void)
+{
+  fre_shared_entry *entry = NULL, *next = NULL;
+
+  if (fre_shared_pattern_table == NULL)
+    return;
+  for (entry = fre_shared_pattern_table->fifo_head; entry != NULL; entry = next){
+    next = entry->fifo_next;
+    intern__fre__free_shared_entry(entry);
+  }
+  for (entry = fre_shared_pattern_table->retired; entry != NULL; entry = next){
+    next = entry->fifo_next;
+    intern__fre__free_shared_entry(entry);
+  }
+  if (fre_shared_pattern_table->buckets != NULL){
+    free(fre_shared_pattern_table->buckets);
+    fre_shared_pattern_table->buckets = NULL;
+  }
+  if (fre_shared_pattern_table->table_lock != NULL){
+    pthread_mutex_destroy(fre_shared_pattern_table->table_lock);
+    free(fre_shared_pattern_table->table_lock);
+    fre_shared_pattern_table->table_lock = NULL;
+  }
+  free(fre_shared_pattern_table);
+  fre_shared_pattern_table = NULL;
+
+} /* intern__fre__free_shared_table() */
+
+
+/* Release a shared pattern table entry along with its parsed pattern. */
+void intern__fre__free_shared_entry(fre_shared_entry *entry)
+{
+  if (entry == NULL)
+    return;
+  intern__fre__free_pattern(entry->object);
+  free(entry->pattern);
+  free(entry);
+
+} /* intern__fre__free_shared_entry() */
+
+
 /*                                                                                                                                  
  * Allocate memory for arrays holding possible                                                                                      
  * back-reference(s) position(s) within the pattern(s).                                                                             
@@ -206,21 +298,17 @@ void intern__fre__free_bref_arr(fre_backref *to_free)
 
 
 /* 
- * Allocate memory to a fre_smatch structure,
- * used to register [sub]matches positions inside a matching string.
- * There's no deallocation function, free is being called by
- * intern__fre__free_pmatch_table(). 
+ * Mark numof_elements fre_smatch structures of list as unused,
+ * lists of [sub]matches positions are plain arrays owned by a pmatch-table.
  */
-fre_smatch* intern__fre__init_smatch(void)
+void intern__fre__init_smatch(fre_smatch *list,
+			      size_t numof_elements)
 {
-  fre_smatch *to_init = NULL;
-  if ((to_init = malloc(sizeof(fre_smatch))) == NULL){
-    intern__fre__errmesg("Malloc");
-    return NULL;
+  size_t i = 0;
+  for (i = 0; i < numof_elements; i++){
+    list[i].bo = -1;
+    list[i].eo = -1;
   }
-  to_init->bo = -1;
-  to_init->eo = -1;
-  return to_init;
 
 } /* intern__fre__init_smatch() */
 
@@ -232,41 +320,38 @@ fre_smatch* intern__fre__init_smatch(void)
  */
 fre_pmatch* intern__fre__init_pmatch_table(void)
 {
-  size_t i = 0;
   fre_pmatch *to_init = NULL;
 
   if ((to_init = malloc(sizeof(fre_pmatch))) == NULL){
     intern__fre__errmesg("Malloc");
     return NULL;
   }
-  if ((to_init->ls_pattern = calloc(FRE_MAX_PATTERN_LENGHT, sizeof(char))) == NULL){
-    intern__fre__errmesg("Calloc");
+  to_init->whole_match = NULL;
+  to_init->sub_match = NULL;
+  to_init->subs_buffer = NULL;
+  to_init->subs_buffer_size = 0;
+  to_init->tr_count = 0;
+  to_init->tr_result = NULL;
+  to_init->tr_has_result = false;
+  to_init->tr_result_size = 0;
+  to_init->result_len = 0;
+  if ((to_init->pattern_cache = intern__fre__init_pcache()) == NULL){
+    intern__fre__errmesg("Intern__fre__init_pcache");
     goto errjmp;
   }
-  if ((to_init->whole_match = malloc(FRE_MAX_MATCHES * sizeof(fre_smatch*))) == NULL){
+  if ((to_init->whole_match = malloc(FRE_MAX_MATCHES * sizeof(fre_smatch))) == NULL){
     intern__fre__errmesg("Malloc");
     goto errjmp;
   }
-  for (i = 0; i < FRE_MAX_MATCHES; i++){
-    if ((to_init->whole_match[i] = intern__fre__init_smatch()) == NULL){
-      intern__fre__errmesg("Intern__fre__init_smatch");
-      goto errjmp;
-    }
-  }
-  if ((to_init->sub_match = malloc(FRE_MAX_SUB_MATCHES * sizeof(fre_smatch*))) == NULL){
+  intern__fre__init_smatch(to_init->whole_match, FRE_MAX_MATCHES);
+  if ((to_init->sub_match = malloc(FRE_MAX_SUB_MATCHES * sizeof(fre_smatch))) == NULL){
     intern__fre__errmesg("Malloc");
     goto errjmp;
   }
-  for (i = 0; i < FRE_MAX_SUB_MATCHES; i++){
-    if ((to_init->sub_match[i] = intern__fre__init_smatch()) == NULL){
-      intern__fre__errmesg("Intern__fre__init_smatch");
-      goto errjmp;
-    }
-  }
-  to_init->ls_object = NULL;
+  intern__fre__init_smatch(to_init->sub_match, FRE_MAX_SUB_MATCHES);
   to_init->subm_per_match = 0;
   to_init->lastop_retval = 0;
-  to_init->fre_saved_object = false;
+  to_init->shared_epoch = 0;
   to_init->wm_ind = 0;
   to_init->sm_ind = 0;
   to_init->wm_size = FRE_MAX_MATCHES;
@@ -276,31 +361,18 @@ fre_pmatch* intern__fre__init_pmatch_table(void)
 
  errjmp:
   if (to_init != NULL){
-    if (to_init->ls_pattern){
-      free(to_init->ls_pattern);
-      to_init->ls_pattern = NULL;
+    if (to_init->pattern_cache){
+      intern__fre__free_pcache(to_init->pattern_cache);
+      to_init->pattern_cache = NULL;
     }
     if (to_init->whole_match != NULL){
-      for (i = 0; i < FRE_MAX_MATCHES; i++){
-	if (to_init->whole_match[i] != NULL){
-	  free(to_init->whole_match[i]);
-	  to_init->whole_match[i] = NULL;
-	}
-      }
       free(to_init->whole_match);
       to_init->whole_match = NULL;
     }
     if (to_init->sub_match != NULL){
-      for (i = 0; i < FRE_MAX_SUB_MATCHES; i++){
-	if (to_init->sub_match[i] != NULL){
-	  free(to_init->sub_match[i]);
-	  to_init->sub_match[i] = NULL;
-	}
-      }
       free(to_init->sub_match);
       to_init->sub_match = NULL;
     }
-    to_init->ls_object = NULL;
     free(to_init);
     to_init = NULL;
   }
@@ -312,34 +384,28 @@ fre_pmatch* intern__fre__init_pmatch_table(void)
 /* Release memory of a single pmatch_table. */
 void intern__fre__free_pmatch_table(fre_pmatch *to_free)
 {
-  size_t i = 0;
   /*  If we're being passed a NULL argument, return now. */
   if (to_free != NULL){
+    if (to_free->subs_buffer != NULL){
+      free(to_free->subs_buffer);
+      to_free->subs_buffer = NULL;
+    }
+    if (to_free->tr_result != NULL){
+      free(to_free->tr_result);
+      to_free->tr_result = NULL;
+    }
     if (to_free->sub_match != NULL){
-      for (i = 0; i < to_free->sm_size; i++){
-	if (to_free->sub_match[i] != NULL){
-	  free(to_free->sub_match[i]);
-	  to_free->sub_match[i] = NULL;
-	}
-      }
       free(to_free->sub_match);
       to_free->sub_match = NULL;
     }
     if (to_free->whole_match != NULL){
-      for (i = 0; i < to_free->wm_size; i++){
-	if (to_free->whole_match[i] != NULL){
-	  free(to_free->whole_match[i]);
-	  to_free->whole_match[i] = NULL;
-	}
-      }
       free(to_free->whole_match);
       to_free->whole_match = NULL;
     }
-    if (to_free->ls_pattern != NULL){
-      free(to_free->ls_pattern);
-      to_free->ls_pattern = NULL;
+    if (to_free->pattern_cache != NULL){
+      intern__fre__free_pcache(to_free->pattern_cache);
+      to_free->pattern_cache = NULL;
     }
-    to_free->ls_object = NULL;
 
     free(to_free);
   }
@@ -350,31 +416,78 @@ void intern__fre__free_pmatch_table(fre_pmatch *to_free)
 
 
 
+/*
+ * Allocate memory to an empty pattern cache,
+ * one of those lives in every pmatch-table.
+ */
+fre_pcache* intern__fre__init_pcache(void)
+{
+  fre_pcache *to_init = NULL;
+
+  if ((to_init = malloc(sizeof(fre_pcache))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return NULL;
+  }
+  if ((to_init->buckets = calloc(FRE_PCACHE_BUCKETS, sizeof(fre_pcache_entry*))) == NULL){
+    intern__fre__errmesg("Calloc");
+    free(to_init);
+    return NULL;
+  }
+  to_init->lru_head = NULL;
+  to_init->lru_tail = NULL;
+  to_init->capacity = FRE_PCACHE_CAPACITY;
+  to_init->numof_entries = 0;
+  to_init->hits = 0;
+  to_init->misses = 0;
+
+  return to_init;
+
+} /* intern__fre__init_pcache() */
+
+
+/* Release a pattern cache, along with every fre_pattern it still holds. */
+void intern__fre__free_pcache(fre_pcache *to_free)
+{
+  fre_pcache_entry *entry = NULL, *next = NULL;
+
+  if (to_free == NULL)
+    return;
+  for (entry = to_free->lru_head; entry != NULL; entry = next){
+    next = entry->lru_next;
+    intern__fre__free_pattern(entry->object);
+    free(entry->pattern);
+    free(entry);
+  }
+  if (to_free->buckets != NULL){
+    free(to_free->buckets);
+    to_free->buckets = NULL;
+  }
+  free(to_free);
+
+} /* intern__fre__free_pcache() */
+
+
+
 /*
  * Extend the Ptable's whole_match list when it's short on free space.
  * listnum == 0: whole_match list; listnum == 1: sub_match list;
+ * Lists double in size, so that recording k matches costs O(log k) reallocations.
  */
 int intern__fre__extend_ptable_list(int listnum){
-  fre_smatch **temp = NULL;
-  size_t i = ((listnum) ? fre_pmatch_table->sm_ind : fre_pmatch_table->wm_ind);
-  size_t newsize = ((listnum) ? fre_pmatch_table->sm_size*2 : fre_pmatch_table->wm_size*2);
-  if (listnum){
-    if ((temp = realloc(fre_pmatch_table->sub_match, newsize * sizeof(fre_smatch*))) == NULL){
-      intern__fre__errmesg("Realloc");
-      return FRE_ERROR;
-    }
+  fre_smatch *temp = NULL;
+  size_t oldsize = ((listnum) ? fre_pmatch_table->sm_size : fre_pmatch_table->wm_size);
+  size_t newsize = oldsize * 2;
+
+  if (newsize < oldsize || newsize > SIZE_MAX / sizeof(fre_smatch)){
+    errno = EOVERFLOW;
+    return FRE_ERROR;
   }
-  else{
-    if ((temp = realloc(fre_pmatch_table->whole_match, newsize * sizeof(fre_smatch*))) == NULL){
-      intern__fre__errmesg("Realloc");
-      return FRE_ERROR;
-    }
+  if ((temp = realloc(((listnum) ? fre_pmatch_table->sub_match : fre_pmatch_table->whole_match),
+		      newsize * sizeof(fre_smatch))) == NULL){
+    intern__fre__errmesg("Realloc");
+    return FRE_ERROR;
   }
-  while (i < newsize)
-    if ((temp[i] = intern__fre__init_smatch()) == NULL){
-      intern__fre__errmesg("Intern__fre__init_smatch");
-      goto errjmp;
-    }
+  intern__fre__init_smatch(temp + oldsize, newsize - oldsize);
   if (listnum) {
     fre_pmatch_table->sub_match = temp;
     fre_pmatch_table->sm_size = newsize;
@@ -383,22 +496,37 @@ int intern__fre__extend_ptable_list(int listnum){
     fre_pmatch_table->whole_match = temp;
     fre_pmatch_table->wm_size = newsize;
   }
-  temp = NULL;
   return FRE_OP_SUCCESSFUL;
 
- errjmp:
-  if (temp)
-    for (i = 0; i < newsize; i++)
-      if(temp[i]){
-	free(temp[i]);
-	temp[i] = NULL;
-      }
-  return FRE_ERROR;
-
 } /* intern__fre__extend_ptable_list() */
 
 
 
+/*
+ * Reset the calling thread's pmatch-table before a new operation,
+ * so that positions of a previous call to fre_exec() are not mistaken
+ * for positions of the current one.
+ */
+void intern__fre__reset_pmatch_table(void)
+{
+  fre_pmatch *table = fre_pmatch_table;
+
+  intern__fre__init_smatch(table->whole_match,
+			   ((table->wm_ind < table->wm_size) ? table->wm_ind + 1 : table->wm_size));
+  intern__fre__init_smatch(table->sub_match,
+			   ((table->sm_ind < table->sm_size) ? table->sm_ind + 1 : table->sm_size));
+  table->wm_ind = 0;
+  table->sm_ind = 0;
+  table->subm_per_match = 0;
+  table->lastop_retval = 0;
+  table->tr_count = 0;
+  table->tr_has_result = false;
+  table->result_len = 0;
+
+} /* intern__fre__reset_pmatch_table() */
+
+
+
 /*
  * Initialize a fre_pattern, a structure containing about all
  * the information needed to complete the pattern's requested operation. 
@@ -454,19 +582,32 @@ fre_pattern* intern__fre__init_pattern(void)
   freg_object->fre_mod_ext = false;
   freg_object->fre_mod_global = false;
   freg_object->fre_mod_sub_is_regex = false;
+  freg_object->fre_mod_tr_complement = false;
+  freg_object->fre_mod_tr_delete = false;
+  freg_object->fre_mod_tr_squeeze = false;
+  freg_object->fre_mod_tr_return = false;
   freg_object->fre_p1_compiled = false;
-  freg_object->fre_not_boundary = false;
-  freg_object->fre_match_op_bow = false;
-  freg_object->fre_match_op_eow = false;
-  freg_object->fre_subs_op_bow = false;
-  freg_object->fre_subs_op_eow = false;
   freg_object->fre_paired_delimiters = false;
   freg_object->delimiter = '\0';
   freg_object->c_delimiter = '\0';
   freg_object->fre_op_flag = NONE;
   freg_object->fre_match_op_bref = false;
   freg_object->fre_subs_op_bref = false;
-  freg_object->bref_to_insert = 0;
+  freg_object->shared_entry = NULL;
+  freg_object->replacement = NULL;
+  freg_object->translit = NULL;
+  freg_object->engine = FRE_ENGINE_REGEX;
+  freg_object->numof_groups = 0;
+  freg_object->prog = NULL;
+  freg_object->rev_prog = NULL;
+  freg_object->dfa = NULL;
+  freg_object->rev_dfa = NULL;
+  freg_object->literal = NULL;
+  freg_object->ac = NULL;
+  freg_object->bt = NULL;
+  freg_object->pike = NULL;
+  freg_object->bitpar = NULL;
+  freg_object->jit = NULL;
   /* All set. */
   return freg_object;
 
@@ -508,6 +649,140 @@ fre_pattern* intern__fre__init_pattern(void)
 } /* intern__fre__init_pattern() */
 
 
+/*
+ * Copy a parsed fre_pattern so that a thread may execute it on its own.
+ * The clone gets its own copy of everything an operation modifies,
+ * including its own regex_t: glibc's regexec() serializes concurrent
+ * callers of a same compiled pattern.
+ */
+fre_pattern* intern__fre__clone_pattern(fre_pattern *freg_object)
+{
+  size_t i = 0;
+  fre_pattern *clone = NULL;
+  fre_backref *backref_pos = NULL;
+  regex_t *comp_pattern = NULL;
+  char **striped_pattern = NULL, **saved_pattern = NULL;
+
+  if (freg_object == NULL){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((clone = intern__fre__init_pattern()) == NULL){
+    intern__fre__errmesg("Intern__fre__init_pattern");
+    return NULL;
+  }
+  /* Copy every flag, keeping the clone's own buffers. */
+  backref_pos = clone->backref_pos;
+  comp_pattern = clone->comp_pattern;
+  striped_pattern = clone->striped_pattern;
+  saved_pattern = clone->saved_pattern;
+  *clone = *freg_object;
+  clone->backref_pos = backref_pos;
+  clone->comp_pattern = comp_pattern;
+  clone->striped_pattern = striped_pattern;
+  clone->saved_pattern = saved_pattern;
+  clone->fre_p1_compiled = false;
+  clone->shared_entry = NULL;
+  clone->prog = clone->rev_prog = NULL;
+  clone->dfa = clone->rev_dfa = NULL;
+  clone->literal = NULL;
+  clone->ac = NULL;
+  clone->bt = NULL;
+  clone->pike = NULL;
+  clone->bitpar = NULL;
+  clone->jit = NULL;
+  clone->replacement = NULL;
+  if (freg_object->replacement != NULL
+      && (clone->replacement = intern__fre__clone_replacement(freg_object->replacement)) == NULL){
+    intern__fre__errmesg("_clone_replacement");
+    intern__fre__free_pattern(clone);
+    return NULL;
+  }
+  if (freg_object->literal != NULL){
+    if ((clone->literal = malloc(sizeof(fre_literal))) == NULL){
+      intern__fre__errmesg("Malloc");
+      intern__fre__free_pattern(clone);
+      return NULL;
+    }
+    *clone->literal = *freg_object->literal;
+  }
+  if (freg_object->ac != NULL
+      && (clone->ac = intern__fre__clone_ac(freg_object->ac)) == NULL){
+    intern__fre__errmesg("_clone_ac");
+    intern__fre__free_pattern(clone);
+    return NULL;
+  }
+  clone->translit = NULL;
+  if (freg_object->translit != NULL){
+    if ((clone->translit = malloc(sizeof(fre_translit))) == NULL){
+      intern__fre__errmesg("Malloc");
+      intern__fre__free_pattern(clone);
+      return NULL;
+    }
+    *clone->translit = *freg_object->translit;
+  }
+
+  memcpy(backref_pos->in_pattern, freg_object->backref_pos->in_pattern, FRE_MAX_SUB_MATCHES * sizeof(int));
+  memcpy(backref_pos->p_sm_number, freg_object->backref_pos->p_sm_number, FRE_MAX_SUB_MATCHES * sizeof(long));
+  memcpy(backref_pos->in_substitute, freg_object->backref_pos->in_substitute, FRE_MAX_SUB_MATCHES * sizeof(int));
+  memcpy(backref_pos->s_sm_number, freg_object->backref_pos->s_sm_number, FRE_MAX_SUB_MATCHES * sizeof(long));
+  backref_pos->in_pattern_c = freg_object->backref_pos->in_pattern_c;
+  backref_pos->in_substitute_c = freg_object->backref_pos->in_substitute_c;
+  for (i = 0; i < 2; i++){
+    memcpy(striped_pattern[i], freg_object->striped_pattern[i], FRE_MAX_PATTERN_LENGHT);
+    memcpy(saved_pattern[i], freg_object->saved_pattern[i], FRE_MAX_PATTERN_LENGHT);
+  }
+  if (freg_object->engine == FRE_ENGINE_DFA){
+    if ((clone->prog = intern__fre__clone_prog(freg_object->prog)) == NULL
+	|| (clone->rev_prog = intern__fre__clone_prog(freg_object->rev_prog)) == NULL
+	|| (clone->dfa = intern__fre__clone_dfa(freg_object->dfa, clone->prog)) == NULL
+	|| (clone->rev_dfa = intern__fre__clone_dfa(freg_object->rev_dfa, clone->rev_prog)) == NULL){
+      intern__fre__errmesg("_clone_dfa");
+      intern__fre__free_pattern(clone);
+      return NULL;
+    }
+    if (freg_object->pike != NULL
+	&& (clone->pike = intern__fre__clone_pike(freg_object->pike, clone->prog)) == NULL){
+      intern__fre__errmesg("_clone_pike");
+      intern__fre__free_pattern(clone);
+      return NULL;
+    }
+    if (freg_object->bitpar != NULL
+	&& (clone->bitpar = intern__fre__clone_bitpar(freg_object->bitpar)) == NULL){
+      intern__fre__errmesg("_clone_bitpar");
+      intern__fre__free_pattern(clone);
+      return NULL;
+    }
+    /* Native code runs the same from anywhere. */
+    if (freg_object->jit != NULL
+	&& (clone->jit = intern__fre__clone_jit(freg_object->jit)) == NULL){
+      intern__fre__errmesg("_clone_jit");
+      intern__fre__free_pattern(clone);
+      return NULL;
+    }
+  }
+  if (freg_object->engine == FRE_ENGINE_BACKTRACK){
+    if ((clone->prog = intern__fre__clone_prog(freg_object->prog)) == NULL
+	|| (clone->bt = intern__fre__clone_bt(freg_object->bt, clone->prog)) == NULL){
+      intern__fre__errmesg("_clone_bt");
+      intern__fre__free_pattern(clone);
+      return NULL;
+    }
+  }
+  /* The other engines only fall back on regexec(), compiled on first use. */
+  if (clone->fre_op_flag != TRANSLITERATE && clone->engine == FRE_ENGINE_REGEX){
+    if (intern__fre__compile_pattern(clone) == FRE_ERROR){
+      intern__fre__errmesg("_compile_pattern");
+      intern__fre__free_pattern(clone);
+      return NULL;
+    }
+  }
+
+  return clone;
+
+} /* intern__fre__clone_pattern() */
+
+
 /* Release resources used by a fre_pattern object. */
 void intern__fre__free_pattern(fre_pattern *freg_object)
 {
@@ -515,10 +790,43 @@ void intern__fre__free_pattern(fre_pattern *freg_object)
   /* Return right away if we're passed a NULL object. */
   if (freg_object == NULL)
     return;
+  /* A clone of a shared pattern lets go of its shared entry. */
+  if (freg_object->shared_entry != NULL){
+    intern__fre__shared_release(freg_object->shared_entry);
+    freg_object->shared_entry = NULL;
+  }
   if (freg_object->backref_pos != NULL){
     intern__fre__free_bref_arr(freg_object->backref_pos);
     freg_object->backref_pos = NULL;
   }
+  if (freg_object->replacement != NULL){
+    intern__fre__free_replacement(freg_object->replacement);
+    freg_object->replacement = NULL;
+  }
+  if (freg_object->translit != NULL){
+    free(freg_object->translit);
+    freg_object->translit = NULL;
+  }
+  if (freg_object->literal != NULL){
+    free(freg_object->literal);
+    freg_object->literal = NULL;
+  }
+  intern__fre__free_ac(freg_object->ac);
+  freg_object->ac = NULL;
+  intern__fre__free_bt(freg_object->bt);
+  freg_object->bt = NULL;
+  intern__fre__free_pike(freg_object->pike);
+  freg_object->pike = NULL;
+  intern__fre__free_bitpar(freg_object->bitpar);
+  freg_object->bitpar = NULL;
+  intern__fre__free_jit(freg_object->jit);
+  freg_object->jit = NULL;
+  intern__fre__free_dfa(freg_object->dfa);
+  intern__fre__free_dfa(freg_object->rev_dfa);
+  intern__fre__free_prog(freg_object->prog);
+  intern__fre__free_prog(freg_object->rev_prog);
+  freg_object->dfa = freg_object->rev_dfa = NULL;
+  freg_object->prog = freg_object->rev_prog = NULL;
   /* Check if fre_p1_compiled is true, if yes regfree the pattern first. */
   if (freg_object->comp_pattern != NULL){
     if (freg_object->fre_p1_compiled == true){
@@ -552,3 +860,78 @@ void intern__fre__free_pattern(fre_pattern *freg_object)
 
   return;
 }
+
+
+/*
+ * Allocate memory for a compiled substitute pattern
+ * made out of at most numof_tokens characters.
+ */
+fre_replacement* intern__fre__init_replacement(size_t numof_tokens)
+{
+  fre_replacement *repl = NULL;
+
+  if ((repl = malloc(sizeof(fre_replacement))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return NULL;
+  }
+  repl->segs = NULL;
+  repl->literals = NULL;
+  repl->segs_c = 0;
+  repl->literals_len = 0;
+  /* Each token makes at most one segment, +1 so that empty patterns still get memory. */
+  if ((repl->segs = malloc((numof_tokens + 1) * sizeof(fre_repl_seg))) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  if ((repl->literals = calloc(numof_tokens + 1, sizeof(char))) == NULL){
+    intern__fre__errmesg("Calloc");
+    goto errjmp;
+  }
+  return repl;
+
+ errjmp:
+  intern__fre__free_replacement(repl);
+  return NULL;
+
+} /* intern__fre__init_replacement() */
+
+
+/* Copy a compiled substitute pattern. */
+fre_replacement* intern__fre__clone_replacement(fre_replacement *repl)
+{
+  fre_replacement *clone = NULL;
+
+  if (repl == NULL){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((clone = intern__fre__init_replacement((repl->segs_c > repl->literals_len) ?
+					     repl->segs_c : repl->literals_len)) == NULL){
+    intern__fre__errmesg("_init_replacement");
+    return NULL;
+  }
+  memcpy(clone->segs, repl->segs, repl->segs_c * sizeof(fre_repl_seg));
+  memcpy(clone->literals, repl->literals, repl->literals_len);
+  clone->segs_c = repl->segs_c;
+  clone->literals_len = repl->literals_len;
+  return clone;
+
+} /* intern__fre__clone_replacement() */
+
+
+/* Release a compiled substitute pattern. */
+void intern__fre__free_replacement(fre_replacement *repl)
+{
+  if (repl == NULL)
+    return;
+  if (repl->segs != NULL){
+    free(repl->segs);
+    repl->segs = NULL;
+  }
+  if (repl->literals != NULL){
+    free(repl->literals);
+    repl->literals = NULL;
+  }
+  free(repl);
+
+} /* intern__fre__free_replacement() */
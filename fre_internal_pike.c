@@ -0,0 +1,261 @@
+/*
+ *
+ *  Libfre  -  Pike VM, sub-matches in linear time.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+#define FRE_SET_HAS(set, byte) ((set)[(byte) >> 3] & (1u << ((byte) & 7)))
+
+/* Context of the byte at string[pos], FRE_CTX_EDGE outside of string. */
+#define FRE_PIKE_CTX(prog, string, string_len, pos)			\
+  (((pos) < 0 || (size_t)(pos) >= (string_len)) ? FRE_CTX_EDGE		\
+   : (prog)->class_ctx[(prog)->byte_class[(string)[(pos)]]])
+
+
+/* Prepare the Pike VM of a program, sized once for all scans. */
+fre_pike* intern__fre__pike_build(fre_prog *prog)
+{
+  size_t i = 0;
+  fre_pike *pike = NULL;
+
+  if (!prog){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((pike = calloc(1, sizeof(fre_pike))) == NULL){
+    intern__fre__errmesg("Calloc");
+    return NULL;
+  }
+  pike->prog = prog;
+  pike->numof_slots = 2 * (prog->numof_groups + 1);
+  for (i = 0; i < 2; i++){
+    if ((pike->lists[i].sparse = calloc(prog->numof_insts, sizeof(int))) == NULL
+	|| (pike->lists[i].dense = malloc(prog->numof_insts * sizeof(int))) == NULL
+	|| (pike->lists[i].caps = malloc(prog->numof_insts * pike->numof_slots * sizeof(fre_off))) == NULL){
+      intern__fre__errmesg("Malloc");
+      intern__fre__free_pike(pike);
+      return NULL;
+    }
+  }
+  if ((pike->caps = malloc(pike->numof_slots * sizeof(fre_off))) == NULL
+      || (pike->best = malloc(pike->numof_slots * sizeof(fre_off))) == NULL
+      || (pike->jobs = malloc((prog->numof_insts + 1) * sizeof(fre_pike_job))) == NULL){
+    intern__fre__errmesg("Malloc");
+    intern__fre__free_pike(pike);
+    return NULL;
+  }
+  return pike;
+
+} /* intern__fre__pike_build() */
+
+
+/* A Pike VM like pike, for the given copy of its program. */
+fre_pike* intern__fre__clone_pike(fre_pike *pike,
+				  fre_prog *prog)
+{
+  if (!pike || !prog){
+    errno = EINVAL;
+    return NULL;
+  }
+  return intern__fre__pike_build(prog);
+
+} /* intern__fre__clone_pike() */
+
+
+/* Release a Pike VM. */
+void intern__fre__free_pike(fre_pike *pike)
+{
+  size_t i = 0;
+
+  if (pike == NULL)
+    return;
+  for (i = 0; i < 2; i++){
+    if (pike->lists[i].sparse != NULL)
+      free(pike->lists[i].sparse);
+    if (pike->lists[i].dense != NULL)
+      free(pike->lists[i].dense);
+    if (pike->lists[i].caps != NULL)
+      free(pike->lists[i].caps);
+  }
+  if (pike->caps != NULL)
+    free(pike->caps);
+  if (pike->best != NULL)
+    free(pike->best);
+  if (pike->jobs != NULL)
+    free(pike->jobs);
+  free(pike);
+
+} /* intern__fre__free_pike() */
+
+
+/*
+ * Follow a thread at pc through every instruction not consuming a byte,
+ * in the order a backtracking matcher would, adding the instructions it
+ * reaches to list. caps are its capture slots, NULL for a new thread.
+ * Keeps the match it may reach in ->best when it's better than *found's.
+ */
+static void intern__fre__pike_follow(fre_pike *pike,
+				     fre_pike_list *list,
+				     int pc,
+				     fre_off pos,
+				     const fre_off *caps,
+				     int prev_ctx,
+				     int next_ctx,
+				     bool *found)
+{
+  size_t sp = 0, i = 0;
+  fre_pike_job job;
+  const fre_inst *inst = NULL;
+
+  if (caps == NULL)
+    for (i = 0; i < pike->numof_slots; i++)
+      pike->caps[i] = -1;
+  else
+    memcpy(pike->caps, caps, pike->numof_slots * sizeof(fre_off));
+  pike->jobs[sp].pc = pc;
+  ++sp;
+  while (sp > 0){
+    job = pike->jobs[--sp];
+    if (job.pc < 0){
+      pike->caps[job.slot] = job.value;
+      continue;
+    }
+    pc = job.pc;
+    while (1){
+      /* Taken by a thread of higher priority. */
+      if ((size_t)list->sparse[pc] < list->numof_threads && list->dense[list->sparse[pc]] == pc)
+	break;
+      list->sparse[pc] = (int)list->numof_threads;
+      list->dense[list->numof_threads++] = pc;
+      inst = &pike->prog->insts[pc];
+      switch (inst->op){
+      case FRE_I_BYTES:
+	memcpy(list->caps + (size_t)list->sparse[pc] * pike->numof_slots, pike->caps,
+	       pike->numof_slots * sizeof(fre_off));
+	break;
+      case FRE_I_SPLIT:
+	pike->jobs[sp].pc = inst->out1;
+	++sp;
+	pc = inst->out;
+	continue;
+      case FRE_I_ASSERT:
+	if (intern__fre__assert_holds(inst->arg, prev_ctx, next_ctx)){
+	  pc = inst->out;
+	  continue;
+	}
+	break;
+      case FRE_I_SAVE:
+	pike->jobs[sp].pc = -1;
+	pike->jobs[sp].slot = inst->arg;
+	pike->jobs[sp].value = pike->caps[inst->arg];
+	++sp;
+	pike->caps[inst->arg] = pos;
+	pc = inst->out;
+	continue;
+      case FRE_I_MATCH:
+	/* Leftmost first, then longest, the first thread getting there keeps it. */
+	if (!*found || pike->caps[0] < pike->best[0]
+	    || (pike->caps[0] == pike->best[0] && pike->caps[1] > pike->best[1])){
+	  memcpy(pike->best, pike->caps, pike->numof_slots * sizeof(fre_off));
+	  *found = true;
+	}
+	break;
+      case FRE_I_BREF:
+	/* Programs with back-references go to the backtracker. */
+	break;
+      }
+      break;
+    }
+  }
+
+} /* intern__fre__pike_follow() */
+
+
+/*
+ * Find the leftmost-longest match in string[start..stop], only at start when anchored,
+ * and the sub-matches of the first path, in a backtracking matcher's order,
+ * reaching its end. The bytes past stop are only looked at by assertions.
+ * Each byte is looked at once by at most one thread per instruction,
+ * in O((stop - start) * numof_insts) time.
+ */
+int intern__fre__pike_exec(fre_pike *pike,
+			   const unsigned char *string,
+			   size_t string_len,
+			   size_t start,
+			   size_t stop,
+			   bool anchored,
+			   fre_smatch *match_arr,
+			   size_t numof_sm)
+{
+  size_t i = 0, pos = 0;
+  bool found = false;
+  const fre_off *caps = NULL;
+  const fre_inst *inst = NULL;
+  fre_prog *prog = NULL;
+  fre_pike_list *clist = NULL, *nlist = NULL, *temp = NULL;
+
+  if (!pike || !string || !match_arr || start > stop || stop > string_len || numof_sm == 0){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  if (string_len >= FRE_ARG_STRING_MAX_LENGHT){
+    errno = EOVERFLOW;
+    return FRE_ERROR;
+  }
+  prog = pike->prog;
+  clist = &pike->lists[0];
+  nlist = &pike->lists[1];
+  clist->numof_threads = 0;
+
+  for (pos = start; ; pos++){
+    /* A new thread at each position, of lowest priority, until a match begins. */
+    if (!found && (pos == start || !anchored))
+      intern__fre__pike_follow(pike, clist, prog->start, (fre_off)pos, NULL,
+			       FRE_PIKE_CTX(prog, string, string_len, (long)pos - 1),
+			       FRE_PIKE_CTX(prog, string, string_len, (long)pos), &found);
+    if (pos == stop || (clist->numof_threads == 0 && (found || anchored)))
+      break;
+    nlist->numof_threads = 0;
+    for (i = 0; i < clist->numof_threads; i++){
+      inst = &prog->insts[clist->dense[i]];
+      if (inst->op != FRE_I_BYTES || !FRE_SET_HAS(prog->sets[inst->arg], string[pos]))
+	continue;
+      caps = clist->caps + i * pike->numof_slots;
+      /* Threads begining after the match found can't do better. */
+      if (found && caps[0] > pike->best[0])
+	continue;
+      intern__fre__pike_follow(pike, nlist, inst->out, (fre_off)pos + 1, caps,
+			       FRE_PIKE_CTX(prog, string, string_len, (long)pos),
+			       FRE_PIKE_CTX(prog, string, string_len, (long)pos + 1), &found);
+    }
+    temp = clist;
+    clist = nlist;
+    nlist = temp;
+  }
+  if (!found)
+    return FRE_OP_UNSUCCESSFUL;
+
+  for (i = 0; i < numof_sm; i++){
+    if (2 * i + 1 < pike->numof_slots && pike->best[2 * i] >= 0 && pike->best[2 * i + 1] >= 0){
+      match_arr[i].bo = pike->best[2 * i];
+      match_arr[i].eo = pike->best[2 * i + 1];
+    }
+    else
+      match_arr[i].bo = match_arr[i].eo = -1;
+  }
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__pike_exec() */
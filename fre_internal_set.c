@@ -0,0 +1,199 @@
+/*
+ *
+ *  Libfre  -  Pattern sets.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+/*
+ * Parse and compile the given matching patterns as one set.
+ * The patterns a DFA can run are put side by side in a single program
+ * and found in one scan of the string, the others are left to exec_match().
+ */
+fre_patset* intern__fre__set_compile(char **patterns,
+				     size_t numof_patterns)
+{
+  size_t i = 0;
+  int ret = 0;
+  int *ids = NULL;
+  fre_prog **progs = NULL;
+  fre_ast_tree *tree = NULL;
+  fre_pattern *freg_object = NULL;
+  fre_patset *set = NULL;
+
+  if (!patterns || numof_patterns == 0 || numof_patterns > INT32_MAX){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((set = calloc(1, sizeof(fre_patset))) == NULL){
+    intern__fre__errmesg("Calloc");
+    return NULL;
+  }
+  if ((set->patterns = calloc(numof_patterns, sizeof(fre_pattern*))) == NULL
+      || (set->combined = calloc(numof_patterns, sizeof(bool))) == NULL
+      || (set->found = malloc(numof_patterns * sizeof(fre_smatch))) == NULL
+      || (progs = calloc(numof_patterns, sizeof(fre_prog*))) == NULL
+      || (ids = malloc(numof_patterns * sizeof(int))) == NULL){
+    intern__fre__errmesg("Calloc");
+    goto errjmp;
+  }
+  set->numof_patterns = numof_patterns;
+
+  for (i = 0; i < numof_patterns; i++){
+    if (!patterns[i]){
+      errno = EINVAL;
+      goto errjmp;
+    }
+    if (patterns[i][strnlen(patterns[i], FRE_MAX_PATTERN_LENGHT)] != '\0'){
+      errno = FRE_PATRNTOOLONG;
+      goto errjmp;
+    }
+    if ((set->patterns[i] = intern__fre__plp_parser(patterns[i])) == NULL){
+      intern__fre__errmesg("_plp_parser");
+      goto errjmp;
+    }
+    freg_object = set->patterns[i];
+    /* A set only tells which patterns match. */
+    if (freg_object->fre_op_flag != MATCH || freg_object->fre_match_op_bref == true){
+      errno = EINVAL;
+      goto errjmp;
+    }
+    if (MB_CUR_MAX != 1)
+      continue;
+    if ((ret = intern__fre__parse_ere(freg_object->striped_pattern[0],
+				      freg_object->fre_mod_icase,
+				      !freg_object->fre_mod_newline, &tree)) == FRE_ERROR)
+      goto errjmp;
+    else if (ret == FRE_OP_UNSUCCESSFUL){
+      errno = 0;
+      continue;
+    }
+    progs[set->numof_combined] = intern__fre__compile_prog(tree, false);
+    intern__fre__free_ast(tree);
+    tree = NULL;
+    if (progs[set->numof_combined] == NULL){
+      errno = 0;
+      continue;
+    }
+    ids[set->numof_combined++] = (int)i;
+    set->combined[i] = true;
+  }
+
+  /* Too many states for a single program: every pattern runs on its own. */
+  if (set->numof_combined > 0
+      && ((set->prog = intern__fre__combine_progs(progs, ids, set->numof_combined)) == NULL
+	  || (set->dfa = intern__fre__set_dfa_build(set->prog)) == NULL)){
+    errno = 0;
+    intern__fre__free_prog(set->prog);
+    set->prog = NULL;
+    memset(set->combined, 0, numof_patterns * sizeof(bool));
+    set->numof_combined = 0;
+  }
+  for (i = 0; i < numof_patterns && progs[i] != NULL; i++)
+    intern__fre__free_prog(progs[i]);
+  free(progs);
+  free(ids);
+  return set;
+
+ errjmp:
+  if (progs != NULL){
+    for (i = 0; i < numof_patterns && progs[i] != NULL; i++)
+      intern__fre__free_prog(progs[i]);
+    free(progs);
+  }
+  if (ids != NULL)
+    free(ids);
+  intern__fre__free_set(set);
+  return NULL;
+
+} /* intern__fre__set_compile() */
+
+
+/*
+ * Store in ids, in increasing order, the index of each of the set's patterns
+ * matching string and, when offsets isn't NULL, where their leftmost-longest
+ * match begins and ends at offsets[2*K] and offsets[2*K+1] for the Kth of them.
+ * Returns the number of patterns matching or FRE_ERROR.
+ */
+int intern__fre__set_exec(fre_patset *set,
+			  char *string,
+			  size_t string_len,
+			  size_t *ids,
+			  fre_off *offsets)
+{
+  size_t i = 0, numof_ids = 0;
+  int ret = 0;
+  fre_smatch match;
+
+  if (!set || !string || !ids){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  for (i = 0; i < set->numof_patterns; i++)
+    set->found[i].bo = set->found[i].eo = -1;
+  if (set->numof_combined > 0
+      && intern__fre__set_dfa_exec(set->dfa, (const unsigned char*)string, string_len,
+				   set->found, set->numof_combined) == FRE_ERROR){
+    intern__fre__errmesg("_set_dfa_exec");
+    return FRE_ERROR;
+  }
+
+  for (i = 0; i < set->numof_patterns; i++){
+    if (set->combined[i]){
+      if (set->found[i].eo == -1)
+	continue;
+      if (offsets == NULL){
+	ids[numof_ids++] = i;
+	continue;
+      }
+    }
+    if ((ret = intern__fre__exec_match(set->patterns[i], string, string_len, 0, &match, 1)) == FRE_ERROR){
+      intern__fre__errmesg("_exec_match");
+      return FRE_ERROR;
+    }
+    else if (ret == FRE_OP_UNSUCCESSFUL)
+      continue;
+    if (offsets != NULL){
+      offsets[2 * numof_ids] = match.bo;
+      offsets[2 * numof_ids + 1] = match.eo;
+    }
+    ids[numof_ids++] = i;
+  }
+  return (int)numof_ids;
+
+} /* intern__fre__set_exec() */
+
+
+/* Release a pattern set. */
+void intern__fre__free_set(fre_patset *set)
+{
+  size_t i = 0;
+
+  if (set == NULL)
+    return;
+  if (set->patterns != NULL){
+    for (i = 0; i < set->numof_patterns; i++)
+      if (set->patterns[i] != NULL)
+	intern__fre__free_pattern(set->patterns[i]);
+    free(set->patterns);
+  }
+  if (set->combined != NULL)
+    free(set->combined);
+  if (set->found != NULL)
+    free(set->found);
+  intern__fre__free_dfa(set->dfa);
+  intern__fre__free_prog(set->prog);
+  free(set);
+
+} /* intern__fre__free_set() */
@@ -0,0 +1,240 @@
+/*
+ *
+ *  Libfre  -  Vectorized kernels.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "fre_internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define FRE_HAVE_X86_SIMD
+# include <immintrin.h>
+#endif
+
+int fre_simd_features = 0; /* Set once by intern__fre__simd_init(), from _lib_init(). */
+
+
+/* Find out which of the vectorized kernels the running CPU can execute. */
+void intern__fre__simd_init(void)
+{
+  fre_simd_features = 0;
+#ifdef FRE_HAVE_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2"))
+    fre_simd_features |= FRE_SIMD_SSE2;
+  if (__builtin_cpu_supports("ssse3"))
+    fre_simd_features |= FRE_SIMD_SSSE3;
+#endif
+
+} /* intern__fre__simd_init() */
+
+
+/* Non-zero when byte is part of the transliteration's search list. */
+#define FRE_TR_IN_SET(tr, byte) ((tr)->in_set[(byte) >> 3] & (1u << ((byte) & 7)))
+
+
+/* Scalar transliteration, for the CPUs we have no kernel for and the tail of a string. */
+static size_t intern__fre__translit_map_scalar(unsigned char *dest,
+					       const unsigned char *string,
+					       size_t string_len,
+					       const fre_translit *tr)
+{
+  size_t i = 0, count = 0;
+  for (i = 0; i < string_len; i++){
+    if (FRE_TR_IN_SET(tr, string[i]))
+      ++count;
+    dest[i] = tr->map[string[i]];
+  }
+  return count;
+
+} /* intern__fre__translit_map_scalar() */
+
+
+#ifdef FRE_HAVE_X86_SIMD
+/*
+ * Transliterate 16 bytes at a time.
+ * The low nibble of each byte indexes, through pshufb, the row of the map
+ * selected by its high nibble. Rows left untouched by the pattern are skipped,
+ * so tr/a-z/A-Z/ costs two shuffles per 16 bytes.
+ * Membership to the search list is found the same way, through class_lo/class_hi,
+ * and counted in 16 byte-sized counters folded by psadbw before they can wrap.
+ * When there's nothing to map and dest is string, only the count is done.
+ */
+__attribute__ ((target ("ssse3")))
+static size_t intern__fre__translit_map_ssse3(unsigned char *dest,
+					      const unsigned char *string,
+					      size_t string_len,
+					      const fre_translit *tr)
+{
+  size_t i = 0, count = 0, numof_blocks = 0;
+  int row = 0, numof_rows = 0;
+  bool store = (tr->active_rows != 0 || dest != string);
+  __m128i rows[16];
+  __m128i row_id[16];
+  const __m128i low_mask = _mm_set1_epi8(0x0f);
+  const __m128i high_bit = _mm_set1_epi8((char)0x80);
+  const __m128i class_lo = _mm_loadu_si128((const __m128i*)tr->class_lo);
+  const __m128i class_hi = _mm_loadu_si128((const __m128i*)tr->class_hi);
+  const __m128i bit_of = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128,
+				       1, 2, 4, 8, 16, 32, 64, (char)128);
+  __m128i counters = _mm_setzero_si128();
+
+  for (row = 0; row < 16; row++){
+    if (tr->active_rows & (1u << row)){
+      rows[numof_rows] = _mm_loadu_si128((const __m128i*)(tr->map + (row * 16)));
+      row_id[numof_rows++] = _mm_set1_epi8((char)row);
+    }
+  }
+  for (i = 0; i + 16 <= string_len; i += 16){
+    __m128i in = _mm_loadu_si128((const __m128i*)(string + i));
+    __m128i lo = _mm_and_si128(in, low_mask);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), low_mask);
+    __m128i out = in;
+    /* pshufb yields 0 for indexes with their high bit set, each table covers half the bytes. */
+    __m128i classes = _mm_or_si128(_mm_shuffle_epi8(class_lo, in),
+				   _mm_shuffle_epi8(class_hi, _mm_xor_si128(in, high_bit)));
+    __m128i bits = _mm_shuffle_epi8(bit_of, hi);
+    counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(_mm_and_si128(classes, bits), bits));
+    if (++numof_blocks == 255){
+      __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+      count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_extract_epi16(sums, 4);
+      counters = _mm_setzero_si128();
+      numof_blocks = 0;
+    }
+    if (store){
+      for (row = 0; row < numof_rows; row++){
+	__m128i sel = _mm_cmpeq_epi8(hi, row_id[row]);
+	__m128i rep = _mm_shuffle_epi8(rows[row], lo);
+	out = _mm_or_si128(_mm_andnot_si128(sel, out), _mm_and_si128(sel, rep));
+      }
+      _mm_storeu_si128((__m128i*)(dest + i), out);
+    }
+  }
+  {
+    __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+    count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_extract_epi16(sums, 4);
+  }
+  count += intern__fre__translit_map_scalar(dest + i, string + i, string_len - i, tr);
+  return count;
+
+} /* intern__fre__translit_map_ssse3() */
+#endif /* FRE_HAVE_X86_SIMD */
+
+
+/*
+ * Write to dest each of the string_len first bytes of string replaced by its entry
+ * in the compiled transliteration map, dest may be string itself.
+ * Returns the number of bytes of string found in the search list.
+ */
+size_t intern__fre__translit_map(unsigned char *dest,
+				 const unsigned char *string,
+				 size_t string_len,
+				 const fre_translit *tr)
+{
+#ifdef FRE_HAVE_X86_SIMD
+  if (fre_simd_features & FRE_SIMD_SSSE3)
+    return intern__fre__translit_map_ssse3(dest, string, string_len, tr);
+#endif
+  return intern__fre__translit_map_scalar(dest, string, string_len, tr);
+
+} /* intern__fre__translit_map() */
+
+
+/* Non-zero when the len bytes at string are an occurrence of the literal. */
+static bool intern__fre__literal_at(const unsigned char *string,
+				    const fre_literal *lit)
+{
+  size_t i = 0;
+  for (i = 0; i < lit->len; i++)
+    if (string[i] != lit->bytes[i] && string[i] != lit->alt[i])
+      return false;
+  return true;
+
+} /* intern__fre__literal_at() */
+
+
+/* Scalar literal search, for the CPUs we have no kernel for and the tail of a string. */
+static const unsigned char* intern__fre__find_literal_scalar(const unsigned char *string,
+							     size_t string_len,
+							     const fre_literal *lit)
+{
+  size_t i = 0;
+  const unsigned char *temp = NULL;
+
+  /* memchr() is vectorized by the C library already. */
+  if (lit->bytes[0] == lit->alt[0]){
+    while (i + lit->len <= string_len
+	   && (temp = memchr(string + i, lit->bytes[0], string_len - lit->len + 1 - i)) != NULL){
+      if (intern__fre__literal_at(temp, lit))
+	return temp;
+      i = (size_t)(temp - string) + 1;
+    }
+    return NULL;
+  }
+  for (i = 0; i + lit->len <= string_len; i++)
+    if (intern__fre__literal_at(string + i, lit))
+      return string + i;
+  return NULL;
+
+} /* intern__fre__find_literal_scalar() */
+
+
+#ifdef FRE_HAVE_X86_SIMD
+/*
+ * Look for the literal 16 positions at a time.
+ * A position is a candidate when both the first and the last byte
+ * of the literal are found where they should, only candidates are compared
+ * byte by byte, which makes false positives rare even with common first bytes.
+ */
+__attribute__ ((target ("sse2")))
+static const unsigned char* intern__fre__find_literal_sse2(const unsigned char *string,
+							   size_t string_len,
+							   const fre_literal *lit)
+{
+  size_t i = 0, last = lit->len - 1;
+  unsigned int mask = 0;
+  const __m128i first_b = _mm_set1_epi8((char)lit->bytes[0]);
+  const __m128i first_a = _mm_set1_epi8((char)lit->alt[0]);
+  const __m128i last_b = _mm_set1_epi8((char)lit->bytes[last]);
+  const __m128i last_a = _mm_set1_epi8((char)lit->alt[last]);
+
+  for (i = 0; i + last + 16 <= string_len; i += 16){
+    __m128i head = _mm_loadu_si128((const __m128i*)(string + i));
+    __m128i tail = _mm_loadu_si128((const __m128i*)(string + i + last));
+    __m128i hits = _mm_and_si128(_mm_or_si128(_mm_cmpeq_epi8(head, first_b), _mm_cmpeq_epi8(head, first_a)),
+				 _mm_or_si128(_mm_cmpeq_epi8(tail, last_b), _mm_cmpeq_epi8(tail, last_a)));
+    mask = (unsigned int)_mm_movemask_epi8(hits);
+    while (mask != 0){
+      size_t at = i + (size_t)__builtin_ctz(mask);
+      if (intern__fre__literal_at(string + at, lit))
+	return string + at;
+      mask &= mask - 1;
+    }
+  }
+  if (i >= string_len)
+    return NULL;
+  return intern__fre__find_literal_scalar(string + i, string_len - i, lit);
+
+} /* intern__fre__find_literal_sse2() */
+#endif /* FRE_HAVE_X86_SIMD */
+
+
+/* First occurrence of a literal in the string_len first bytes of string, or NULL. */
+const unsigned char* intern__fre__find_literal(const unsigned char *string,
+					       size_t string_len,
+					       const fre_literal *lit)
+{
+#ifdef FRE_HAVE_X86_SIMD
+  if ((fre_simd_features & FRE_SIMD_SSE2) && !(lit->len == 1 && lit->bytes[0] == lit->alt[0]))
+    return intern__fre__find_literal_sse2(string, string_len, lit);
+#endif
+  return intern__fre__find_literal_scalar(string, string_len, lit);
+
+} /* intern__fre__find_literal() */
@@ -0,0 +1,247 @@
+/*
+ *
+ *  Libfre  -  Streams, texts searched a window at a time.
+ *  Version:   0.600
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "fre_internal.h"
+#include "fre_internal_macros.h"
+#include "fre_internal_errcodes.h"
+
+
+/*
+ * Prepare a matching pattern to search a text a window at a time, telling
+ * how the matches found in a window can be known to be those of the whole text.
+ * Patterns whose matches have no bound and may hold a newline are searched
+ * over the whole text at once when whole, else taken to be no longer than window.
+ */
+void intern__fre__scan_init(fre_scan *scan,
+			    fre_pattern *freg_object,
+			    bool whole,
+			    size_t window,
+			    fre_match_callback callback,
+			    void *arg)
+{
+  ssize_t max_len = intern__fre__max_match_len(freg_object);
+
+  memset(scan, 0, sizeof(fre_scan));
+  scan->pattern = freg_object;
+  scan->callback = callback;
+  scan->arg = arg;
+  if (max_len >= 0 && (size_t)max_len < window / 2){
+    scan->mode = FRE_SCAN_BOUNDED;
+    scan->max_len = (size_t)max_len;
+  }
+  else if (!intern__fre__matches_byte(freg_object, '\n'))
+    scan->mode = FRE_SCAN_BY_LINE;
+  else if (whole)
+    scan->mode = FRE_SCAN_WHOLE;
+  else {
+    scan->mode = FRE_SCAN_WINDOW;
+    scan->max_len = window;
+  }
+
+} /* intern__fre__scan_init() */
+
+
+/*
+ * Search string from *start, the text read so far, all of it when at_end,
+ * and hand the matches known to be final to the callback. *start is left
+ * where a match could still begin, once more of the text is read:
+ *  - no match is longer than max_len, a match begining more than max_len
+ *    bytes before the end of the string can't go on past it, nor can an
+ *    earlier one begin after it.
+ *  - no match holds a newline, the string is only searched up to its
+ *    last newline, the matches begining before it end before it.
+ * Assertions judge the end of the string to be the end of the text, a match
+ * they would let end there isn't final either, nor is one running up to it,
+ * longer than a window it was taken to fit in.
+ */
+int intern__fre__scan(fre_scan *scan,
+		      const char *string,
+		      size_t string_len,
+		      bool at_end,
+		      size_t *start)
+{
+  int ret = 0;
+  size_t end = 0;
+  fre_smatch match;
+
+  while (*start <= string_len && scan->stopped == false){
+    end = string_len;
+    if (!at_end && scan->mode == FRE_SCAN_BY_LINE){
+      while (end > *start && string[end - 1] != '\n')
+	--end;
+      if (end == *start)
+	return FRE_OP_SUCCESSFUL;
+    }
+    if ((ret = intern__fre__exec_match(scan->pattern, (char*)string, end, *start, &match, 1)) == FRE_ERROR){
+      intern__fre__errmesg("_exec_match");
+      return FRE_ERROR;
+    }
+    if (!at_end
+	&& (ret == FRE_OP_UNSUCCESSFUL
+	    || (size_t)match.eo >= end
+	    || (scan->mode == FRE_SCAN_BY_LINE && (size_t)match.bo >= end)
+	    || (scan->mode != FRE_SCAN_BY_LINE && (size_t)match.bo + scan->max_len >= end))){
+      if (scan->mode == FRE_SCAN_BY_LINE)
+	*start = end;
+      else if (end > *start + scan->max_len)
+	*start = end - scan->max_len - 1;
+      return FRE_OP_SUCCESSFUL;
+    }
+    if (ret == FRE_OP_UNSUCCESSFUL)
+      break;
+    ++scan->numof_matches;
+    if (scan->callback(scan->base + match.bo, scan->base + match.eo, scan->arg) != 0
+	|| scan->pattern->fre_mod_global == false)
+      scan->stopped = true;
+    *start = (size_t)match.eo;
+    if (match.eo == match.bo)
+      ++*start;
+  }
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__scan() */
+
+
+/*
+ * Bind a matching pattern to a text fed a chunk at a time.
+ * window is the most bytes the stream keeps when the pattern's matches have no
+ * bound, 0 for FRE_STREAM_WINDOW: longer matches are cut, or missed.
+ */
+fre_patstream* intern__fre__stream_new(fre_pattern *freg_object,
+				       size_t window,
+				       fre_match_callback callback,
+				       void *arg)
+{
+  fre_patstream *stream = NULL;
+
+  if (!freg_object || !callback || freg_object->fre_op_flag != MATCH){
+    errno = EINVAL;
+    return NULL;
+  }
+  if ((stream = calloc(1, sizeof(fre_patstream))) == NULL){
+    intern__fre__errmesg("Calloc");
+    return NULL;
+  }
+  stream->window = ((window == 0) ? FRE_STREAM_WINDOW : window);
+  intern__fre__scan_init(&stream->scan, freg_object, false, stream->window, callback, arg);
+  return stream;
+
+} /* intern__fre__stream_new() */
+
+
+/*
+ * Search the next chunk of a stream, along with the bytes kept from the previous
+ * ones a match could still begin at. Only those are kept once it's done,
+ * no more than the pattern's longest match, or than the window.
+ * Returns FRE_OP_SUCCESSFUL when matches were handed to the callback.
+ */
+int intern__fre__stream_feed(fre_patstream *stream,
+			     const char *buf,
+			     size_t len)
+{
+  int ret = 0;
+  size_t numof_matches = 0, keep = 0, size = 0;
+  char *temp = NULL;
+
+  if (!stream || (!buf && len > 0) || stream->finished){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  if (stream->scan.stopped)
+    return FRE_OP_UNSUCCESSFUL;
+  if (len >= FRE_ARG_STRING_MAX_LENGHT - stream->len){
+    errno = EOVERFLOW;
+    return FRE_ERROR;
+  }
+  /* Kept NUL-terminated, for what reads strings up to their NUL. */
+  if (stream->buffer == NULL || stream->len + len >= stream->size){
+    size = ((stream->size > 0) ? stream->size : 4096);
+    while (size <= stream->len + len)
+      size *= 2;
+    if ((temp = realloc(stream->buffer, size)) == NULL){
+      intern__fre__errmesg("Realloc");
+      return FRE_ERROR;
+    }
+    stream->buffer = temp;
+    stream->size = size;
+  }
+  if (len > 0)
+    memcpy(stream->buffer + stream->len, buf, len);
+  stream->len += len;
+  stream->buffer[stream->len] = '\0';
+
+  numof_matches = stream->scan.numof_matches;
+  if (intern__fre__scan(&stream->scan, stream->buffer, stream->len, false, &stream->start) == FRE_ERROR)
+    return FRE_ERROR;
+  /*
+   * A line longer than the window is cut, what it drops is searched first
+   * as it would be with FRE_SCAN_WINDOW.
+   */
+  if (stream->scan.mode == FRE_SCAN_BY_LINE && stream->len - stream->start > stream->window){
+    stream->scan.mode = FRE_SCAN_WINDOW;
+    stream->scan.max_len = stream->window;
+    ret = intern__fre__scan(&stream->scan, stream->buffer, stream->len, false, &stream->start);
+    stream->scan.mode = FRE_SCAN_BY_LINE;
+    stream->scan.max_len = 0;
+    if (ret == FRE_ERROR)
+      return FRE_ERROR;
+  }
+  keep = ((stream->start > 0) ? stream->start - 1 : 0);
+  if (keep > stream->len)
+    keep = stream->len;
+  memmove(stream->buffer, stream->buffer + keep, stream->len - keep);
+  stream->len -= keep;
+  stream->start -= keep;
+  stream->buffer[stream->len] = '\0';
+  stream->scan.base += (fre_off)keep;
+
+  return ((stream->scan.numof_matches > numof_matches) ? FRE_OP_SUCCESSFUL : FRE_OP_UNSUCCESSFUL);
+
+} /* intern__fre__stream_feed() */
+
+
+/*
+ * Search what a stream kept as the end of its text, the matches it holds
+ * are final now. No more chunks may be fed to it.
+ */
+int intern__fre__stream_finish(fre_patstream *stream)
+{
+  size_t numof_matches = 0;
+
+  if (!stream || stream->finished){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  stream->finished = true;
+  if (stream->scan.stopped)
+    return FRE_OP_UNSUCCESSFUL;
+  numof_matches = stream->scan.numof_matches;
+  if (intern__fre__scan(&stream->scan, ((stream->buffer != NULL) ? stream->buffer : ""),
+			stream->len, true, &stream->start) == FRE_ERROR)
+    return FRE_ERROR;
+
+  return ((stream->scan.numof_matches > numof_matches) ? FRE_OP_SUCCESSFUL : FRE_OP_UNSUCCESSFUL);
+
+} /* intern__fre__stream_finish() */
+
+
+/* Release a stream, not its pattern. */
+void intern__fre__free_stream(fre_patstream *stream)
+{
+  if (stream == NULL)
+    return;
+  if (stream->buffer != NULL)
+    free(stream->buffer);
+  free(stream);
+
+} /* intern__fre__free_stream() */
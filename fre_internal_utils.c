@@ -65,13 +65,14 @@ int intern__fre__compile_pattern(fre_pattern *freg_object)
 {
   if (regcomp(freg_object->comp_pattern,
 	      freg_object->striped_pattern[0],
-	      (freg_object->fre_mod_icase == true) ? REG_ICASE : 0 |
-	      (freg_object->fre_mod_newline == true) ? 0 : REG_NEWLINE |
+	      ((freg_object->fre_mod_icase == true) ? REG_ICASE : 0) |
+	      ((freg_object->fre_mod_newline == true) ? 0 : REG_NEWLINE) |
 	      REG_EXTENDED) != 0){
     intern__fre__errmesg("Regcomp");
     return FRE_ERROR;
   }
   freg_object->fre_p1_compiled = true;
+  freg_object->numof_groups = freg_object->comp_pattern->re_nsub;
   return FRE_OP_SUCCESSFUL;
 }
 
@@ -128,8 +129,14 @@ int intern__fre__split_pattern(char *pattern,
 	++token_ind;
 	continue;
       }
+      else if (pattern[token_ind+1] == '\\'){
+	/* An escaped backslash, it doesn't escape the token after it. */
+	FRE_PUSH(pattern[token_ind++], freg_object->striped_pattern[spa_ind], &spa_tos);
+	FRE_PUSH(pattern[token_ind++], freg_object->striped_pattern[spa_ind], &spa_tos);
+	continue;
+      }
     }
-    
+
     if (FRE_TOKEN == freg_object->delimiter){
       if (freg_object->fre_paired_delimiters == true){
 	if (delimiter_pairs++ > 0){
@@ -218,11 +225,11 @@ int intern__fre__split_pattern(char *pattern,
  */
 int intern__fre__perl_to_posix(fre_pattern *freg_object,
 			       size_t is_sub){
-  bool   fre_do_not_push = false;     /* When true, tokens aren't pushed to new_pattern. */
   size_t in_bracket_exp = 0;          /* ++ each time we find a '[', -- each time we find  a ']'. */
   size_t in_bracket_count = 0;        /* Some meta-chars must be at a specific position in a bracket expression to be valid. */
   size_t numof_tokens = 0;            /* Used to help register back-reference positions. */
   size_t token_ind = 0;
+  size_t bref_ind = 0;                /* Where the back-reference being handled begins. */
   size_t new_pattern_tos = 0;              /* new_pattern's top of stack. */
   size_t new_pattern_len = strnlen(freg_object->striped_pattern[is_sub], FRE_MAX_PATTERN_LENGHT-1);
   char   new_pattern[FRE_MAX_PATTERN_LENGHT]; /* The array used to build the new pattern. */
@@ -271,7 +278,6 @@ int intern__fre__perl_to_posix(fre_pattern *freg_object,
 	&& (isdigit(freg_object->striped_pattern[is_sub][token_ind +1]))
 	&& in_bracket_exp == 0){
       --numof_tokens;
-      fre_do_not_push = true;
       if (is_sub){
 	/* Conditional expression is useless, numof_tokens == new_pattern_tos when substitute_c == 0 */
 	FRE_HANDLE_BREF(freg_object->striped_pattern[is_sub],
@@ -280,10 +286,15 @@ int intern__fre__perl_to_posix(fre_pattern *freg_object,
 			is_sub, freg_object);
       }
       else{
+	bref_ind = token_ind;
 	FRE_HANDLE_BREF(freg_object->striped_pattern[is_sub],
 			&token_ind,
 			(freg_object->backref_pos->in_pattern_c == 0) ? new_pattern_tos : numof_tokens,
 			is_sub, freg_object);
+	/* The engines match back-references themselves, $N is kept as \N. */
+	FRE_PUSH('\\', new_pattern, &new_pattern_tos);
+	while (++bref_ind < token_ind)
+	  FRE_PUSH(freg_object->striped_pattern[is_sub][bref_ind], new_pattern, &new_pattern_tos);
       }
       numof_tokens = 1;
       continue;
@@ -321,23 +332,15 @@ int intern__fre__perl_to_posix(fre_pattern *freg_object,
     }
     /* Just a regular token. */
     push_token:
-    /*    if (fre_do_not_push == false)*/
     FRE_PUSH(FRE_TOKEN, new_pattern, &new_pattern_tos);
     
     ++token_ind; /* Get next token. */
   }
-  /* 
-   * Copy new_pattern to saved_pattern[] then if do_not_push was set to true, 
-   * NULL terminate new_pattern at the index of the first found backreference and then
-   * copy new_pattern to ->striped_pattern[].
-   */
+  /* Copy new_pattern to saved_pattern[] and ->striped_pattern[]. */
   if (SU_strcpy(freg_object->saved_pattern[is_sub], new_pattern, FRE_MAX_PATTERN_LENGHT) == NULL){
     intern__fre__errmesg("SU_strcpy");
     return FRE_ERROR;
   }
-  if (fre_do_not_push == true && !is_sub){
-    new_pattern[freg_object->backref_pos->in_pattern[0]] = '\0';
-  }
   if (SU_strcpy(freg_object->striped_pattern[is_sub], new_pattern, FRE_MAX_PATTERN_LENGHT) == NULL){
     intern__fre__errmesg("SU_strcpy");
     return FRE_ERROR;
@@ -347,117 +350,345 @@ int intern__fre__perl_to_posix(fre_pattern *freg_object,
 } /* intern__fre__perl_to_posix() */
 
 
-/* Insert sub-match(es) into the given pattern. */
-int intern__fre__insert_sm(fre_pattern *freg_object,      /* The object used throughout the library. */
-			   char *string,                  /* The string to match. */
-			   int numof_tokens,              /* Number of tokens skiped by a global operation. */
-			   size_t is_sub)
+/*
+ * Compile the substitute pattern, as left by _split_pattern(), into a list of
+ * literal runs and sub-match references, once, so that _substitute_op()
+ * only has to copy pieces into its new string.
+ * $N, ${N} and \N refer to the Nth sub-match, $& and $0 to the whole match.
+ * \\ and \$ stand for a literal backslash and dollar sign.
+ */
+int intern__fre__compile_replacement(fre_pattern *freg_object)
 {
-  bool added_bref = false;  /* True the first time we insert a backref. */
-  int string_ind = 0, sp_ind = 0, np_ind = 0, in_array_ind = 0, i = 0;
-  int sm_count = 0, inserted_count = 0;
-  int *in_array = ((!is_sub) ? freg_object->backref_pos->in_pattern : freg_object->backref_pos->in_substitute);
-  int first_elem_pos = in_array[in_array_ind];
-  int next_elem_pos = 0;
-  char new_pattern[FRE_MAX_PATTERN_LENGHT];
-
-  if (!freg_object || !string || is_sub > 1){
+  size_t token_ind = 0;
+  size_t pattern_len = 0;
+  long refnum = 0;
+  char *pattern = NULL;
+  fre_replacement *repl = NULL;
+  fre_repl_seg *seg = NULL;
+
+  if (!freg_object){
     errno = EINVAL;
     return FRE_ERROR;
   }
-  memset(new_pattern, 0, FRE_MAX_PATTERN_LENGHT);
-  while (sp_ind < FRE_MAX_PATTERN_LENGHT) {
-    long subm_ind = ((!is_sub)? freg_object->backref_pos->p_sm_number[sm_count]
-		     : freg_object->backref_pos->s_sm_number[sm_count]);
-    if (in_array[freg_object->bref_to_insert] == -1
-	|| ((first_elem_pos + next_elem_pos == sp_ind) && (added_bref == true))) break;
-    if (freg_object->bref_to_insert != 0)
-      next_elem_pos = in_array[freg_object->bref_to_insert];
-    if (sp_ind == first_elem_pos + next_elem_pos){
-      if (!is_sub) added_bref = true; /* always false for substitute pattern. */
-      /* -1: backref numbers starts at 1, arrays at 0. */
-      for (string_ind = fre_pmatch_table->sub_match[subm_ind-1]->bo - numof_tokens;
-	   string_ind < fre_pmatch_table->sub_match[subm_ind-1]->eo - numof_tokens;
-	   string_ind++){
-	new_pattern[np_ind++] = string[string_ind];
-	++inserted_count;
-      }
-      ++sm_count;     /* Get next sub-match. */
-      /*      ++in_array_ind;  Get next backref position. */
-      ++(freg_object->bref_to_insert);
+  pattern = freg_object->striped_pattern[1];
+  pattern_len = strnlen(pattern, FRE_MAX_PATTERN_LENGHT);
+  if ((repl = intern__fre__init_replacement(pattern_len)) == NULL){
+    intern__fre__errmesg("_init_replacement");
+    return FRE_ERROR;
+  }
+
+#ifdef FRE_TOKEN
+# undef FRE_TOKEN
+#endif
+#define FRE_TOKEN pattern[token_ind]
+
+  while (token_ind < pattern_len){
+    refnum = -1;
+    if ((FRE_TOKEN == '$' || FRE_TOKEN == '\\') && isdigit(pattern[token_ind+1])){
+      ++token_ind;
+      for (refnum = 0; isdigit(FRE_TOKEN); token_ind++)
+	if ((refnum = refnum * 10 + (FRE_TOKEN - '0')) >= FRE_MAX_SUB_MATCHES)
+	  goto invalref;
+    }
+    else if (FRE_TOKEN == '$' && pattern[token_ind+1] == '{'){
+      token_ind += 2;
+      if (!isdigit(FRE_TOKEN))
+	goto invalref;
+      for (refnum = 0; isdigit(FRE_TOKEN); token_ind++)
+	if ((refnum = refnum * 10 + (FRE_TOKEN - '0')) >= FRE_MAX_SUB_MATCHES)
+	  goto invalref;
+      if (FRE_TOKEN != '}')
+	goto invalref;
+      ++token_ind;
+    }
+    else if (FRE_TOKEN == '$' && pattern[token_ind+1] == '&'){
+      refnum = 0;
+      token_ind += 2;
     }
-    else if (freg_object->striped_pattern[is_sub][sp_ind] == '\0'
-	     && sp_ind < (first_elem_pos + next_elem_pos)){
-      ++sp_ind;
+    else if (FRE_TOKEN == '\\' && (pattern[token_ind+1] == '\\' || pattern[token_ind+1] == '$')){
+      ++token_ind;
+    }
+
+    if (refnum != -1){
+      seg = &repl->segs[repl->segs_c++];
+      seg->sm_number = refnum;
+      seg->lit_off = 0;
+      seg->lit_len = 0;
       continue;
     }
-    else new_pattern[np_ind++] = freg_object->striped_pattern[is_sub][sp_ind++];
+    /* A literal character, extend the current literal run or begin a new one. */
+    if (repl->segs_c == 0 || repl->segs[repl->segs_c-1].sm_number != -1){
+      seg = &repl->segs[repl->segs_c++];
+      seg->sm_number = -1;
+      seg->lit_off = repl->literals_len;
+      seg->lit_len = 0;
+    }
+    repl->literals[repl->literals_len++] = FRE_TOKEN;
+    ++(repl->segs[repl->segs_c-1].lit_len);
+    ++token_ind;
   }
-  /* Get ready for the next call to insert_sm(). */
-  freg_object->bref_to_insert = 0;
-  /* Make sure we forget no characters in ->striped_pattern[]. */
-  if (!is_sub)
-    while(freg_object->saved_pattern[is_sub][sp_ind] != '\0')
-      new_pattern[np_ind++] = freg_object->saved_pattern[is_sub][sp_ind++];
-  else
-    while(freg_object->striped_pattern[is_sub][sp_ind] != '\0')
-      new_pattern[np_ind++] = freg_object->striped_pattern[is_sub][sp_ind++];
-  new_pattern[np_ind] = '\0';
-  
-  if (SU_strcpy(freg_object->striped_pattern[is_sub], new_pattern, FRE_MAX_PATTERN_LENGHT) == NULL){
-    intern__fre__errmesg("SU_strcpy");
-    return FRE_ERROR;
+
+  if (freg_object->replacement != NULL)
+    intern__fre__free_replacement(freg_object->replacement);
+  freg_object->replacement = repl;
+  return FRE_OP_SUCCESSFUL;
+
+ invalref:
+  errno = FRE_INVALREPL;
+  intern__fre__free_replacement(repl);
+  return FRE_ERROR;
+
+} /* intern__fre__compile_replacement() */
+
+
+/*
+ * Expand one side of a transliteration pattern into the list of bytes it stands for.
+ * Ranges (a-z) and \d are expanded, a leading or trailing '-' is literal, 
+ * \\ \- \n and \t are escapes. list_out must hold 256 bytes per token of list.
+ */
+static size_t intern__fre__expand_translit(const char *list,
+					   unsigned char *list_out)
+{
+  size_t i = 0, out_len = 0;
+  int low = 0, high = 0, temp = 0;
+  unsigned char token = 0;
+
+  while (list[i] != '\0'){
+    if (list[i] == '\\' && list[i+1] != '\0'){
+      switch (list[i+1]){
+      case 'd':
+	for (temp = '0'; temp <= '9'; temp++)
+	  list_out[out_len++] = (unsigned char)temp;
+	i += 2;
+	continue;
+      case 'n':
+	token = '\n';
+	break;
+      case 't':
+	token = '\t';
+	break;
+      default:
+	token = (unsigned char)list[i+1];
+	break;
+      }
+      i += 2;
+    }
+    else
+      token = (unsigned char)list[i++];
+
+    /* A range, when the '-' is neither the first nor the last token. */
+    if (list[i] == '-' && list[i+1] != '\0'){
+      low = token;
+      high = (unsigned char)list[i+2 - ((list[i+1] == '\\') ? 0 : 1)];
+      i += ((list[i+1] == '\\' && list[i+2] != '\0') ? 3 : 2);
+      if (low > high){
+	temp = low; low = high; high = temp;
+      }
+      for (temp = low; temp <= high; temp++)
+	list_out[out_len++] = (unsigned char)temp;
+      continue;
+    }
+    list_out[out_len++] = token;
   }
+  return out_len;
 
-  return inserted_count;
-}
+} /* intern__fre__expand_translit() */
 
 
 /*
- * Remove a character sequence from a NUL terminated string. 
- * No error checks are made. 
- * Self warning >>> Possible comparaison agaisnt signed vs unsigned int. <<<
+ * Compile a transliteration pattern into a 256 bytes map, once,
+ * so that _transliterate_op() only has to look bytes up.
+ * Follows Perl: when a byte appears more than once in the search list its first 
+ * occurrence wins, with /c the search list is every byte it doesn't hold, 
+ * a short replacement list is padded with its last byte unless /d deletes the
+ * extra bytes, and an empty replacement list leaves bytes as they are (count only).
  */
-char* intern__fre__cut_match(char *string,
-			     size_t *numof_tokens_skiped, /* Number of tokens skiped by cut_match. */
-			     size_t string_size,          /* No to be confused with the lenght. */
-			     size_t bo,                   /* Begining of match string index. */
-			     size_t eo)                   /* Ending of match string index.   */
+int intern__fre__compile_translit(fre_pattern *freg_object)
 {
-  char *new_string = NULL;
-  size_t ns_ind = 0, i = 0, offset_to_start = *numof_tokens_skiped;
+  size_t i = 0;
+  size_t search_len = 0, replace_len = 0;
+  unsigned char byte = 0;
+  unsigned char *search_list = NULL, *replace_list = NULL;
+  uint8_t seen[32];
+  fre_translit *tr = NULL;
 
-  if ((new_string = calloc(string_size, sizeof(char))) == NULL){
-    intern__fre__errmesg("Calloc");
-    return NULL;
+  if (!freg_object){
+    errno = EINVAL;
+    return FRE_ERROR;
   }
-  while (i <= string_size && string[i] != '\0'){
-    if (i == (bo - offset_to_start)){
-      while (i < (eo - offset_to_start)){
-	++i;
-	++(*numof_tokens_skiped);
-      }
+  if ((tr = malloc(sizeof(fre_translit))) == NULL){
+    intern__fre__errmesg("Malloc");
+    return FRE_ERROR;
+  }
+  if ((search_list = malloc(FRE_MAX_PATTERN_LENGHT * 256)) == NULL
+      || (replace_list = malloc(FRE_MAX_PATTERN_LENGHT * 256)) == NULL){
+    intern__fre__errmesg("Malloc");
+    goto errjmp;
+  }
+  search_len = intern__fre__expand_translit(freg_object->striped_pattern[0], search_list);
+  replace_len = intern__fre__expand_translit(freg_object->striped_pattern[1], replace_list);
+
+  if (freg_object->fre_mod_tr_complement == true){
+    memset(seen, 0, sizeof(seen));
+    for (i = 0; i < search_len; i++)
+      seen[search_list[i] >> 3] |= (uint8_t)(1u << (search_list[i] & 7));
+    for (i = 0, search_len = 0; i < 256; i++)
+      if (!(seen[i >> 3] & (1u << (i & 7))))
+	search_list[search_len++] = (unsigned char)i;
+  }
+  if (freg_object->fre_mod_tr_delete == false){
+    if (replace_len == 0){
+      memcpy(replace_list, search_list, search_len);
+      replace_len = search_len;
+    }
+    while (replace_len < search_len){
+      replace_list[replace_len] = replace_list[replace_len-1];
+      ++replace_len;
+    }
+  }
+
+  for (i = 0; i < 256; i++)
+    tr->map[i] = (unsigned char)i;
+  memset(tr->in_set, 0, sizeof(tr->in_set));
+  memset(tr->del_set, 0, sizeof(tr->del_set));
+  memset(tr->class_lo, 0, sizeof(tr->class_lo));
+  memset(tr->class_hi, 0, sizeof(tr->class_hi));
+  tr->active_rows = 0;
+  tr->squeeze = freg_object->fre_mod_tr_squeeze;
+  tr->has_deletions = false;
+  for (i = 0; i < search_len; i++){
+    byte = search_list[i];
+    if (tr->in_set[byte >> 3] & (1u << (byte & 7)))
+      continue;
+    tr->in_set[byte >> 3] |= (uint8_t)(1u << (byte & 7));
+    if (byte < 128)
+      tr->class_lo[byte & 0x0f] |= (uint8_t)(1u << (byte >> 4));
+    else
+      tr->class_hi[byte & 0x0f] |= (uint8_t)(1u << ((byte >> 4) - 8));
+    /* Only reachable with /d, the replacement list was padded otherwise. */
+    if (i >= replace_len){
+      tr->del_set[byte >> 3] |= (uint8_t)(1u << (byte & 7));
+      tr->has_deletions = true;
       continue;
     }
-    new_string[ns_ind++] = string[i++];
+    tr->map[byte] = replace_list[i];
+    if (replace_list[i] != byte)
+      tr->active_rows |= (uint16_t)(1u << (byte >> 4));
+  }
+
+  free(search_list);
+  free(replace_list);
+  if (freg_object->translit != NULL)
+    free(freg_object->translit);
+  freg_object->translit = tr;
+  return FRE_OP_SUCCESSFUL;
+
+ errjmp:
+  if (search_list)
+    free(search_list);
+  if (replace_list)
+    free(replace_list);
+  free(tr);
+  return FRE_ERROR;
+
+} /* intern__fre__compile_translit() */
+
+
+/*
+ * Find the leftmost match of the compiled pattern in string[start..string_len],
+ * without copying nor altering the caller's string.
+ * REG_STARTEND lets regexec() see the characters before start, so that
+ * anchors and boundaries are judged against the whole string, and positions
+ * it returns are already relative to the begining of string.
+ * match_arr[0] receives the whole match, match_arr[1..numof_sm-1] the sub-matches,
+ * unmatched groups are set to -1.
+ */
+int intern__fre__exec_match(fre_pattern *freg_object,
+			    char *string,
+			    size_t string_len,
+			    size_t start,
+			    fre_smatch *match_arr,
+			    size_t numof_sm)
+{
+  size_t i = 0, end = string_len;
+  int ret = 0;
+  regmatch_t regmatch_arr[FRE_MAX_SUB_MATCHES];
+
+  if (!freg_object || !string || !match_arr || start > string_len
+      || numof_sm == 0 || numof_sm > FRE_MAX_SUB_MATCHES){
+    errno = EINVAL;
+    return FRE_ERROR;
+  }
+  /* 
+   * Without the pattern's literal there's no match, and when every match
+   * begins with it none can begin before it.
+   */
+  if (freg_object->literal != NULL && freg_object->engine != FRE_ENGINE_LITERAL){
+    const unsigned char *found = intern__fre__find_literal((const unsigned char*)string + start,
+							   string_len - start, freg_object->literal);
+    if (found == NULL)
+      return FRE_OP_UNSUCCESSFUL;
+    if (freg_object->literal->prefix)
+      start = (size_t)((const char*)found - string);
   }
-  if (string_size <= 2){
-    string[0] = '\0';
+  /* The backtracker finds the sub-matches too, unless the string is too much for it. */
+  if (freg_object->engine == FRE_ENGINE_BACKTRACK){
+    if ((ret = intern__fre__bt_exec(freg_object->bt, (const unsigned char*)string, string_len,
+				    start, match_arr, numof_sm)) != FRE_BT_OVER_BUDGET)
+      return ret;
   }
-  else {
-    if (SU_strcpy(string, new_string, string_size) == NULL){
-      intern__fre__errmesg("SU_strcpy");
-      if (new_string)
-	free(new_string);
-      return NULL;
+  /* Native engines find the whole match, the Pike VM or regexec() the sub-matches. */
+  else if (freg_object->engine != FRE_ENGINE_REGEX){
+    if ((ret = intern__fre__exec_native(freg_object, string, string_len, start,
+					&match_arr[0])) != FRE_OP_SUCCESSFUL)
+      return ret;
+    if (numof_sm == 1)
+      return FRE_OP_SUCCESSFUL;
+    /* A parenthesized alternation of literals, its only sub-match is the whole match. */
+    if (freg_object->engine == FRE_ENGINE_AC){
+      match_arr[1] = match_arr[0];
+      return FRE_OP_SUCCESSFUL;
     }
+    /* Sub-matches are only looked for in the match, which the DFA found. */
+    if (freg_object->pike != NULL)
+      return intern__fre__pike_exec(freg_object->pike, (const unsigned char*)string, string_len,
+				    (size_t)match_arr[0].bo, (size_t)match_arr[0].eo, true,
+				    match_arr, numof_sm);
+    start = (size_t)match_arr[0].bo;
+    /* Without assertions, nothing after the match changes how it's matched. */
+    if (freg_object->prog != NULL && freg_object->prog->assertions == 0)
+      end = (size_t)match_arr[0].eo;
   }
-  if (new_string)
-    free(new_string);
-  return string;
+  /* Clones of a pattern compile it the first time they need it. */
+  if (freg_object->fre_p1_compiled == false
+      && intern__fre__compile_pattern(freg_object) == FRE_ERROR){
+    intern__fre__errmesg("_compile_pattern");
+    return FRE_ERROR;
+  }
+  /* regoff_t may be narrower than fre_off, the native engines have none of its limits. */
+  if (end > FRE_REGOFF_MAX){
+    errno = EOVERFLOW;
+    return FRE_ERROR;
+  }
+  regmatch_arr[0].rm_so = (regoff_t)start;
+  regmatch_arr[0].rm_eo = (regoff_t)end;
+  if ((ret = regexec(freg_object->comp_pattern, string, numof_sm,
+		     regmatch_arr, REG_STARTEND)) == REG_NOMATCH)
+    return FRE_OP_UNSUCCESSFUL;
+  else if (ret != 0){
+    errno = FRE_OPERROR;
+    intern__fre__errmesg("Regexec");
+    return FRE_ERROR;
+  }
+  for (i = 0; i < numof_sm; i++){
+    match_arr[i].bo = (fre_off)regmatch_arr[i].rm_so;
+    match_arr[i].eo = (fre_off)regmatch_arr[i].rm_eo;
+  }
+  return FRE_OP_SUCCESSFUL;
+
+} /* intern__fre__exec_match() */
+
 
-} /* intern__fre__cut_match() */
-  
 /* 
  * Debug hook
  * Print all values of a given fre_pattern object.
@@ -480,15 +711,24 @@ void print_pattern_hook(fre_pattern* pat)
 	  ((pat->fre_mod_icase == true) ? "true" : "false"),
 	  ((pat->fre_mod_ext == true) ? "true" : "false"),
 	  ((pat->fre_mod_global == true) ? "true" : "false"));
+  fprintf(stderr, "Engine: %s\n",
+	  ((pat->engine == FRE_ENGINE_DFA) ? "DFA" :
+	   (pat->engine == FRE_ENGINE_LITERAL) ? "literal" :
+	   (pat->engine == FRE_ENGINE_AC) ? "Aho-Corasick" :
+	   (pat->engine == FRE_ENGINE_BACKTRACK) ? "backtrack" : "regex"));
+  if (pat->literal != NULL)
+    fprintf(stderr, "Literal: %.*s (%zu bytes, %s)\n", (int)pat->literal->len,
+	    (const char*)pat->literal->bytes, pat->literal->len,
+	    ((pat->literal->prefix == true) ? "prefix" : "required"));
+  if (pat->engine == FRE_ENGINE_DFA)
+    fprintf(stderr, "DFA states %zu/%zu bytes %zu flushes %zu\n",
+	    pat->dfa->numof_states, pat->rev_dfa->numof_states,
+	    pat->dfa->mem_used + pat->rev_dfa->mem_used,
+	    pat->dfa->numof_flushes + pat->rev_dfa->numof_flushes);
   fprintf(stderr, "fre_p1_compiled %s\nfre_paired_delimiters %s\nDelimiter [%c]\tC_Delimiter [%c]\n",
 	  ((pat->fre_p1_compiled == true) ? "true" : "false"),
 	  ((pat->fre_paired_delimiters == true) ? "true" : "false"),
 	  pat->delimiter, pat->c_delimiter);
-  fprintf(stderr, "fre_match_op_bow: %s\nfre_match_op_eow: %s\nfre_subs_op_bow: %s\nfre_subs_op_eow: %s\n",
-	  ((pat->fre_match_op_bow == true) ? "true" : "false"),
-	  ((pat->fre_match_op_eow == true) ? "true" : "false"),
-	  ((pat->fre_subs_op_bow == true) ? "true" : "false"),
-	  ((pat->fre_subs_op_eow == true) ? "true" : "false"));
   fprintf(stderr, "Operation type: %s\nfre_match_op_bref %s\nfre_subs_op_bref %s\n",
 	  ((pat->fre_op_flag == NONE) ? "NONE" :
 	   (pat->fre_op_flag == MATCH) ? "MATCH" :
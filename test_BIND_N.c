@@ -0,0 +1,142 @@
+/*
+ * Lenght-bounded binding, fre_bind_n(), fre_exec_n() and fre_set_exec_n(),
+ * over strings holding NUL bytes, and never NUL-terminated: each one ends
+ * a page, the next one can't be read, a byte read past it is a crash.
+ * It only calls libfre's public interface, see compile_test_PUBLIC.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <fre.h>
+
+#define ROOM 32
+
+/* A pattern bound against len bytes, what it returns and, for s/// and tr///, the bytes it leaves. */
+typedef struct bind_n_case_tab {
+  char                 *pattern;
+  const char           *input;
+  size_t                len;
+  size_t                size;         /* Room in the string, 0 for len. */
+  int                   retval;
+  const char           *output;       /* NULL for m//. */
+  size_t                output_len;
+} bind_n_case;
+
+static const bind_n_case cases[] = {
+  /* Matching across NUL bytes, with each engine. */
+  { "m/b/",                       "a\0b",        3,  0,    1, NULL, 0 },
+  { "m/^b/",                      "a\0b",        3,  0,    0, NULL, 0 },
+  { "m/a[^x]b/",                  "a\0b",        3,  0,    1, NULL, 0 },
+  { "m/\\bb/",                    "a\0b",        3,  0,    1, NULL, 0 },
+  { "m/c$/",                      "abc",         3,  0,    1, NULL, 0 },
+  { "m/abc/",                     "xxabc",       5,  0,    1, NULL, 0 },
+  { "m/abc/",                     "xxabc",       4,  0,    0, NULL, 0 },
+  { "m/b+c/",                     "a\0bbbc",     6,  0,    1, NULL, 0 },
+  { "m/foo|bar|baz/",             "xx\0baz",     6,  0,    1, NULL, 0 },
+  { "m/(a)\\1/",                  "x\0aa",       4,  0,    1, NULL, 0 },
+  { "m/(a)\\1/",                  "aa",          1,  0,    0, NULL, 0 },
+  /* '.' doesn't match a NUL byte, as with regcomp(), even with /s. */
+  { "m/a.b/",                     "a\0b",        3,  0,    0, NULL, 0 },
+  { "m/a.b/s",                    "a\0b",        3,  0,    0, NULL, 0 },
+  /* The new lenght, NUL bytes kept. */
+  { "s/b/[$&]/g",                 "a\0b\0b",     5, ROOM,  1, "a\0[b]\0[b]",  9 },
+  { "s/[^a-z]/-/g",               "a\0b",        3, ROOM,  1, "a-b",          3 },
+  { "s/x/y/",                     "a\0b",        3, ROOM,  0, "a\0b",         3 },
+  { "s/b/xx/",                    "a\0b",        3,  5,    1, "a\0xx",        4 },
+  { "s/b/xx/",                    "a\0b",        3,  4,   -1, "a\0b",         3 },
+  { "tr/a-z/A-Z/",                "a\0b",        3,  0,    1, "A\0B",         3 },
+  { "tr/a-z//d",                  "a\0b",        3,  0,    1, "\0",           1 },
+  { "tr/a-z//c",                  "a\0b\0",      4,  0,    1, "a\0b\0",       4 },
+};
+
+static size_t numof_failures = 0;
+static char *page = NULL;
+static size_t page_size = 0;
+
+/* A copy of len bytes of input, at the end of size bytes ending the readable page. */
+static char* guarded(const char *input,
+		     size_t len,
+		     size_t size)
+{
+  char *string = page + page_size - size;
+
+  memset(string, 'x', size);
+  memcpy(string, input, len);
+  return string;
+}
+
+/* Whether the case left what it should, after it returned retval. */
+static void check_case(const bind_n_case *c,
+		       const char *how,
+		       int retval,
+		       const char *string)
+{
+  size_t len = ((c->output != NULL && retval == 1) ? fre_result_len() : c->output_len);
+
+  if (retval != c->retval
+      || (c->output != NULL && (len != c->output_len || memcmp(string, c->output, c->output_len) != 0))){
+    printf("FAIL %s %s over %zu bytes: %d, lenght %zu, expected %d\n", how, c->pattern, c->len, retval,
+	   len, c->retval);
+    numof_failures++;
+  }
+}
+
+int main(void)
+{
+  size_t i = 0, size = 0;
+  int retval = 0;
+  char *string = NULL;
+  fre_regex *handle = NULL;
+  fre_set *set = NULL;
+  char *set_patterns[] = { "m/b/", "m/c/", "m/a[^b]b/" };
+  size_t ids[3];
+  fre_off offsets[6];
+
+  page_size = (size_t)sysconf(_SC_PAGESIZE);
+  if ((page = mmap(NULL, 2 * page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED
+      || mprotect(page + page_size, page_size, PROT_NONE) != 0){
+    perror("mmap");
+    return -1;
+  }
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+    size = ((cases[i].size > 0) ? cases[i].size : cases[i].len);
+    string = guarded(cases[i].input, cases[i].len, size);
+    retval = fre_bind_n(cases[i].pattern, string, cases[i].len, size);
+    check_case(&cases[i], "fre_bind_n()", retval, string);
+
+    if ((handle = fre_compile(cases[i].pattern)) == NULL){
+      printf("FAIL fre_compile() of %s\n", cases[i].pattern);
+      numof_failures++;
+      continue;
+    }
+    string = guarded(cases[i].input, cases[i].len, size);
+    retval = fre_exec_n(handle, string, cases[i].len, size);
+    check_case(&cases[i], "fre_exec_n()", retval, string);
+    fre_free(handle);
+  }
+
+  /* Sets, the offsets counted over NUL bytes. */
+  if ((set = fre_set_compile(set_patterns, 3)) == NULL){
+    printf("FAIL fre_set_compile()\n");
+    numof_failures++;
+  }
+  else {
+    string = guarded("a\0b", 3, 3);
+    retval = fre_set_exec_n(set, string, 3, ids, offsets);
+    if (retval != 2 || ids[0] != 0 || offsets[0] != 2 || offsets[1] != 3
+	|| ids[1] != 2 || offsets[2] != 0 || offsets[3] != 3){
+      printf("FAIL fre_set_exec_n() over NUL bytes: %d\n", retval);
+      numof_failures++;
+    }
+    fre_set_free(set);
+  }
+  printf("bind_n: %zu cases, %zu failures\n", sizeof(cases) / sizeof(cases[0]), numof_failures);
+  munmap(page, 2 * page_size);
+
+  return ((numof_failures > 0) ? 1 : 0);
+}
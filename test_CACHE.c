@@ -0,0 +1,302 @@
+/*
+ * The per-thread pattern cache: fre_cache_stats() hits and misses, least
+ * recently used patterns evicted at capacity, capacity 0, and the tables of
+ * exiting threads given back to the pool, for the next threads to reuse.
+ * The shared pattern table: patterns parsed once for all threads, the oldest
+ * evicted at capacity while their clones live on, capacity 0, and threads
+ * compiling the same patterns while they're evicted.
+ * It looks at the pool and the tables, local to libfre.so, it's built from
+ * the sources, see compile_test_PUBLIC.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include <fre.h>
+#include "fre_internal.h" /* The pmatch-tables, their pool, and the shared table. */
+
+#define NUMOF_THREADS 64
+#define NUMOF_RACERS 8
+#define RACER_ITERATIONS 2000
+
+/* A pattern bound, and whether the cache should have it. */
+typedef struct cache_step_tab {
+  size_t                pattern;      /* In patterns[]. */
+  char                  expected;     /* 'h' for a hit, 'm' for a miss. */
+} cache_step;
+
+static char *patterns[] = { "m/one/", "m/two/", "m/three/", "m/four/" };
+
+/* With a capacity of 3, the first use of each pattern misses, and the least recently used goes. */
+static const cache_step lru_steps[] = {
+  { 0, 'm' }, { 0, 'h' }, { 1, 'm' }, { 2, 'm' },  /* three two one */
+  { 0, 'h' },                                       /* one three two */
+  { 3, 'm' },                                       /* four one three, two evicted */
+  { 1, 'm' },                                       /* two four one, three evicted */
+  { 0, 'h' }, { 3, 'h' }, { 2, 'm' },               /* three four one, two evicted */
+  { 1, 'm' }, { 2, 'h' },
+};
+
+static size_t numof_failures = 0;
+
+/* Bind pattern, telling whether the calling thread's cache had it. */
+static char bind_step(char *pattern)
+{
+  size_t hits = 0, misses = 0, new_hits = 0, new_misses = 0;
+  char string[] = "zero one two three four";
+
+  fre_cache_stats(&hits, &misses);
+  if (fre_bind(pattern, string, sizeof(string)) == -1)
+    return 'e';
+  fre_cache_stats(&new_hits, &new_misses);
+  if (new_hits == hits + 1 && new_misses == misses)
+    return 'h';
+  if (new_hits == hits && new_misses == misses + 1)
+    return 'm';
+  return '?';
+}
+
+static void check_lru(void)
+{
+  size_t i = 0, k = 0, hits = 0, misses = 0;
+  char got = 0;
+
+  if (fre_cache_set_capacity(3) != 1){
+    printf("FAIL fre_cache_set_capacity(3)\n");
+    numof_failures++;
+    return;
+  }
+  for (i = 0; i < sizeof(lru_steps) / sizeof(lru_steps[0]); i++)
+    if ((got = bind_step(patterns[lru_steps[i].pattern])) != lru_steps[i].expected){
+      printf("FAIL step %zu, %s: '%c', expected '%c'\n", i, patterns[lru_steps[i].pattern], got, lru_steps[i].expected);
+      numof_failures++;
+    }
+  if (fre_pmatch_table->pattern_cache->numof_entries != 3){
+    printf("FAIL %zu patterns cached at capacity 3\n", fre_pmatch_table->pattern_cache->numof_entries);
+    numof_failures++;
+  }
+
+  /* Shrinking keeps the most recently used, three, until two takes its place. */
+  fre_cache_set_capacity(1);
+  if ((got = bind_step(patterns[2])) != 'h' || (got = bind_step(patterns[1])) != 'm'
+      || (got = bind_step(patterns[2])) != 'm'){
+    printf("FAIL capacity 1: '%c'\n", got);
+    numof_failures++;
+  }
+
+  /* Capacity 0: nothing is kept, every bind misses, and still works. */
+  fre_cache_set_capacity(0);
+  for (k = 0; k < 3; k++)
+    if ((got = bind_step(patterns[0])) != 'm'){
+      printf("FAIL capacity 0, bind %zu of %s: '%c'\n", k, patterns[0], got);
+      numof_failures++;
+    }
+  if (fre_pmatch_table->pattern_cache->numof_entries != 0){
+    printf("FAIL %zu patterns cached at capacity 0\n", fre_pmatch_table->pattern_cache->numof_entries);
+    numof_failures++;
+  }
+  fre_cache_set_capacity(16);
+  fre_cache_stats(&hits, &misses);
+  printf("cache: %zu hits, %zu misses\n", hits, misses);
+}
+
+/* Each thread starts with an empty cache of its own, whatever the threads before it bound. */
+static void* worker(void *arg)
+{
+  size_t hits = 0, misses = 0;
+  fre_pmatch **table = arg;
+  char first = 0, second = 0;
+
+  fre_cache_stats(&hits, &misses);
+  first = bind_step(patterns[0]);
+  second = bind_step(patterns[0]);
+  if (hits != 0 || misses != 0 || first != 'm' || second != 'h'){
+    printf("FAIL thread starting with %zu hits, %zu misses, then '%c' '%c'\n", hits, misses, first, second);
+    __atomic_add_fetch(&numof_failures, 1, __ATOMIC_SEQ_CST);
+  }
+  *table = fre_pmatch_table;
+  return NULL;
+}
+
+/* Threads run one after the other all get the pmatch-table of the first one back. */
+static void check_threads(void)
+{
+  size_t i = 0, in_use = 0, size = 0;
+  pthread_t thread;
+  fre_pmatch *table = NULL, *first = NULL;
+
+  pthread_mutex_lock(fre_headnode_table->table_lock);
+  in_use = fre_headnode_table->head_list_tos;
+  size = fre_headnode_table->sizeof_table;
+  pthread_mutex_unlock(fre_headnode_table->table_lock);
+  for (i = 0; i < NUMOF_THREADS; i++){
+    if (pthread_create(&thread, NULL, worker, &table) != 0 || pthread_join(thread, NULL) != 0){
+      perror("pthread");
+      numof_failures++;
+      return;
+    }
+    if (i == 0)
+      first = table;
+    else if (table != first){
+      printf("FAIL thread %zu got another pmatch-table than the first\n", i);
+      numof_failures++;
+      break;
+    }
+  }
+  pthread_mutex_lock(fre_headnode_table->table_lock);
+  if (fre_headnode_table->head_list_tos != in_use || fre_headnode_table->sizeof_table != size){
+    printf("FAIL %zu pmatch-tables in use, %zu in the pool after %d threads, %zu and %zu before\n",
+	   fre_headnode_table->head_list_tos, fre_headnode_table->sizeof_table, NUMOF_THREADS, in_use, size);
+    numof_failures++;
+  }
+  pthread_mutex_unlock(fre_headnode_table->table_lock);
+  printf("cache: %d threads one after the other\n", NUMOF_THREADS);
+}
+
+/* The shared table's entry for pattern, NULL when it isn't there. */
+static fre_shared_entry* shared_entry_of(char *pattern)
+{
+  fre_shared_entry *entry = NULL;
+
+  pthread_mutex_lock(fre_shared_pattern_table->table_lock);
+  entry = fre_shared_pattern_table->buckets[intern__fre__hash_pattern(pattern) & (FRE_SHARED_BUCKETS - 1)];
+  while (entry != NULL && strcmp(entry->pattern, pattern) != 0)
+    entry = entry->hash_next;
+  pthread_mutex_unlock(fre_shared_pattern_table->table_lock);
+  return entry;
+}
+
+/* Whether a compiled pattern still matches as it should. */
+static bool still_matches(fre_regex *handle)
+{
+  char string[] = "zero one two three four";
+  char other[] = "nothing";
+
+  return (fre_exec(handle, string, sizeof(string)) == 1 && fre_exec(handle, other, sizeof(other)) == 0);
+}
+
+/* Compiled by another thread. */
+static void* compile_one(void *arg)
+{
+  fre_regex **handle = arg;
+
+  *handle = fre_compile(patterns[2]);
+  return NULL;
+}
+
+static void check_shared(void)
+{
+  size_t i = 0;
+  pthread_t thread;
+  fre_regex *handle = NULL, *other = NULL, *kept = NULL;
+  fre_pattern *freg_object = NULL, *other_object = NULL;
+  fre_shared_entry *entry = NULL;
+  char *fifo[] = { "m/five/", "m/six/", "m/seven/" };
+
+  /* Two threads compiling a pattern share its parsing. */
+  fre_shared_cache_set_capacity(FRE_SHARED_CAPACITY);
+  handle = fre_compile(patterns[2]);
+  if (pthread_create(&thread, NULL, compile_one, &other) != 0 || pthread_join(thread, NULL) != 0){
+    perror("pthread");
+    numof_failures++;
+    return;
+  }
+  freg_object = handle;
+  other_object = other;
+  entry = shared_entry_of(patterns[2]);
+  if (handle == NULL || other == NULL || entry == NULL || freg_object->shared_entry != entry
+      || other_object->shared_entry != entry || __atomic_load_n(&entry->refcount, __ATOMIC_SEQ_CST) < 3){
+    printf("FAIL %s compiled by two threads isn't parsed once\n", patterns[2]);
+    numof_failures++;
+  }
+  fre_free(other);
+
+  /* At capacity the oldest goes, its clones live on. */
+  fre_shared_cache_set_capacity(2);
+  kept = fre_compile(fifo[0]);
+  for (i = 1; i < sizeof(fifo) / sizeof(fifo[0]); i++)
+    fre_free(fre_compile(fifo[i]));
+  if (fre_shared_pattern_table->numof_entries != 2 || shared_entry_of(fifo[0]) != NULL
+      || shared_entry_of(fifo[1]) == NULL || shared_entry_of(fifo[2]) == NULL || shared_entry_of(patterns[2]) != NULL){
+    printf("FAIL %zu patterns shared at capacity 2, or not the newest\n", fre_shared_pattern_table->numof_entries);
+    numof_failures++;
+  }
+  if (kept == NULL || !still_matches(handle)){
+    printf("FAIL a pattern evicted from the shared table doesn't match anymore\n");
+    numof_failures++;
+  }
+  fre_free(kept);
+
+  /* Capacity 0: nothing is shared, patterns still compile and match. */
+  fre_shared_cache_set_capacity(0);
+  kept = fre_compile(patterns[3]);
+  freg_object = kept;
+  if (fre_shared_pattern_table->numof_entries != 0 || kept == NULL || freg_object->shared_entry != NULL
+      || !still_matches(kept)){
+    printf("FAIL %zu patterns shared at capacity 0\n", fre_shared_pattern_table->numof_entries);
+    numof_failures++;
+  }
+  fre_free(kept);
+  fre_free(handle);
+  fre_shared_cache_set_capacity(FRE_SHARED_CAPACITY);
+  printf("shared: one parse for two threads, capacities 2 and 0\n");
+}
+
+/* Compile, bind and free patterns the other threads evict from the shared table. */
+static void* racer(void *arg)
+{
+  size_t i = 0;
+  char string[] = "zero one two three four";
+  char *pattern = NULL;
+  fre_regex *handle = NULL;
+
+  (void)arg;
+  fre_cache_set_capacity(2);
+  for (i = 0; i < RACER_ITERATIONS; i++){
+    pattern = patterns[(size_t)rand() % (sizeof(patterns) / sizeof(patterns[0]))];
+    if (i % 2 == 0){
+      if ((handle = fre_compile(pattern)) == NULL || !still_matches(handle)){
+	printf("FAIL %s compiled while the shared table evicts it\n", pattern);
+	__atomic_add_fetch(&numof_failures, 1, __ATOMIC_SEQ_CST);
+      }
+      fre_free(handle);
+    }
+    else if (fre_bind(pattern, string, sizeof(string)) != 1){
+      printf("FAIL %s bound while the shared table evicts it\n", pattern);
+      __atomic_add_fetch(&numof_failures, 1, __ATOMIC_SEQ_CST);
+    }
+  }
+  return NULL;
+}
+
+static void check_shared_threads(void)
+{
+  size_t i = 0;
+  pthread_t threads[NUMOF_RACERS];
+
+  fre_shared_cache_set_capacity(2);
+  for (i = 0; i < NUMOF_RACERS; i++)
+    if (pthread_create(&threads[i], NULL, racer, NULL) != 0){
+      perror("pthread_create");
+      numof_failures++;
+      break;
+    }
+  while (i > 0)
+    pthread_join(threads[--i], NULL);
+  fre_shared_cache_set_capacity(FRE_SHARED_CAPACITY);
+  printf("shared: %d threads evicting each other's patterns\n", NUMOF_RACERS);
+}
+
+int main(void)
+{
+  check_lru();
+  check_threads();
+  check_shared();
+  check_shared_threads();
+  printf("cache: %zu failures\n", numof_failures);
+
+  return ((numof_failures > 0) ? 1 : 0);
+}
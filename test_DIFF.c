@@ -0,0 +1,639 @@
+/*
+ * Differential test of libfre, over random patterns and texts:
+ *  - the native engines against regcomp()/regexec() with REG_STARTEND,
+ *    at every start offset, and the backtracker against them,
+ *  - the native code of a DFA against its interpreter,
+ *  - streams, with windows shorter than a line, and files against
+ *    a search of the whole buffer,
+ *  - fre_grep_lines() and its kin against matching each line alone.
+ * It calls functions local to libfre.so, it's built from the sources,
+ * see compile_test_PUBLIC.sh. With -b it times the DFA's interpreter and
+ * its native code over a 16 MB text instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <regex.h>
+
+#include <fre.h>
+#include "fre_internal.h" /* Engines and scan modes. */
+
+#define DEF_ITERATIONS 2000
+#define DEF_SEED 1
+#define MAX_SM 10
+#define MAX_TEXT 2500
+#define MAX_ERE 200
+#define BENCH_LEN (1 << 24)
+#define NUMOF_ASSERTIONS 3
+
+/* Atoms regcomp() reads the way libfre does, the assertions last. */
+static const char *atoms[] = { "a", "b", "c", "A", "x", "ab", " ", ".", "\\.", "[ab]", "[^a]", "[a-c]",
+			       "[[:alpha:]]", "[^[:space:]]", "\\w", "\\s", "^", "$", "\\b" };
+
+static const char *modifiers[] = { "", "i", "g", "gi", "gs", "s" };
+static const size_t windows[] = { 8, 40, 300, 4096, 8192 };
+static const char *bench_patterns[] = { "m/\"[^\"]*\"/", "m/(foo|bar)baz/" };
+
+static size_t numof_diffs = 0;
+
+/* Matches and lines handed to a callback. */
+typedef struct diff_found_tab {
+  fre_smatch            matches[MAX_TEXT + 2];
+  size_t                numof_matches;
+  fre_line              lines[MAX_TEXT + 2];
+  size_t                numof_lines;
+} diff_found;
+
+static diff_found found;
+
+void usage(char *name)
+{
+  fprintf(stderr, "\nUsage:  %s [iterations] [seed]\n"
+	  "        %s -b [pattern ...]\n\n", name, name);
+}
+
+/* Report a difference, the first few of them. */
+static void diff_report(const char *section,
+			const char *pattern,
+			const char *text,
+			size_t text_len,
+			const char *what)
+{
+  size_t i = 0;
+
+  if (numof_diffs++ >= 20)
+    return;
+  printf("DIFF %s: %s ", section, pattern);
+  for (i = 0; i < text_len && i < 80; i++)
+    putchar((text[i] == '\n') ? '|' : text[i]);
+  printf("%s: %s\n", ((text_len > 80) ? "..." : ""), what);
+}
+
+/*
+ * A random ERE, its repetitions nested no more than three deep, and only
+ * of what matches a byte: regcomp() is slow past that, or never returns.
+ * Whether it matches a byte, *asserts set when it holds an assertion.
+ */
+static bool gen_ere(char *ere,
+		    int depth,
+		    bool *asserts)
+{
+  int k = rand() % 10, atom = 0;
+  bool consumes = false;
+
+  if (depth > 2 || k < 3){
+    atom = rand() % (int)(sizeof(atoms) / sizeof(atoms[0]));
+    strcat(ere, atoms[atom]);
+    if (atom < (int)(sizeof(atoms) / sizeof(atoms[0])) - NUMOF_ASSERTIONS)
+      return true;
+    *asserts = true;
+    return false;
+  }
+  if (k < 5){
+    consumes = gen_ere(ere, depth + 1, asserts);
+    return (gen_ere(ere, depth + 1, asserts) || consumes);
+  }
+  strcat(ere, "(");
+  consumes = gen_ere(ere, depth + 1, asserts);
+  if (k == 5){
+    strcat(ere, "|");
+    consumes = (gen_ere(ere, depth + 1, asserts) && consumes);
+  }
+  strcat(ere, ((!consumes) ? ")" : (k == 6) ? ")*" : (k == 7) ? ")+" : (k == 8) ? ")?" : "){1,2}"));
+  return consumes;
+}
+
+/* A random matching pattern, its ERE in ere, false when it's too long to use. */
+static bool gen_pattern(char *pattern,
+			char *ere,
+			bool with_modifiers,
+			bool *asserts)
+{
+  ere[0] = '\0';
+  *asserts = false;
+  gen_ere(ere, 0, asserts);
+  if (rand() % 4 == 0){
+    strcat(ere, "|");
+    gen_ere(ere, 0, asserts);
+  }
+  if (strlen(ere) > MAX_ERE)
+    return false;
+  sprintf(pattern, "m/%s/%s", ere,
+	  ((with_modifiers) ? modifiers[rand() % (sizeof(modifiers) / sizeof(modifiers[0]))]
+	   : ((rand() % 4 == 0) ? "i" : "")));
+  return true;
+}
+
+/* A random text, a newline about every line_len bytes, of bytes some patterns match. */
+static void gen_text(char *text,
+		     size_t len,
+		     size_t line_len,
+		     const char *alphabet)
+{
+  size_t i = 0, size = strlen(alphabet);
+
+  for (i = 0; i < len; i++)
+    text[i] = ((line_len > 0 && (size_t)rand() % line_len == 0) ? '\n' : alphabet[rand() % size]);
+}
+
+/* The matches found searching the whole of text, one after the other with /g. */
+static size_t whole_matches(fre_pattern *freg_object,
+			    const char *text,
+			    size_t text_len,
+			    fre_smatch *matches,
+			    size_t *longest)
+{
+  size_t numof_matches = 0, start = 0;
+
+  *longest = 0;
+  while (start <= text_len
+	 && intern__fre__exec_match(freg_object, (char*)text, text_len, start, &matches[numof_matches], 1) == FRE_OP_SUCCESSFUL){
+    if ((size_t)(matches[numof_matches].eo - matches[numof_matches].bo) > *longest)
+      *longest = (size_t)(matches[numof_matches].eo - matches[numof_matches].bo);
+    start = (size_t)matches[numof_matches].eo + (matches[numof_matches].eo == matches[numof_matches].bo);
+    numof_matches++;
+    if (freg_object->fre_mod_global == false)
+      break;
+  }
+  return numof_matches;
+}
+
+/* Whether the first numof_matches sub-matches of a and b are the same. */
+static bool same_matches(const fre_smatch *a,
+			 const fre_smatch *b,
+			 size_t numof_matches)
+{
+  size_t i = 0;
+
+  for (i = 0; i < numof_matches; i++)
+    if (a[i].bo != b[i].bo || a[i].eo != b[i].eo)
+      return false;
+  return true;
+}
+
+/* Records each match handed to it. */
+static int found_match(fre_off bo,
+		       fre_off eo,
+		       void *arg)
+{
+  diff_found *f = arg;
+
+  if (f->numof_matches < MAX_TEXT + 2){
+    f->matches[f->numof_matches].bo = bo;
+    f->matches[f->numof_matches].eo = eo;
+  }
+  f->numof_matches++;
+  return 0;
+}
+
+/* Records each line handed to it. */
+static int found_line(const fre_line *line,
+		      void *arg)
+{
+  diff_found *f = arg;
+
+  if (f->numof_lines < MAX_TEXT + 2)
+    f->lines[f->numof_lines] = *line;
+  f->numof_lines++;
+  return 0;
+}
+
+/*
+ * The native engines, and the backtracker run on the same program, against
+ * regexec() at every start offset: whether they match, where, and their sub-matches.
+ * Those only for non-empty matches of patterns without assertions, regexec()
+ * picks others than POSIX would between alternatives as long, or around
+ * assertions. Those of the backtracker only where a Pike VM finds them too,
+ * it may take one more empty iteration, see intern__fre__pike_captures().
+ * Back-references aren't checked, regexec() gets them wrong.
+ */
+static void check_engines(size_t iterations)
+{
+  size_t it = 0, nsm = 0, k = 0, numof_native = 0, numof_runs = 0;
+  int s = 0, ret = 0, fre_ret = 0, bt_ret = 0;
+  size_t text_len = 0, start = 0;
+  bool asserts = false;
+  char pattern[MAX_ERE * 3], ere[MAX_ERE * 3], text[32], what[160];
+  fre_regex *handle = NULL;
+  fre_pattern *freg_object = NULL;
+  fre_bt *bt = NULL;
+  fre_smatch fm[MAX_SM], bm[MAX_SM];
+  regmatch_t rm[MAX_SM];
+  regex_t re;
+
+  for (it = 0; it < iterations; it++){
+    if (!gen_pattern(pattern, ere, false, &asserts) || (handle = fre_compile(pattern)) == NULL)
+      continue;
+    freg_object = handle;
+    if (freg_object->engine == FRE_ENGINE_REGEX
+	|| regcomp(&re, ere, REG_EXTENDED | ((freg_object->fre_mod_icase) ? REG_ICASE : 0)
+		   | ((freg_object->fre_mod_newline) ? 0 : REG_NEWLINE)) != 0){
+      fre_free(handle);
+      continue;
+    }
+    numof_native++;
+    bt = ((freg_object->prog != NULL) ? intern__fre__bt_build(freg_object->prog, freg_object->fre_mod_icase) : NULL);
+    nsm = ((freg_object->numof_groups + 1 < MAX_SM) ? freg_object->numof_groups + 1 : MAX_SM);
+    for (s = 0; s < 20; s++){
+      text_len = (size_t)rand() % 30;
+      gen_text(text, text_len, 0, "abcAx. \n");
+      for (start = 0; start <= text_len; start++){
+	numof_runs++;
+	rm[0].rm_so = (regoff_t)start;
+	rm[0].rm_eo = (regoff_t)text_len;
+	ret = regexec(&re, text, nsm, rm, REG_STARTEND);
+	fre_ret = intern__fre__exec_match(freg_object, text, text_len, start, fm, nsm);
+	if (fre_ret != ((ret == 0) ? FRE_OP_SUCCESSFUL : FRE_OP_UNSUCCESSFUL)
+	    || (ret == 0 && (rm[0].rm_so != fm[0].bo || rm[0].rm_eo != fm[0].eo))){
+	  snprintf(what, sizeof(what), "start %zu engine %d, %d at [%lld,%lld], regexec() %d at [%d,%d]", start,
+		   (int)freg_object->engine, fre_ret, (long long)fm[0].bo, (long long)fm[0].eo, ret,
+		   (int)rm[0].rm_so, (int)rm[0].rm_eo);
+	  diff_report("engines", pattern, text, text_len, what);
+	  continue;
+	}
+	for (k = 1; ret == 0 && !asserts && rm[0].rm_eo > rm[0].rm_so && k < nsm; k++)
+	  if (rm[k].rm_so != fm[k].bo || rm[k].rm_eo != fm[k].eo){
+	    snprintf(what, sizeof(what), "start %zu engine %d, \\%zu at [%lld,%lld], regexec() [%d,%d]", start,
+		     (int)freg_object->engine, k, (long long)fm[k].bo, (long long)fm[k].eo, (int)rm[k].rm_so, (int)rm[k].rm_eo);
+	    diff_report("engines", pattern, text, text_len, what);
+	    break;
+	  }
+	if (bt == NULL)
+	  continue;
+	bt_ret = intern__fre__bt_exec(bt, (unsigned char*)text, text_len, start, bm, nsm);
+	if (bt_ret != ((ret == 0) ? FRE_OP_SUCCESSFUL : FRE_OP_UNSUCCESSFUL)
+	    || (ret == 0 && !same_matches(bm, fm, ((freg_object->pike != NULL) ? nsm : 1)))){
+	  snprintf(what, sizeof(what), "start %zu backtracker %d at [%lld,%lld]", start, bt_ret,
+		   (long long)bm[0].bo, (long long)bm[0].eo);
+	  diff_report("engines", pattern, text, text_len, what);
+	}
+      }
+    }
+    intern__fre__free_bt(bt);
+    regfree(&re);
+    fre_free(handle);
+  }
+  printf("engines: %zu native patterns, %zu searches\n", numof_native, numof_runs);
+}
+
+/* The native code of a DFA against its interpreter, at every start offset of longer texts. */
+static void check_jit(size_t iterations)
+{
+  size_t it = 0, numof_jit = 0, numof_runs = 0, text_len = 0, start = 0;
+  int s = 0, ret = 0, jit_ret = 0;
+  bool asserts = false;
+  char pattern[MAX_ERE * 3], ere[MAX_ERE * 3], text[400], what[160];
+  fre_regex *handle = NULL;
+  fre_pattern *freg_object = NULL;
+  fre_jit_code *jit = NULL;
+  fre_smatch match, jit_match;
+
+  for (it = 0; it < iterations; it++){
+    if (!gen_pattern(pattern, ere, true, &asserts) || (handle = fre_compile(pattern)) == NULL)
+      continue;
+    freg_object = handle;
+    if (freg_object->engine != FRE_ENGINE_DFA || fre_jit(handle, 1) != FRE_OP_SUCCESSFUL){
+      fre_free(handle);
+      continue;
+    }
+    numof_jit++;
+    jit = freg_object->jit;
+    for (s = 0; s < 4; s++){
+      text_len = (size_t)rand() % sizeof(text);
+      gen_text(text, text_len, ((s & 1) ? 40 : 0), ((s & 2) ? "abcAx. 5_" : "abc"));
+      for (start = 0; start <= text_len; start++){
+	numof_runs++;
+	freg_object->jit = NULL;
+	ret = intern__fre__dfa_exec(freg_object, (unsigned char*)text, text_len, start, &match);
+	freg_object->jit = jit;
+	jit_ret = intern__fre__dfa_exec(freg_object, (unsigned char*)text, text_len, start, &jit_match);
+	if (ret != jit_ret || (ret == FRE_OP_SUCCESSFUL && !same_matches(&match, &jit_match, 1))){
+	  snprintf(what, sizeof(what), "start %zu interpreter %d [%lld,%lld], native code %d [%lld,%lld]", start,
+		   ret, (long long)match.bo, (long long)match.eo, jit_ret, (long long)jit_match.bo, (long long)jit_match.eo);
+	  diff_report("jit", pattern, text, text_len, what);
+	}
+      }
+    }
+    fre_free(handle);
+  }
+  printf("jit: %zu compiled patterns, %zu searches\n", numof_jit, numof_runs);
+}
+
+/*
+ * Files, searched FRE_FILE_WINDOW bytes at a time, against searching
+ * the whole text. A missing one fails with errno from open().
+ */
+static void check_file(size_t iterations)
+{
+  size_t it = 0, longest = 0, numof_ref = 0, text_len = 0, numof_files = 0;
+  int t = 0, ret = 0, fd = -1;
+  bool asserts = false;
+  char pattern[MAX_ERE * 3], ere[MAX_ERE * 3], what[160];
+  char path[] = "/tmp/test_DIFF.XXXXXX";
+  static char text[MAX_TEXT];
+  static fre_smatch ref[MAX_TEXT + 2];
+  fre_regex *handle = NULL;
+  fre_pattern *freg_object = NULL;
+  FILE *file = NULL;
+
+  if ((fd = mkstemp(path)) == -1){
+    perror("mkstemp");
+    return;
+  }
+  close(fd);
+  for (it = 0; it < iterations; it++){
+    if (!gen_pattern(pattern, ere, true, &asserts) || (handle = fre_compile(pattern)) == NULL)
+      continue;
+    freg_object = handle;
+    for (t = 0; t < 4; t++){
+      text_len = (size_t)rand() % MAX_TEXT;
+      gen_text(text, text_len, ((t >= 2) ? 150 : (t & 1) ? 10 : 0), ((t & 1) ? "abcAx. 5_" : "abc"));
+      numof_ref = whole_matches(freg_object, text, text_len, ref, &longest);
+
+      found.numof_matches = 0;
+      if ((file = fopen(path, "w")) == NULL || fwrite(text, 1, text_len, file) != text_len || fclose(file) != 0){
+	perror(path);
+	break;
+      }
+      numof_files++;
+      ret = fre_match_file(handle, path, found_match, &found);
+      if (ret != ((numof_ref > 0) ? FRE_OP_SUCCESSFUL : FRE_OP_UNSUCCESSFUL) || found.numof_matches != numof_ref
+	  || !same_matches(found.matches, ref, numof_ref)){
+	snprintf(what, sizeof(what), "file %d with %zu matches, the whole text %zu", ret, found.numof_matches, numof_ref);
+	diff_report("file", pattern, text, text_len, what);
+      }
+    }
+    fre_free(handle);
+  }
+  unlink(path);
+  if ((handle = fre_compile("m/a/")) != NULL){
+    errno = 0;
+    ret = fre_match_file(handle, path, found_match, &found);
+    if (ret != FRE_ERROR || errno != ENOENT){
+      snprintf(what, sizeof(what), "missing file %d, errno %d", ret, errno);
+      diff_report("file", "m/a/", path, strlen(path), what);
+    }
+    fre_free(handle);
+  }
+  printf("file: %zu texts, %d-byte windows\n", numof_files, (int)FRE_FILE_WINDOW);
+}
+
+/*
+ * Streams, fed chunks of random sizes, against searching the whole text.
+ * A stream misses or cuts the matches longer than its window, or those of
+ * lines longer than it when they're about as long as it, those runs are left out.
+ * It makes none up though, those a line of "abc"s doesn't have are looked for
+ * past the end of each window.
+ */
+static void check_stream(size_t iterations)
+{
+  size_t it = 0, longest = 0, numof_ref = 0, text_len = 0, p = 0, chunk = 0, window = 0;
+  size_t i = 0, line = 0, max_line = 0, numof_runs = 0, numof_skipped = 0;
+  int t = 0;
+  bool asserts = false;
+  char pattern[MAX_ERE * 3], ere[MAX_ERE * 3], what[160];
+  static char text[MAX_TEXT];
+  static fre_smatch ref[MAX_TEXT + 2];
+  fre_regex *handle = NULL;
+  fre_pattern *freg_object = NULL;
+  fre_stream *stream = NULL;
+  fre_scan_f mode;
+
+  for (it = 0; it < iterations; it++){
+    if (!gen_pattern(pattern, ere, true, &asserts) || (handle = fre_compile(pattern)) == NULL)
+      continue;
+    freg_object = handle;
+    for (t = 0; t < 8; t++){
+      text_len = (size_t)rand() % MAX_TEXT;
+      gen_text(text, text_len, ((t >= 6) ? 150 : (t & 1) ? 10 : 0), ((t & 1) ? "abcAx. 5_" : "abc"));
+      numof_ref = whole_matches(freg_object, text, text_len, ref, &longest);
+
+      window = windows[rand() % (sizeof(windows) / sizeof(windows[0]))];
+      found.numof_matches = 0;
+      if ((stream = fre_stream_new(handle, window, found_match, &found)) == NULL){
+	FRE_PERROR("fre_stream_new");
+	break;
+      }
+      for (p = 0; p < text_len; p += chunk){
+	chunk = (size_t)rand() % ((rand() % 3 != 0) ? 20 : 400);
+	if (chunk > text_len - p)
+	  chunk = text_len - p;
+	if (fre_stream_feed(stream, text + p, chunk) == FRE_ERROR)
+	  FRE_PERROR("fre_stream_feed");
+      }
+      if (fre_stream_finish(stream) == FRE_ERROR)
+	FRE_PERROR("fre_stream_finish");
+      mode = ((fre_patstream*)stream)->scan.mode;
+      fre_stream_free(stream);
+      for (i = 0, line = 0, max_line = 0; i < text_len; i++){
+	line = ((text[i] == '\n') ? 0 : line + 1);
+	if (line > max_line)
+	  max_line = line;
+      }
+      if ((mode == FRE_SCAN_WINDOW && text_len > window / 2)
+	  || (mode == FRE_SCAN_BY_LINE && max_line + 2 >= window && longest + 2 >= window / 2)){
+	numof_skipped++;
+	continue;
+      }
+      numof_runs++;
+      if (found.numof_matches != numof_ref || !same_matches(found.matches, ref, numof_ref)){
+	snprintf(what, sizeof(what), "stream window %zu mode %d with %zu matches, the whole text %zu",
+		 window, (int)mode, found.numof_matches, numof_ref);
+	diff_report("stream", pattern, text, text_len, what);
+      }
+    }
+    fre_free(handle);
+  }
+
+  if ((handle = fre_compile("m/([^[:space:]])+(a)+\\b/g")) == NULL){
+    FRE_PERROR("fre_compile");
+    return;
+  }
+  text_len = MAX_TEXT - MAX_TEXT % 3;
+  for (i = 0; i < text_len; i++)
+    text[i] = "abc"[i % 3];
+  for (i = 0; i < sizeof(windows) / sizeof(windows[0]); i++){
+    found.numof_matches = 0;
+    if ((stream = fre_stream_new(handle, windows[i], found_match, &found)) == NULL){
+      FRE_PERROR("fre_stream_new");
+      break;
+    }
+    for (p = 0; p < text_len; p += 7)
+      fre_stream_feed(stream, text + p, ((text_len - p < 7) ? text_len - p : 7));
+    fre_stream_finish(stream);
+    fre_stream_free(stream);
+    if (found.numof_matches > 0){
+      snprintf(what, sizeof(what), "stream window %zu with %zu matches at [%lld,%lld], the whole text none",
+	       windows[i], found.numof_matches, (long long)found.matches[0].bo, (long long)found.matches[0].eo);
+      diff_report("stream", "m/([^[:space:]])+(a)+\\b/g", text, text_len, what);
+    }
+  }
+  fre_free(handle);
+  printf("stream: %zu texts, %zu left out\n", numof_runs, numof_skipped);
+}
+
+
+/* fre_grep_lines(), fre_grep_lines_cb() and fre_grep_count() against matching each line alone. */
+static void check_grep(size_t iterations)
+{
+  size_t it = 0, text_len = 0, numof_ref = 0, numof_selected = 0, count = 0, p = 0, end = 0, number = 0;
+  size_t i = 0, numof_runs = 0;
+  int t = 0, invert = 0, ret = 0, cb_ret = 0, count_ret = 0, matched = 0;
+  bool asserts = false;
+  char pattern[MAX_ERE * 3], ere[MAX_ERE * 3], what[160];
+  const char *newline = NULL;
+  static char text[MAX_TEXT];
+  static fre_line ref[MAX_TEXT + 2], lines[MAX_TEXT + 2];
+  fre_regex *handle = NULL;
+  fre_pattern *freg_object = NULL;
+  fre_smatch match;
+
+  for (it = 0; it < iterations; it++){
+    if (!gen_pattern(pattern, ere, true, &asserts) || (handle = fre_compile(pattern)) == NULL)
+      continue;
+    freg_object = handle;
+    for (t = 0; t < 6; t++){
+      text_len = (size_t)rand() % 1500;
+      gen_text(text, text_len, ((t & 1) ? 8 : 40), "abcAx. 5_");
+      if (t == 4 && text_len > 0)
+	text[text_len - 1] = '\n';
+      for (invert = 0; invert < 2; invert++){
+	numof_runs++;
+	for (p = 0, number = 1, numof_ref = 0; p < text_len; p = end + 1, number++){
+	  newline = memchr(text + p, '\n', text_len - p);
+	  end = ((newline != NULL) ? (size_t)(newline - text) : text_len);
+	  matched = intern__fre__exec_match(freg_object, text + p, end - p, 0, &match, 1);
+	  if ((matched == FRE_OP_SUCCESSFUL) != invert){
+	    ref[numof_ref].offset = (fre_off)p;
+	    ref[numof_ref].length = (fre_off)(end - p);
+	    ref[numof_ref++].number = number;
+	  }
+	}
+	ret = fre_grep_lines(handle, text, text_len, ((invert) ? FRE_GREP_INVERT : 0), lines, MAX_TEXT + 2, &numof_selected);
+	found.numof_lines = 0;
+	cb_ret = fre_grep_lines_cb(handle, text, text_len, ((invert) ? FRE_GREP_INVERT : 0), found_line, &found);
+	count_ret = fre_grep_count(handle, text, text_len, ((invert) ? FRE_GREP_INVERT : 0), &count);
+	matched = (ret == ((numof_ref > 0) ? FRE_OP_SUCCESSFUL : FRE_OP_UNSUCCESSFUL) && cb_ret == ret && count_ret == ret
+		   && numof_selected == numof_ref && found.numof_lines == numof_ref && count == numof_ref);
+	for (i = 0; matched && i < numof_ref; i++)
+	  if (lines[i].offset != ref[i].offset || lines[i].length != ref[i].length || lines[i].number != ref[i].number
+	      || memcmp(&found.lines[i], &lines[i], sizeof(fre_line)) != 0)
+	    matched = 0;
+	if (!matched){
+	  snprintf(what, sizeof(what), "invert %d, %zu lines selected, %zu handed over, %zu counted, %zu matching alone",
+		   invert, numof_selected, found.numof_lines, count, numof_ref);
+	  diff_report("grep", pattern, text, text_len, what);
+	}
+      }
+    }
+    fre_free(handle);
+  }
+  printf("grep: %zu texts\n", numof_runs);
+}
+
+
+static double bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/*
+ * The forward scan of the DFA of each pattern over the same 16 MB text, from one match
+ * to the next, by the interpreter and by the native code, the best of three runs each.
+ */
+static int bench_jit(char **patterns,
+		     size_t numof_patterns)
+{
+  size_t i = 0, start = 0;
+  int k = 0, rep = 0, r = 0;
+  double best[2], t = 0;
+  unsigned char *text = NULL;
+  fre_regex *handle = NULL;
+  fre_pattern *freg_object = NULL;
+  fre_jit_code *jit = NULL;
+  fre_bitpar *bitpar = NULL;
+  fre_smatch match;
+
+  if ((text = malloc(BENCH_LEN + 1)) == NULL){
+    perror("malloc");
+    return -1;
+  }
+  srand(5);
+  for (i = 0; i < BENCH_LEN; i++){
+    r = rand() % 100;
+    text[i] = ((r < 60) ? 'a' + rand() % 26 : (r < 75) ? ' ' : (r < 90) ? '0' + rand() % 10
+	       : (r < 95) ? 'A' + rand() % 26 : "\n.,;:-_/()"[rand() % 10]);
+  }
+  text[BENCH_LEN] = '\0';
+  for (i = 0; i < numof_patterns; i++){
+    if ((handle = fre_compile(patterns[i])) == NULL){
+      FRE_PERROR("fre_compile");
+      continue;
+    }
+    freg_object = handle;
+    if (freg_object->engine != FRE_ENGINE_DFA || fre_jit(handle, 1) != FRE_OP_SUCCESSFUL){
+      printf("%-28s no native code\n", patterns[i]);
+      fre_free(handle);
+      continue;
+    }
+    /* The DFA's scan itself, not the Glushkov automaton's. */
+    bitpar = freg_object->bitpar;
+    freg_object->bitpar = NULL;
+    jit = freg_object->jit;
+    best[0] = best[1] = 1e9;
+    for (rep = 0; rep < 3; rep++)
+      for (k = 0; k < 2; k++){
+	freg_object->jit = ((k == 0) ? NULL : jit);
+	t = bench_now();
+	for (start = 0; start < BENCH_LEN; start = (size_t)match.eo + (match.eo == match.bo))
+	  if (intern__fre__dfa_exec(freg_object, text, BENCH_LEN, start, &match) != FRE_OP_SUCCESSFUL)
+	    break;
+	if ((t = bench_now() - t) < best[k])
+	  best[k] = t;
+      }
+    freg_object->jit = jit;
+    freg_object->bitpar = bitpar;
+    printf("%-28s interpreter %.2f ns/B  native code %.2f ns/B\n", patterns[i],
+	   best[0] * 1e9 / BENCH_LEN, best[1] * 1e9 / BENCH_LEN);
+    fre_free(handle);
+  }
+  free(text);
+  return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+  size_t iterations = DEF_ITERATIONS;
+  unsigned int seed = DEF_SEED;
+
+  if (argc > 1 && strcmp(argv[1], "-b") == 0){
+    if (argc > 2)
+      return bench_jit(argv + 2, (size_t)(argc - 2));
+    return bench_jit((char**)bench_patterns, sizeof(bench_patterns) / sizeof(bench_patterns[0]));
+  }
+  if (argc > 3 || (argc > 1 && (iterations = strtoul(argv[1], NULL, 10)) == 0)){
+    usage(argv[0]);
+    return -1;
+  }
+  if (argc > 2)
+    seed = (unsigned int)strtoul(argv[2], NULL, 10);
+
+  srand(seed);
+  check_engines(iterations);
+  check_jit(iterations);
+  check_file(iterations);
+  check_stream(iterations);
+  check_grep(iterations);
+  printf("%zu differences, seed %u\n", numof_diffs, seed);
+
+  return ((numof_diffs > 0) ? 1 : 0);
+}
@@ -0,0 +1,151 @@
+/*
+ * Engine selection: the patterns given to the substring search and to
+ * Aho-Corasick, and those that aren't, and what they match, sub-match 1
+ * too, against regcomp()/regexec() with REG_STARTEND at every start offset
+ * of texts with overlapping candidates.
+ * It looks at the engines, local to libfre.so, it's built from the sources,
+ * see compile_test_PUBLIC.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+
+#include <fre.h>
+#include "fre_internal.h" /* Engines. */
+
+#define DEF_SEED 1
+#define MAX_SM 2
+#define MAX_TEXT 80
+#define NUMOF_TEXTS 200
+
+/* A pattern and the engine it should run on. */
+typedef struct engine_case_tab {
+  char                 *pattern;
+  fre_engine_f          engine;
+} engine_case;
+
+static const engine_case cases[] = {
+  /* Plain literals, escaped special characters, \Q..\E, and case-folded ones. */
+  { "m/abc/",                     FRE_ENGINE_LITERAL },
+  { "m/abc/g",                    FRE_ENGINE_LITERAL },
+  { "m/a\\.b/",                   FRE_ENGINE_LITERAL },
+  { "m/\\Qa.b\\E/",               FRE_ENGINE_LITERAL },
+  { "m/a\\|b/",                   FRE_ENGINE_LITERAL },
+  { "m/a b/",                     FRE_ENGINE_LITERAL },
+  { "m/abab/",                    FRE_ENGINE_LITERAL },
+  { "m/aab/",                     FRE_ENGINE_LITERAL },
+  { "m/abc/i",                    FRE_ENGINE_LITERAL },
+  { "m/ABC/i",                    FRE_ENGINE_LITERAL },
+  { "m/b/",                       FRE_ENGINE_LITERAL },
+  /* Anything else isn't. */
+  { "m/a.c/",                     FRE_ENGINE_DFA },
+  { "m/^abc/",                    FRE_ENGINE_DFA },
+  { "m/abc$/",                    FRE_ENGINE_DFA },
+  { "m/ab*/",                     FRE_ENGINE_DFA },
+  { "m/a(b)c/",                   FRE_ENGINE_DFA },
+  { "m/[a]bc/",                   FRE_ENGINE_DFA },
+  { "m/(a)\\1/",                  FRE_ENGINE_BACKTRACK },
+  /* Alternations of literals, overlapping prefixes and suffixes, leftmost-longest, the group spanning them. */
+  { "m/ab|abc|b/",                FRE_ENGINE_AC },
+  { "m/b|abc|ab/",                FRE_ENGINE_AC },
+  { "m/a|ab|abc|bc|c/",           FRE_ENGINE_AC },
+  { "m/(ab|abc|b)/",              FRE_ENGINE_AC },
+  { "m/(ab)/",                    FRE_ENGINE_AC },
+  { "m/ab|abc|b/i",               FRE_ENGINE_AC },
+  { "m/aB|Abc|x/i",               FRE_ENGINE_AC },
+  { "m/foo|bar|baz/g",            FRE_ENGINE_AC },
+  /* And those that aren't. */
+  { "m/(ab)|c/",                  FRE_ENGINE_DFA },
+  { "m/ab||c/",                   FRE_ENGINE_DFA },
+  { "m/ab|a.c/",                  FRE_ENGINE_DFA },
+  { "m/(ab|abc|b)c/",             FRE_ENGINE_DFA },
+  { "m/^ab|abc/",                 FRE_ENGINE_DFA },
+};
+
+static size_t numof_failures = 0;
+
+/* The pattern's engine, once it's compiled: clones are the first time they're bound. */
+static fre_engine_f engine_of(fre_regex *handle)
+{
+  char string[] = "";
+
+  fre_exec(handle, string, sizeof(string));
+  return ((fre_pattern*)handle)->engine;
+}
+
+/* Whether its engine finds what regexec() does at every start offset of text. */
+static void check_matches(const char *pattern,
+			  fre_pattern *freg_object,
+			  regex_t *re,
+			  const char *text,
+			  size_t text_len)
+{
+  size_t start = 0, k = 0, nsm = ((freg_object->numof_groups + 1 < MAX_SM) ? freg_object->numof_groups + 1 : MAX_SM);
+  int ret = 0, fre_ret = 0;
+  fre_smatch fm[MAX_SM];
+  regmatch_t rm[MAX_SM];
+
+  for (start = 0; start <= text_len; start++){
+    rm[0].rm_so = (regoff_t)start;
+    rm[0].rm_eo = (regoff_t)text_len;
+    ret = regexec(re, text, nsm, rm, REG_STARTEND);
+    fre_ret = intern__fre__exec_match(freg_object, (char*)text, text_len, start, fm, nsm);
+    for (k = 0; ret == 0 && fre_ret == FRE_OP_SUCCESSFUL && k < nsm; k++)
+      if (rm[k].rm_so != fm[k].bo || rm[k].rm_eo != fm[k].eo)
+	break;
+    if (fre_ret != ((ret == 0) ? FRE_OP_SUCCESSFUL : FRE_OP_UNSUCCESSFUL) || (ret == 0 && k < nsm)){
+      printf("FAIL %s on \"%.*s\" from %zu: %d [%lld,%lld], regexec() %d [%d,%d]\n", pattern, (int)text_len, text,
+	     start, fre_ret, (long long)fm[0].bo, (long long)fm[0].eo, ret, (int)rm[0].rm_so, (int)rm[0].rm_eo);
+      numof_failures++;
+      return;
+    }
+  }
+}
+
+int main(void)
+{
+  size_t i = 0, t = 0, k = 0, text_len = 0, numof_texts = 0;
+  fre_engine_f engine;
+  char text[MAX_TEXT + 1];
+  const char *alphabet = "abcABx. |";
+  fre_regex *handle = NULL;
+  fre_pattern *freg_object = NULL;
+  regex_t re;
+
+  srand(DEF_SEED);
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+    if ((handle = fre_compile(cases[i].pattern)) == NULL){
+      printf("FAIL fre_compile() of %s\n", cases[i].pattern);
+      numof_failures++;
+      continue;
+    }
+    freg_object = handle;
+    if ((engine = engine_of(handle)) != cases[i].engine){
+      printf("FAIL %s runs on engine %d, expected %d\n", cases[i].pattern, (int)engine, (int)cases[i].engine);
+      numof_failures++;
+    }
+    if (freg_object->engine == FRE_ENGINE_BACKTRACK
+	|| regcomp(&re, freg_object->striped_pattern[0], REG_EXTENDED | REG_NEWLINE
+		   | ((freg_object->fre_mod_icase) ? REG_ICASE : 0)) != 0){
+      fre_free(handle);
+      continue;
+    }
+    /* Random texts, as long as the kernels' 16 bytes and then some, most with candidates overlapping. */
+    for (t = 0; t < NUMOF_TEXTS; t++){
+      text_len = (size_t)rand() % MAX_TEXT;
+      for (k = 0; k < text_len; k++)
+	text[k] = alphabet[rand() % ((t % 2 == 0) ? 3 : (int)strlen(alphabet))];
+      text[text_len] = '\0';
+      check_matches(cases[i].pattern, freg_object, &re, text, text_len);
+      numof_texts++;
+    }
+    regfree(&re);
+    fre_free(handle);
+  }
+  printf("engine: %zu patterns, %zu texts, %zu failures\n", sizeof(cases) / sizeof(cases[0]), numof_texts,
+	 numof_failures);
+
+  return ((numof_failures > 0) ? 1 : 0);
+}
@@ -0,0 +1,145 @@
+/*
+ * Matchers generated by fre-gen: what they find, at every start offset of
+ * random texts, against the library running the same patterns, and the
+ * arguments fre-gen refuses without writing anything.
+ * The matchers are in test_GEN_matchers.c, and the library's own matching
+ * is local to libfre.so, it's built from the sources, see compile_test_PUBLIC.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fre.h>
+#include "fre_internal.h" /* exec_match(). */
+#include "test_GEN_matchers.c"
+
+#define DEF_SEED 1
+#define MAX_TEXT 80
+#define NUMOF_TEXTS 300
+
+/* A generated matcher and its pattern. */
+typedef struct gen_case_tab {
+  int                  (*match)(const char*, size_t, size_t, size_t*, size_t*);
+  const char           *pattern;
+} gen_case;
+
+static const gen_case cases[] = {
+  { g_literal,   g_literal_pattern },
+  { g_alt,       g_alt_pattern },
+  { g_star,      g_star_pattern },
+  { g_anchors,   g_anchors_pattern },
+  { g_word,      g_word_pattern },
+  { g_icase,     g_icase_pattern },
+  { g_dot,       g_dot_pattern },
+  { g_multi,     g_multi_pattern },
+  { g_repeat,    g_repeat_pattern },
+  { g_empty,     g_empty_pattern },
+};
+
+/* Arguments fre-gen should refuse: names it can't use, or clashing, patterns it can't generate. */
+static const char *refused[] = {
+  "x 'm/a/' x 'm/b/'",
+  "x 'm/a/' x_fwd_trans 'm/b/'",
+  "x_pattern 'm/a/' x 'm/b/'",
+  "1x 'm/a/'",
+  "x 'm/a/' y 'm/(a)\\1/'",
+  "x 'm/a/' y 's/a/b/'",
+  "x 'm/a/' y 'b'",
+};
+
+static size_t numof_failures = 0;
+
+/* The generated matcher against exec_match() at every start offset of text. */
+static void check_matches(const gen_case *c,
+			  fre_pattern *freg_object,
+			  const char *text,
+			  size_t text_len)
+{
+  size_t start = 0, bo = 0, eo = 0;
+  int ret = 0, fre_ret = 0;
+  fre_smatch fm;
+
+  for (start = 0; start <= text_len; start++){
+    bo = eo = 0;
+    ret = c->match(text, text_len, start, &bo, &eo);
+    fre_ret = intern__fre__exec_match(freg_object, (char*)text, text_len, start, &fm, 1);
+    if (ret != fre_ret || (ret == 1 && ((fre_off)bo != fm.bo || (fre_off)eo != fm.eo))){
+      printf("FAIL %s on \"%.*s\" from %zu: %d [%zu,%zu], the library %d [%lld,%lld]\n", c->pattern,
+	     (int)text_len, text, start, ret, bo, eo, fre_ret, (long long)fm.bo, (long long)fm.eo);
+      numof_failures++;
+      return;
+    }
+  }
+}
+
+/* Nothing written, not even to a file given with -o, and a non-zero exit. */
+static void check_refused(void)
+{
+  size_t i = 0;
+  int status = 0;
+  char command[256];
+  FILE *out = NULL;
+
+  for (i = 0; i < sizeof(refused) / sizeof(refused[0]); i++){
+    remove("test_GEN_refused.c");
+    snprintf(command, sizeof(command), "./fre-gen -o test_GEN_refused.c %s 2>/dev/null", refused[i]);
+    status = system(command);
+    if (status == 0 || (out = fopen("test_GEN_refused.c", "r")) != NULL){
+      printf("FAIL fre-gen %s: exit status %d%s\n", refused[i], status, ((out != NULL) ? ", a file written" : ""));
+      numof_failures++;
+      if (out != NULL)
+	fclose(out);
+      out = NULL;
+    }
+    snprintf(command, sizeof(command), "./fre-gen %s 2>/dev/null", refused[i]);
+    if ((out = popen(command, "r")) == NULL){
+      perror("popen");
+      numof_failures++;
+      continue;
+    }
+    if (fgetc(out) != EOF){
+      printf("FAIL fre-gen %s: something printed\n", refused[i]);
+      numof_failures++;
+    }
+    if ((status = pclose(out)) == 0){
+      printf("FAIL fre-gen %s: exit status 0\n", refused[i]);
+      numof_failures++;
+    }
+    out = NULL;
+  }
+}
+
+int main(void)
+{
+  size_t i = 0, t = 0, k = 0, text_len = 0, numof_texts = 0;
+  char text[MAX_TEXT + 1];
+  const char *alphabet = "abcdABx_ \n";
+  fre_regex *handle = NULL;
+
+  srand(DEF_SEED);
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+    if ((handle = fre_compile((char*)cases[i].pattern)) == NULL){
+      printf("FAIL fre_compile() of %s\n", cases[i].pattern);
+      numof_failures++;
+      continue;
+    }
+    /* Compiled the first time it's bound. */
+    text[0] = '\0';
+    fre_exec(handle, text, 1);
+    for (t = 0; t < NUMOF_TEXTS; t++){
+      text_len = (size_t)rand() % MAX_TEXT;
+      for (k = 0; k < text_len; k++)
+	text[k] = alphabet[rand() % ((t % 2 == 0) ? 4 : (int)strlen(alphabet))];
+      text[text_len] = '\0';
+      check_matches(&cases[i], handle, text, text_len);
+      numof_texts++;
+    }
+    fre_free(handle);
+  }
+  check_refused();
+  printf("gen: %zu matchers, %zu texts, %zu refused, %zu failures\n", sizeof(cases) / sizeof(cases[0]),
+	 numof_texts, sizeof(refused) / sizeof(refused[0]), numof_failures);
+
+  return ((numof_failures > 0) ? 1 : 0);
+}
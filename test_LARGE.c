@@ -0,0 +1,253 @@
+/*
+ * Matches past 2^31: a string of more than 2GiB mapped over the zero page,
+ * and a sparse file as large, with a few words written past 2^31, found
+ * by the substring search, Aho-Corasick, the DFA and the Pike VM's
+ * sub-matches, over the string, as a set, and with fre_match_file().
+ * Built with FRE_COMPACT_OFFSETS the words are written right under 2^31
+ * instead, and anything longer is refused with EOVERFLOW.
+ * It reads the pmatch-table for where the matches are, local to libfre.so,
+ * it's built from the sources, both ways, see compile_test_PUBLIC.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <fre.h>
+#include "fre_internal.h" /* The pmatch-table. */
+
+#ifdef FRE_COMPACT_OFFSETS
+# define BASE ((size_t)FRE_OFF_MAX - 8192)   /* Right under what the offsets hold. */
+#else
+# define BASE ((size_t)1 << 31)
+#endif
+#define TEXT_LEN (BASE + 4096)
+#define MAP_LEN (((size_t)1 << 31) + 8192)   /* Room for FRE_OFF_MAX bytes either way. */
+#define MAX_MATCHES 2
+
+/* A pattern and where its matches begin and end, counted from BASE. */
+typedef struct large_case_tab {
+  char                 *pattern;
+  size_t                numof_matches;
+  long long             matches[2 * MAX_MATCHES];
+  long long             sub_match[2];     /* Group 1 of the first match, or { 0, 0 } without groups. */
+} large_case;
+
+/* Words written around BASE, the first across it, zero bytes everywhere else. */
+static const struct { long long at; const char *word; } words[] = {
+  { -2, "foo" }, { 100, "xaby" }, { 2000, "bar" }, { 3000, "needle" },
+};
+
+static const large_case cases[] = {
+  { "m/needle/",                  1, { 3000, 3006 },              { 0, 0 } },
+  { "m/foo|bar/g",                2, { -2, 1, 2000, 2003 },       { 0, 0 } },
+  { "m/x(a)by/",                  1, { 100, 104 },                { 101, 102 } },
+};
+
+static size_t numof_failures = 0;
+
+/* Matches handed over by fre_match_file(). */
+typedef struct found_tab {
+  size_t                numof_matches;
+  fre_off               matches[2 * MAX_MATCHES];
+} found;
+
+static int collect(fre_off bo,
+		   fre_off eo,
+		   void *arg)
+{
+  found *f = arg;
+
+  if (f->numof_matches < MAX_MATCHES){
+    f->matches[2 * f->numof_matches] = bo;
+    f->matches[2 * f->numof_matches + 1] = eo;
+  }
+  f->numof_matches++;
+  return 0;
+}
+
+/* Whether the numof_matches found at offsets are those of c. */
+static void check_found(const large_case *c,
+			const char *how,
+			size_t numof_matches,
+			const fre_off *offsets)
+{
+  size_t k = 0;
+
+  for (k = 0; numof_matches == c->numof_matches && k < 2 * numof_matches; k++)
+    if ((long long)offsets[k] != (long long)BASE + c->matches[k])
+      break;
+  if (numof_matches != c->numof_matches || k < 2 * numof_matches){
+    printf("FAIL %s %s: %zu matches, the first [%lld,%lld], expected %zu [%lld,%lld]\n", how, c->pattern,
+	   numof_matches, ((numof_matches > 0) ? (long long)offsets[0] : -1LL),
+	   ((numof_matches > 0) ? (long long)offsets[1] : -1LL), c->numof_matches,
+	   (long long)BASE + c->matches[0], (long long)BASE + c->matches[1]);
+    numof_failures++;
+  }
+}
+
+/* fre_exec_n() over the string, the matches read from the pmatch-table. */
+static void check_string(char *string)
+{
+  size_t i = 0, k = 0;
+  int retval = 0;
+  fre_off offsets[2 * MAX_MATCHES];
+  fre_smatch *sm = NULL;
+  fre_regex *handle = NULL;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+    if ((handle = fre_compile(cases[i].pattern)) == NULL){
+      printf("FAIL fre_compile() of %s\n", cases[i].pattern);
+      numof_failures++;
+      continue;
+    }
+    if ((retval = fre_exec_n(handle, string, TEXT_LEN, TEXT_LEN)) != 1){
+      printf("FAIL fre_exec_n() %s over %zu bytes: %d, errno %d\n", cases[i].pattern, TEXT_LEN, retval, errno);
+      numof_failures++;
+      fre_free(handle);
+      continue;
+    }
+    for (k = 0; k < fre_pmatch_table->wm_ind && k < MAX_MATCHES; k++){
+      offsets[2 * k] = fre_pmatch_table->whole_match[k].bo;
+      offsets[2 * k + 1] = fre_pmatch_table->whole_match[k].eo;
+    }
+    check_found(&cases[i], "fre_exec_n()", fre_pmatch_table->wm_ind, offsets);
+    sm = fre_pmatch_table->sub_match;
+    if (cases[i].sub_match[1] > 0
+	&& ((long long)sm[0].bo != (long long)BASE + cases[i].sub_match[0]
+	    || (long long)sm[0].eo != (long long)BASE + cases[i].sub_match[1])){
+      printf("FAIL fre_exec_n() %s: group 1 [%lld,%lld]\n", cases[i].pattern, (long long)sm[0].bo, (long long)sm[0].eo);
+      numof_failures++;
+    }
+    fre_free(handle);
+  }
+}
+
+/* The same patterns as a set, where each one's first match is. */
+static void check_set(char *string)
+{
+  size_t i = 0, k = 0;
+  int retval = 0;
+  char *patterns[sizeof(cases) / sizeof(cases[0])];
+  size_t ids[sizeof(cases) / sizeof(cases[0])];
+  fre_off offsets[2 * sizeof(cases) / sizeof(cases[0])];
+  fre_set *set = NULL;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    patterns[i] = cases[i].pattern;
+  if ((set = fre_set_compile(patterns, i)) == NULL){
+    printf("FAIL fre_set_compile()\n");
+    numof_failures++;
+    return;
+  }
+  if ((retval = fre_set_exec_n(set, string, TEXT_LEN, ids, offsets)) != (int)i){
+    printf("FAIL fre_set_exec_n() over %zu bytes: %d, errno %d\n", TEXT_LEN, retval, errno);
+    numof_failures++;
+  }
+  for (k = 0; retval > 0 && k < (size_t)retval; k++)
+    if ((long long)offsets[2 * k] != (long long)BASE + cases[ids[k]].matches[0]
+	|| (long long)offsets[2 * k + 1] != (long long)BASE + cases[ids[k]].matches[1]){
+      printf("FAIL fre_set_exec_n() %s: [%lld,%lld]\n", cases[ids[k]].pattern, (long long)offsets[2 * k],
+	     (long long)offsets[2 * k + 1]);
+      numof_failures++;
+    }
+  fre_set_free(set);
+}
+
+/* fre_match_file() over a sparse file holding the same bytes. */
+static void check_file(const char *path)
+{
+  size_t i = 0;
+  int retval = 0;
+  found f;
+  fre_regex *handle = NULL;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+    if ((handle = fre_compile(cases[i].pattern)) == NULL)
+      continue;
+    memset(&f, 0, sizeof(f));
+    if ((retval = fre_match_file(handle, path, collect, &f)) != 1){
+      printf("FAIL fre_match_file() %s: %d, errno %d\n", cases[i].pattern, retval, errno);
+      numof_failures++;
+    }
+    else
+      check_found(&cases[i], "fre_match_file()", f.numof_matches, f.matches);
+    fre_free(handle);
+  }
+}
+
+#ifdef FRE_COMPACT_OFFSETS
+/* Strings and files of FRE_OFF_MAX bytes or more are refused. */
+static void check_overflow(char *string,
+			   int fd,
+			   const char *path)
+{
+  size_t ids[1];
+  char *pattern = "m/needle/";
+  fre_regex *handle = fre_compile(pattern);
+  fre_set *set = fre_set_compile(&pattern, 1);
+  found f;
+
+  errno = 0;
+  if (fre_exec_n(handle, string, (size_t)FRE_OFF_MAX, (size_t)FRE_OFF_MAX) != -1 || errno != EOVERFLOW){
+    printf("FAIL fre_exec_n() over %zu bytes: errno %d, expected EOVERFLOW\n", (size_t)FRE_OFF_MAX, errno);
+    numof_failures++;
+  }
+  errno = 0;
+  if (fre_set_exec_n(set, string, (size_t)FRE_OFF_MAX, ids, NULL) != -1 || errno != EOVERFLOW){
+    printf("FAIL fre_set_exec_n() over %zu bytes: errno %d, expected EOVERFLOW\n", (size_t)FRE_OFF_MAX, errno);
+    numof_failures++;
+  }
+  errno = 0;
+  if (ftruncate(fd, (off_t)FRE_OFF_MAX) != 0
+      || fre_match_file(handle, path, collect, &f) != -1 || errno != EOVERFLOW){
+    printf("FAIL fre_match_file() over %zu bytes: errno %d, expected EOVERFLOW\n", (size_t)FRE_OFF_MAX, errno);
+    numof_failures++;
+  }
+  fre_set_free(set);
+  fre_free(handle);
+}
+#endif
+
+int main(void)
+{
+  size_t i = 0;
+  int fd = -1;
+  char path[] = "/tmp/test_LARGE.XXXXXX";
+  char *string = NULL;
+
+  /* Never written but for the words, the rest reads as the zero page. */
+  if ((string = mmap(NULL, MAP_LEN, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+		     -1, 0)) == MAP_FAILED){
+    perror("mmap");
+    return -1;
+  }
+  if ((fd = mkstemp(path)) == -1 || ftruncate(fd, (off_t)TEXT_LEN) != 0){
+    perror(path);
+    return -1;
+  }
+  for (i = 0; i < sizeof(words) / sizeof(words[0]); i++){
+    memcpy(string + BASE + words[i].at, words[i].word, strlen(words[i].word));
+    if (pwrite(fd, words[i].word, strlen(words[i].word), (off_t)(BASE + words[i].at)) != (ssize_t)strlen(words[i].word)){
+      perror(path);
+      numof_failures++;
+    }
+  }
+
+  check_string(string);
+  check_set(string);
+  check_file(path);
+#ifdef FRE_COMPACT_OFFSETS
+  check_overflow(string, fd, path);
+#endif
+  close(fd);
+  unlink(path);
+  munmap(string, MAP_LEN);
+  printf("large: %zu patterns over %zu bytes, %zu failures\n", sizeof(cases) / sizeof(cases[0]), TEXT_LEN,
+	 numof_failures);
+
+  return ((numof_failures > 0) ? 1 : 0);
+}
@@ -0,0 +1,249 @@
+/*
+ * Pattern sets, fre_set_exec(): which patterns match and where, for a few
+ * known sets, and for random sets of a pool of patterns against binding
+ * each alone, fre_exec() for whether it matches and a stream for where,
+ * and a list of words too long for an alternation, as a set.
+ * It only calls libfre's public interface, see compile_test_PUBLIC.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fre.h>
+
+#define DEF_ITERATIONS 500
+#define DEF_SEED 1
+#define MAX_SET 8
+#define MAX_TEXT 200
+#define NUMOF_WORDS 200
+
+/* A set, a string, and the patterns it should find there with their offsets. */
+typedef struct set_case_tab {
+  char                 *patterns[MAX_SET];   /* Up to the first NULL. */
+  const char           *string;
+  size_t                ids[MAX_SET];
+  fre_off               offsets[2 * MAX_SET];
+  int                   retval;
+} set_case;
+
+static const set_case cases[] = {
+  { { "m/foo/", "m/bar/", "m/baz/", NULL }, "xx bar foo",
+    { 0, 1 }, { 7, 10, 3, 6 }, 2 },
+  { { "m/foo/", "m/bar/", NULL }, "nothing here",
+    { 0 }, { 0 }, 0 },
+  /* Leftmost-longest, not the first to end. */
+  { { "m/a+/", "m/ab|abc/", "m/b/", NULL }, "xaaabc",
+    { 0, 1, 2 }, { 1, 4, 3, 6, 4, 5 }, 3 },
+  /* Modifiers, anchors, and what the combined DFA leaves to each pattern alone. */
+  { { "m/HELLO/i", "m/^x/", "m/c$/", "m/\\bab\\b/", "m/z/", NULL }, "x hello ab c",
+    { 0, 1, 2, 3 }, { 2, 7, 0, 1, 11, 12, 8, 10 }, 4 },
+  { { "m/a.b/", "m/a.b/s", NULL }, "a\nb",
+    { 1 }, { 0, 3 }, 1 },
+  /* The empty match. */
+  { { "m/x*/", "m/y/", NULL }, "abc",
+    { 0 }, { 0, 0 }, 1 },
+};
+
+/* The pool random sets are drawn from. */
+static char *pool[] = { "m/foo/", "m/ba[rz]/", "m/[0-9]+/", "m/o+/i", "m/x|yz/", "m/^a/", "m/c$/",
+			"m/\\bfoo\\b/", "m/(ab)*c/", "m/a.c/s", "m/a{2,3}/", "m/[[:space:]]+/", "m/F[^o]/i",
+			"m/z?$/", "m/(a|b)(c|d)/", "m/(foo|fo)+x/" };
+
+static size_t numof_failures = 0;
+
+void usage(char *name)
+{
+  fprintf(stderr, "\nUsage:  %s [iterations] [seed]\n\n", name);
+}
+
+/* Where the first match of handle begins and ends, as a stream hands it over. */
+static int first_match(fre_off bo,
+		       fre_off eo,
+		       void *arg)
+{
+  fre_off *offsets = arg;
+
+  offsets[0] = bo;
+  offsets[1] = eo;
+  return 1;
+}
+
+/* The known sets. */
+static void check_cases(void)
+{
+  size_t i = 0, k = 0, numof_patterns = 0;
+  int retval = 0;
+  size_t ids[MAX_SET];
+  fre_off offsets[2 * MAX_SET];
+  char string[MAX_TEXT + 1];
+  fre_set *set = NULL;
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+    for (numof_patterns = 0; numof_patterns < MAX_SET && cases[i].patterns[numof_patterns] != NULL; numof_patterns++);
+    if ((set = fre_set_compile((char**)cases[i].patterns, numof_patterns)) == NULL){
+      printf("FAIL case %zu: fre_set_compile()\n", i);
+      numof_failures++;
+      continue;
+    }
+    strcpy(string, cases[i].string);
+    retval = fre_set_exec(set, string, sizeof(string), ids, offsets);
+    for (k = 0; retval == cases[i].retval && k < (size_t)retval; k++)
+      if (ids[k] != cases[i].ids[k] || offsets[2 * k] != cases[i].offsets[2 * k]
+	  || offsets[2 * k + 1] != cases[i].offsets[2 * k + 1])
+	break;
+    if (retval != cases[i].retval || k < (size_t)retval){
+      printf("FAIL case %zu on \"%s\": %d patterns, expected %d", i, cases[i].string, retval, cases[i].retval);
+      for (k = 0; k < (size_t)retval; k++)
+	printf("%s%zu [%lld,%lld]", ((k == 0) ? ": " : ", "), ids[k], (long long)offsets[2 * k],
+	       (long long)offsets[2 * k + 1]);
+      printf("\n");
+      numof_failures++;
+    }
+    /* Without offsets, the same patterns. */
+    retval = fre_set_exec(set, string, sizeof(string), ids, NULL);
+    for (k = 0; retval == cases[i].retval && k < (size_t)retval; k++)
+      if (ids[k] != cases[i].ids[k])
+	break;
+    if (retval != cases[i].retval || k < (size_t)retval){
+      printf("FAIL case %zu on \"%s\" without offsets: %d patterns, expected %d\n", i, cases[i].string,
+	     retval, cases[i].retval);
+      numof_failures++;
+    }
+    fre_set_free(set);
+  }
+}
+
+/* Random sets against each of their patterns bound alone. */
+static void check_random(size_t iterations)
+{
+  size_t it = 0, i = 0, k = 0, numof_patterns = 0, numof_ids = 0, text_len = 0, numof_texts = 0;
+  int retval = 0, t = 0;
+  char *patterns[MAX_SET];
+  size_t ids[MAX_SET], ids_only[MAX_SET];
+  fre_off offsets[2 * MAX_SET], ref[2];
+  char string[MAX_TEXT + 1], copy[MAX_TEXT + 1];
+  const char *alphabet = "abcdfoxyzFO019 \n";
+  fre_regex *handles[MAX_SET];
+  fre_stream *stream = NULL;
+  fre_set *set = NULL;
+
+  for (it = 0; it < iterations; it++){
+    numof_patterns = 1 + (size_t)rand() % MAX_SET;
+    for (i = 0; i < numof_patterns; i++){
+      patterns[i] = pool[rand() % (sizeof(pool) / sizeof(pool[0]))];
+      handles[i] = fre_compile(patterns[i]);
+    }
+    if ((set = fre_set_compile(patterns, numof_patterns)) == NULL){
+      printf("FAIL fre_set_compile() of %zu patterns\n", numof_patterns);
+      numof_failures++;
+      goto next;
+    }
+    for (t = 0; t < 10; t++){
+      text_len = (size_t)rand() % MAX_TEXT;
+      for (i = 0; i < text_len; i++)
+	string[i] = alphabet[rand() % strlen(alphabet)];
+      string[text_len] = '\0';
+      numof_texts++;
+      retval = fre_set_exec(set, string, sizeof(string), ids, offsets);
+      if (fre_set_exec(set, string, sizeof(string), ids_only, NULL) != retval
+	  || (retval > 0 && memcmp(ids, ids_only, (size_t)retval * sizeof(size_t)) != 0)){
+	printf("FAIL \"%s\": other patterns without offsets\n", string);
+	numof_failures++;
+      }
+      for (i = 0, numof_ids = 0; i < numof_patterns; i++){
+	memcpy(copy, string, text_len + 1);
+	if (fre_exec(handles[i], copy, sizeof(copy)) != 1)
+	  continue;
+	ref[0] = ref[1] = -1;
+	if ((stream = fre_stream_new(handles[i], 0, first_match, ref)) != NULL){
+	  fre_stream_feed(stream, string, text_len);
+	  fre_stream_finish(stream);
+	  fre_stream_free(stream);
+	}
+	k = numof_ids++;
+	if (retval < 0 || k >= (size_t)retval || ids[k] != i || offsets[2 * k] != ref[0] || offsets[2 * k + 1] != ref[1]){
+	  printf("FAIL %s on \"%s\": [%lld,%lld] alone, not found so in the set\n", patterns[i], string,
+		 (long long)ref[0], (long long)ref[1]);
+	  numof_failures++;
+	  break;
+	}
+      }
+      if (i == numof_patterns && (size_t)retval != numof_ids){
+	printf("FAIL \"%s\": %d patterns of the set, %zu alone\n", string, retval, numof_ids);
+	numof_failures++;
+      }
+    }
+    fre_set_free(set);
+  next:
+    for (i = 0; i < numof_patterns; i++)
+      fre_free(handles[i]);
+  }
+  printf("set: %zu cases, %zu random texts, %zu failures\n", sizeof(cases) / sizeof(cases[0]),
+	 numof_texts, numof_failures);
+}
+
+/* Too long for one pattern, the words of a blocklist, one per pattern. */
+static void check_words(void)
+{
+  size_t i = 0, len = 0;
+  int retval = 0;
+  char *words[NUMOF_WORDS];
+  char alternation[NUMOF_WORDS * 16];
+  char string[] = "nothing, word0007zz, word0199zz, word0200zz";
+  size_t ids[NUMOF_WORDS];
+  fre_off offsets[2 * NUMOF_WORDS];
+  fre_set *set = NULL;
+
+  len = (size_t)sprintf(alternation, "m/");
+  for (i = 0; i < NUMOF_WORDS; i++){
+    if ((words[i] = malloc(16)) == NULL){
+      perror("malloc");
+      numof_failures++;
+      goto cleanup;
+    }
+    sprintf(words[i], "m/word%04zuzz/", i);
+    len += (size_t)sprintf(alternation + len, "%sword%04zuzz", ((i > 0) ? "|" : ""), i);
+  }
+  sprintf(alternation + len, "/");
+  if (fre_compile(alternation) != NULL){
+    printf("FAIL an alternation of %d words, %zu bytes, compiled\n", NUMOF_WORDS, len + 1);
+    numof_failures++;
+  }
+  if ((set = fre_set_compile(words, NUMOF_WORDS)) == NULL){
+    printf("FAIL fre_set_compile() of %d words\n", NUMOF_WORDS);
+    numof_failures++;
+    goto cleanup;
+  }
+  retval = fre_set_exec(set, string, sizeof(string), ids, offsets);
+  if (retval != 2 || ids[0] != 7 || offsets[0] != 9 || offsets[1] != 19
+      || ids[1] != 199 || offsets[2] != 21 || offsets[3] != 31){
+    printf("FAIL %d words of %d found, expected 2\n", retval, NUMOF_WORDS);
+    numof_failures++;
+  }
+  fre_set_free(set);
+
+ cleanup:
+  while (i > 0)
+    free(words[--i]);
+}
+
+int main(int argc, char **argv)
+{
+  size_t iterations = DEF_ITERATIONS;
+  unsigned int seed = DEF_SEED;
+
+  if (argc > 3 || (argc > 1 && (iterations = strtoul(argv[1], NULL, 10)) == 0)){
+    usage(argv[0]);
+    return -1;
+  }
+  if (argc > 2)
+    seed = (unsigned int)strtoul(argv[2], NULL, 10);
+
+  srand(seed);
+  check_cases();
+  check_words();
+  check_random(iterations);
+
+  return ((numof_failures > 0) ? 1 : 0);
+}
@@ -0,0 +1,79 @@
+/*
+ * Substitutions, s///: sub-match references, escapes, and results
+ * emptier or longer than the string they replace, up to string_size.
+ * It only calls libfre's public interface, see compile_test_PUBLIC.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fre.h>
+
+#define STRING_SIZE 64
+
+/* A substitution and the string it should leave. */
+typedef struct subst_case_tab {
+  char                 *pattern;
+  const char           *input;
+  size_t                string_size;  /* 0 for STRING_SIZE. */
+  int                   retval;
+  const char           *output;       /* What the string holds afterwards, even on failure. */
+} subst_case;
+
+static const subst_case cases[] = {
+  /* $N and \N. */
+  { "s/(a)(b)/$2$1/g",            "abab",        0, 1, "baba" },
+  { "s/(a)(b)/\\2\\1/g",          "abab",        0, 1, "baba" },
+  { "s/(\\w+) (\\w+)/$2 $1/",     "hello world", 0, 1, "world hello" },
+  { "s/(a)/${1}1/",               "a",           0, 1, "a1" },
+  { "s/b/[$&]/",                  "abc",         0, 1, "a[b]c" },
+  { "s/b/[$0]/",                  "abc",         0, 1, "a[b]c" },
+  { "s/(x)?b/[$1]/",              "abc",         0, 1, "a[]c" },
+  { "s/((((((((((a))))))))))/$10$10/", "ba",     0, 1, "baa" },
+  /* Escaped $ and \. */
+  { "s/a/\\$/g",                  "aXa",         0, 1, "$X$" },
+  { "s/a/\\$1/g",                 "aXa",         0, 1, "$1X$1" },
+  { "s/b/\\\\/g",                 "abcb",        0, 1, "a\\c\\" },
+  /* Empty output. */
+  { "s/.*//",                     "hello",       0, 1, "" },
+  { "s/a//g",                     "aaaa",        0, 1, "" },
+  { "s/a//",                      "aaaa",        0, 1, "aaa" },
+  /* Longer than the input, up to string_size with its NUL byte. */
+  { "s/a/xyz/g",                  "aaaa",        0, 1, "xyzxyzxyzxyz" },
+  { "s/a/xyz/g",                  "aaaa",       13, 1, "xyzxyzxyzxyz" },
+  { "s/a/xyz/g",                  "aaaa",       12, -1, "aaaa" },
+  { "s/(.)/$1$1/g",               "abc",         0, 1, "aabbcc" },
+  { "s/^/>> /",                   "abc",         0, 1, ">> abc" },
+  { "s/$/!/",                     "abc",         0, 1, "abc!" },
+  /* \w and \W take digits and '_' for word characters, as \b does. */
+  { "s/\\w+/<$&>/g",              "a1 b_2 -3",   0, 1, "<a1> <b_2> -<3>" },
+  { "s/\\W/./g",                  "a1 b_2 -3",   0, 1, "a1.b_2..3" },
+  { "s/\\b\\w/^/g",               "a1 2b",       0, 1, "^1 ^b" },
+  /* Nothing to replace. */
+  { "s/x/y/",                     "abc",         0, 0, "abc" },
+  { "s/o/0/gi",                   "fOo",         0, 1, "f00" },
+};
+
+int main(void)
+{
+  size_t i = 0, numof_failures = 0, size = 0;
+  int retval = 0;
+  char string[STRING_SIZE];
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+    size = ((cases[i].string_size > 0) ? cases[i].string_size : STRING_SIZE);
+    memset(string, 0, sizeof(string));
+    strcpy(string, cases[i].input);
+    retval = fre_bind(cases[i].pattern, string, size);
+    if (retval != cases[i].retval || strcmp(string, cases[i].output) != 0
+	|| (retval == 1 && fre_result_len() != strlen(cases[i].output))){
+      printf("FAIL %s on \"%s\", size %zu: %d \"%s\" lenght %zu, expected %d \"%s\"\n", cases[i].pattern,
+	     cases[i].input, size, retval, string, fre_result_len(), cases[i].retval, cases[i].output);
+      numof_failures++;
+    }
+  }
+  printf("subst: %zu cases, %zu failures\n", sizeof(cases) / sizeof(cases[0]), numof_failures);
+
+  return ((numof_failures > 0) ? 1 : 0);
+}
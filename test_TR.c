@@ -0,0 +1,161 @@
+/*
+ * Transliterations, tr///: ranges and the byte map they compile to, over
+ * strings shorter than the kernels' 16 bytes and of lenghts that leave
+ * a tail, against the same map applied a byte at a time, the /c /d /s /r
+ * modifiers, and the bytes fre_tr_count() finds, counting only too.
+ * It only calls libfre's public interface, see compile_test_PUBLIC.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fre.h>
+
+#define STRING_SIZE 128
+#define MAX_LEN 80
+#define DEF_SEED 1
+
+/* A transliteration and the string it should leave. */
+typedef struct tr_case_tab {
+  char                 *pattern;
+  const char           *input;
+  const char           *output;
+} tr_case;
+
+/* One with modifiers, the string it should leave, or build with /r, and its count. */
+typedef struct tr_mod_case_tab {
+  char                 *pattern;
+  const char           *input;
+  const char           *output;
+  const char           *result;       /* fre_tr_result(), NULL without /r. */
+  size_t                count;
+} tr_mod_case;
+
+static const tr_case cases[] = {
+  { "tr/a-z/A-Z/",                "hello, World",  "HELLO, WORLD" },
+  { "tr/A-Za-z/a-zA-Z/",          "Hello, World",  "hELLO, wORLD" },
+  { "tr/a-y/b-z/",                "abc xyz",       "bcd yzz" },
+  { "tr/0-9/#/",                  "a1b22c333",     "a#b##c###" },
+  { "tr/\\d/#/",                  "a1b22c333",     "a#b##c###" },
+  { "tr/a-c/x/",                  "abcabd",        "xxxxxd" },
+  { "tr/abc/cab/",                "aabbcc",        "ccaabb" },
+  /* A leading or trailing '-' is literal, the first of a repeated byte wins. */
+  { "tr/-a/+b/",                  "a-a",           "b+b" },
+  { "tr/a-/b+/",                  "a-a",           "b+b" },
+  { "tr/aa/xy/",                  "aa",            "xx" },
+  /* Nothing in the search list. */
+  { "tr/x/y/",                    "abc",           "abc" },
+  { "tr/a/b/",                    "",              "" },
+};
+
+static const tr_mod_case mod_cases[] = {
+  /* Counting only, Perl's tr/a-z//. */
+  { "tr/a-z//",                   "hello World",   "hello World",   NULL,      9 },
+  { "tr/a-z//c",                  "hello World",   "hello World",   NULL,      2 },
+  { "tr/a-z/A-Z/",                "hello, World",  "HELLO, WORLD",  NULL,      9 },
+  /* /c complements the search list, a short replacement list is padded with its last byte. */
+  { "tr/a-z/_/c",                 "hello World!",  "hello__orld_",  NULL,      3 },
+  { "tr/a-c/x/",                  "abcabd",        "xxxxxd",        NULL,      5 },
+  /* /d deletes what the replacement list has no byte for. */
+  { "tr/a-c/xy/d",                "abcabd",        "xyxyd",         NULL,      5 },
+  { "tr/a-c//d",                  "abcabd",        "d",             NULL,      5 },
+  { "tr/a-zA-Z//cd",              "a1b2 c3",       "abc",           NULL,      4 },
+  /* /s squeezes runs of the same transliterated byte. */
+  { "tr/a-z//s",                  "aabbccdd  ee",  "abcd  e",       NULL,     10 },
+  { "tr/a-z/A-Z/s",               "aabbccdd  ee",  "ABCD  E",       NULL,     10 },
+  { "tr/a-z/x/s",                 "ab cd",         "x x",           NULL,      4 },
+  /* /r leaves the string alone. */
+  { "tr/a-z/A-Z/r",               "hello",         "hello",         "HELLO",   5 },
+  { "tr/a-c/A-C/sr",              "aabbccx",       "aabbccx",       "ABCx",    6 },
+  { "tr/a-c//dr",                 "abcabd",        "abcabd",        "d",       5 },
+};
+
+/* Patterns run over random strings, the bytes past 0x7f raw, and the map they compile to, a byte at a time. */
+static char *map_patterns[] = { "tr/a-z/A-Z/", "tr/a-y/b-z/", "tr/\200-\377/h/", "tr/0-9a-f/#/" };
+/* Their search lists, counting only. */
+static char *count_patterns[] = { "tr/a-z//", "tr/a-y//", "tr/\200-\377//", "tr/0-9a-f//" };
+
+static unsigned char map_byte(size_t pattern,
+			      unsigned char byte)
+{
+  switch (pattern){
+  case 0:
+    return ((byte >= 'a' && byte <= 'z') ? byte - 'a' + 'A' : byte);
+  case 1:
+    return ((byte >= 'a' && byte <= 'y') ? byte + 1 : byte);
+  case 2:
+    return ((byte >= 0x80) ? 'h' : byte);
+  default:
+    return (((byte >= '0' && byte <= '9') || (byte >= 'a' && byte <= 'f')) ? '#' : byte);
+  }
+}
+
+
+int main(void)
+{
+  size_t i = 0, k = 0, len = 0, count = 0, numof_failures = 0, numof_runs = 0;
+  int retval = 0;
+  char string[STRING_SIZE], expected[STRING_SIZE], original[STRING_SIZE];
+  char *result = NULL;
+
+  for (i = 0; i < sizeof(mod_cases) / sizeof(mod_cases[0]); i++){
+    memset(string, 0, sizeof(string));
+    strcpy(string, mod_cases[i].input);
+    retval = fre_bind(mod_cases[i].pattern, string, sizeof(string));
+    result = fre_tr_result();
+    if (retval == -1 || strcmp(string, mod_cases[i].output) != 0 || fre_tr_count() != mod_cases[i].count
+	|| (mod_cases[i].result == NULL) != (result == NULL)
+	|| (result != NULL && strcmp(result, mod_cases[i].result) != 0)){
+      printf("FAIL %s on \"%s\": %d \"%s\" /r \"%s\" count %zu, expected \"%s\" /r \"%s\" count %zu\n",
+	     mod_cases[i].pattern, mod_cases[i].input, retval, string, ((result != NULL) ? result : "(none)"),
+	     fre_tr_count(), mod_cases[i].output, ((mod_cases[i].result != NULL) ? mod_cases[i].result : "(none)"),
+	     mod_cases[i].count);
+      numof_failures++;
+    }
+  }
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+    memset(string, 0, sizeof(string));
+    strcpy(string, cases[i].input);
+    retval = fre_bind(cases[i].pattern, string, sizeof(string));
+    if (retval == -1 || strcmp(string, cases[i].output) != 0){
+      printf("FAIL %s on \"%s\": %d \"%s\", expected \"%s\"\n", cases[i].pattern,
+	     cases[i].input, retval, string, cases[i].output);
+      numof_failures++;
+    }
+  }
+
+  srand(DEF_SEED);
+  for (k = 0; k < sizeof(map_patterns) / sizeof(map_patterns[0]); k++)
+    for (len = 0; len <= MAX_LEN; len++){
+      /* Every byte of their search lists is changed, the count is that of the bytes changed. */
+      for (i = 0, count = 0; i < len; i++){
+	string[i] = (char)((rand() % 2) ? 'a' + rand() % 26 : 1 + rand() % 255);
+	expected[i] = (char)map_byte(k, (unsigned char)string[i]);
+	count += (expected[i] != string[i]);
+      }
+      string[len] = expected[len] = '\0';
+      memcpy(original, string, len + 1);
+      numof_runs++;
+      if ((retval = fre_bind(map_patterns[k], string, sizeof(string))) == -1
+	  || memcmp(string, expected, len + 1) != 0 || fre_tr_count() != count){
+	printf("FAIL %s over %zu random bytes: %d, count %zu, expected %zu\n", map_patterns[k], len, retval,
+	       fre_tr_count(), count);
+	numof_failures++;
+      }
+      /* Counting only, the same bytes, the string left as it is. */
+      memcpy(string, original, len + 1);
+      numof_runs++;
+      if ((retval = fre_bind(count_patterns[k], string, sizeof(string))) == -1
+	  || memcmp(string, original, len + 1) != 0 || fre_tr_count() != count){
+	printf("FAIL %s over %zu random bytes: %d, count %zu, expected %zu\n", count_patterns[k], len, retval,
+	       fre_tr_count(), count);
+	numof_failures++;
+      }
+    }
+  printf("tr: %zu cases, %zu random strings, %zu failures\n",
+	 sizeof(cases) / sizeof(cases[0]) + sizeof(mod_cases) / sizeof(mod_cases[0]), numof_runs, numof_failures);
+
+  return ((numof_failures > 0) ? 1 : 0);
+}